@@ -0,0 +1,70 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <gio/gio.h>
+#include <gio/gunixfdlist.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:activation-gate
+ * @title: Activation Gate
+ * @short_description: Bounds how many providers are activated at once
+ *
+ * Calling a method on a provider whose bus name has no owner makes the
+ * bus activate it. Knowledge apps are fairly heavy, so activating all
+ * of them at once when the feed is opened thrashes memory and I/O on
+ * low-end machines, and every provider ends up being slow to reply.
+ *
+ * activation_gate_call() makes the call straight away if the bus name
+ * of the proxy already has an owner. Otherwise the call is queued until
+ * fewer than the maximum number of bus names are being activated. This
+ * is 2 by default and can be changed with the
+ * `CONTENT_FEED_MAX_CONCURRENT_ACTIVATIONS` environment variable, where
+ * 0 means no limit. Once a bus name is admitted, all of the calls queued
+ * for it are made together, and it keeps its place until all of them
+ * have completed. Calls still waiting in the queue can be dropped with
+ * activation_gate_drop_queued_calls() once their results are no longer
+ * wanted.
+ *
+ * Calls are always made so that the provider can pass file descriptors
+ * back with the reply, which activation_gate_call_with_unix_fd_list_finish()
+ * returns.
+ */
+void activation_gate_call (GDBusProxy          *proxy,
+                           const gchar         *method_name,
+                           GVariant            *parameters,
+                           gint                 timeout_msec,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data);
+
+GVariant * activation_gate_call_finish (GDBusProxy    *proxy,
+                                        GAsyncResult  *result,
+                                        GError       **error);
+
+GVariant * activation_gate_call_with_unix_fd_list_finish (GDBusProxy    *proxy,
+                                                          GUnixFDList  **out_fd_list,
+                                                          GAsyncResult  *result,
+                                                          GError       **error);
+
+gint64 activation_gate_call_get_dispatch_time (GAsyncResult *result);
+
+void activation_gate_drop_queued_calls (GCancellable *cancellable);
+
+G_END_DECLS
@@ -0,0 +1,596 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <gio/gio.h>
+
+#include "feed-activation-gate-private.h"
+
+#define DEFAULT_MAX_CONCURRENT_ACTIVATIONS 2
+
+typedef struct _ActivationGateCallData
+{
+  gchar       *method_name;
+  GVariant    *parameters;
+  gint         timeout_msec;
+
+  /* The monotonic time that the call was made, or 0 if it never left
+   * the queue */
+  gint64       dispatch_time;
+
+  /* Only set if the call went through the gate */
+  gchar       *bus_name;
+
+  /* The thread-default main context of the caller, which a queued
+   * call is made on once its bus name is admitted, so that it
+   * completes wherever the caller is iterating */
+  GMainContext *context;
+
+  /* Only set while the call is queued */
+  gulong       cancelled_id;
+
+  /* Any file descriptors that came with the reply */
+  GUnixFDList *out_fd_list;
+} ActivationGateCallData;
+
+static ActivationGateCallData *
+activation_gate_call_data_new (const gchar *method_name,
+                               GVariant    *parameters,
+                               gint         timeout_msec)
+{
+  ActivationGateCallData *data = g_new0 (ActivationGateCallData, 1);
+
+  data->method_name = g_strdup (method_name);
+  data->parameters = parameters != NULL ? g_variant_ref_sink (parameters) : NULL;
+  data->timeout_msec = timeout_msec;
+  data->context = g_main_context_ref_thread_default ();
+
+  return data;
+}
+
+static void
+activation_gate_call_data_free (ActivationGateCallData *data)
+{
+  g_clear_pointer (&data->method_name, g_free);
+  g_clear_pointer (&data->parameters, g_variant_unref);
+  g_clear_pointer (&data->bus_name, g_free);
+  g_clear_pointer (&data->context, g_main_context_unref);
+  g_clear_object (&data->out_fd_list);
+
+  g_free (data);
+}
+
+typedef struct _ActivatingName
+{
+  /* Calls waiting for the name to be admitted, owning a GTask each */
+  GQueue   queued_tasks;
+  guint    n_calls_in_flight;
+  gboolean admitted;
+} ActivatingName;
+
+static ActivatingName *
+activating_name_new (void)
+{
+  ActivatingName *name = g_new0 (ActivatingName, 1);
+
+  g_queue_init (&name->queued_tasks);
+
+  return name;
+}
+
+static void
+activating_name_free (ActivatingName *name)
+{
+  g_queue_clear_full (&name->queued_tasks, g_object_unref);
+
+  g_free (name);
+}
+
+/* Protects everything below */
+static GMutex activation_gate_lock;
+
+/* Bus names with calls that went through the gate, either waiting to
+ * be admitted or admitted and not done yet */
+static GHashTable *activating_names = NULL;
+
+/* Bus names waiting to be admitted, in order. The strings are owned by
+ * activating_names. */
+static GQueue waiting_names = G_QUEUE_INIT;
+
+static guint n_admitted_names = 0;
+
+static GHashTable *
+ensure_activating_names (void)
+{
+  if (activating_names == NULL)
+    activating_names = g_hash_table_new_full (g_str_hash,
+                                              g_str_equal,
+                                              g_free,
+                                              (GDestroyNotify) activating_name_free);
+
+  return activating_names;
+}
+
+static guint
+max_concurrent_activations (void)
+{
+  static gsize initialized = 0;
+  static guint max_activations = DEFAULT_MAX_CONCURRENT_ACTIVATIONS;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const gchar *max_activations_env = g_getenv ("CONTENT_FEED_MAX_CONCURRENT_ACTIVATIONS");
+      guint64 value = 0;
+
+      if (max_activations_env != NULL)
+        {
+          if (g_ascii_string_to_unsigned (max_activations_env, 10, 0, G_MAXUINT, &value, NULL))
+            max_activations = (guint) value;
+          else
+            g_message ("Ignoring invalid CONTENT_FEED_MAX_CONCURRENT_ACTIVATIONS value %s",
+                       max_activations_env);
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return max_activations;
+}
+
+static void on_activation_gate_call_completed (GObject      *source,
+                                               GAsyncResult *result,
+                                               gpointer      user_data);
+
+/* Must not be called with activation_gate_lock held */
+static void
+dispatch_call (GTask *task)
+{
+  GDBusProxy *proxy = g_task_get_source_object (task);
+  ActivationGateCallData *data = g_task_get_task_data (task);
+
+  /* The call is no longer queued, so cancelling it is up to the
+   * D-Bus call from here on */
+  g_cancellable_disconnect (g_task_get_cancellable (task), data->cancelled_id);
+  data->cancelled_id = 0;
+
+  data->dispatch_time = g_get_monotonic_time ();
+
+  g_dbus_proxy_call_with_unix_fd_list (proxy,
+                                       data->method_name,
+                                       data->parameters,
+                                       G_DBUS_CALL_FLAGS_NONE,
+                                       data->timeout_msec,
+                                       NULL,
+                                       g_task_get_cancellable (task),
+                                       on_activation_gate_call_completed,
+                                       task);
+}
+
+static gboolean
+dispatch_admitted_call_in_context (gpointer user_data)
+{
+  GTask *task = user_data;
+  ActivationGateCallData *data = g_task_get_task_data (task);
+
+  g_main_context_push_thread_default (data->context);
+  dispatch_call (task);
+  g_main_context_pop_thread_default (data->context);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Makes each of the calls in @admitted_tasks, which owns a GTask each,
+ * on the main context of the caller that queued it. Must not be called
+ * with activation_gate_lock held. */
+static void
+dispatch_admitted_calls (GQueue *admitted_tasks)
+{
+  GTask *task = NULL;
+
+  while ((task = g_queue_pop_head (admitted_tasks)) != NULL)
+    {
+      ActivationGateCallData *data = g_task_get_task_data (task);
+
+      g_main_context_invoke (data->context,
+                             dispatch_admitted_call_in_context,
+                             task);
+    }
+}
+
+/* Must be called with activation_gate_lock held. The calls that were
+ * queued for @name are moved to @admitted_tasks. */
+static void
+admit_name (ActivatingName *name,
+            GQueue         *admitted_tasks)
+{
+  GTask *task = NULL;
+
+  name->admitted = TRUE;
+  ++n_admitted_names;
+
+  while ((task = g_queue_pop_head (&name->queued_tasks)) != NULL)
+    {
+      ++name->n_calls_in_flight;
+      g_queue_push_tail (admitted_tasks, task);
+    }
+}
+
+/* Must be called with activation_gate_lock held */
+static void
+admit_waiting_names (GQueue *admitted_tasks)
+{
+  guint max_activations = max_concurrent_activations ();
+
+  while (!g_queue_is_empty (&waiting_names) &&
+         (max_activations == 0 || n_admitted_names < max_activations))
+    {
+      const gchar *bus_name = g_queue_pop_head (&waiting_names);
+
+      admit_name (g_hash_table_lookup (activating_names, bus_name),
+                  admitted_tasks);
+    }
+}
+
+static void
+release_call (const gchar *bus_name)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&activation_gate_lock);
+  ActivatingName *name = g_hash_table_lookup (activating_names, bus_name);
+  GQueue admitted_tasks = G_QUEUE_INIT;
+
+  if (--name->n_calls_in_flight > 0)
+    return;
+
+  /* Everything that was queued for this name has now completed, so
+   * let the next one in */
+  g_hash_table_remove (activating_names, bus_name);
+  --n_admitted_names;
+
+  admit_waiting_names (&admitted_tasks);
+
+  g_clear_pointer (&locker, g_mutex_locker_free);
+  dispatch_admitted_calls (&admitted_tasks);
+}
+
+/* Must be called with activation_gate_lock held, after taking a call
+ * out of the queue for @bus_name */
+static void
+forget_name_if_unused (const gchar    *bus_name,
+                       ActivatingName *name)
+{
+  GList *link = NULL;
+
+  if (name->admitted || !g_queue_is_empty (&name->queued_tasks))
+    return;
+
+  /* A name that nothing is waiting for any more should not hold up
+   * the names behind it, nor be activated at all */
+  link = g_queue_find_custom (&waiting_names, bus_name, (GCompareFunc) g_strcmp0);
+  g_queue_delete_link (&waiting_names, link);
+  g_hash_table_remove (activating_names, bus_name);
+}
+
+/* Must not be called with activation_gate_lock held. Takes the
+ * reference to @task that the queue held. */
+static void
+return_dropped_call (GTask *task)
+{
+  ActivationGateCallData *data = g_task_get_task_data (task);
+
+  g_cancellable_disconnect (g_task_get_cancellable (task), data->cancelled_id);
+  data->cancelled_id = 0;
+
+  g_task_return_new_error (task,
+                           G_IO_ERROR,
+                           G_IO_ERROR_CANCELLED,
+                           "Call to %s was cancelled before %s was activated",
+                           data->method_name,
+                           data->bus_name);
+  g_object_unref (task);
+}
+
+static gboolean
+cancel_queued_call (gpointer user_data)
+{
+  GTask *task = user_data;
+  ActivationGateCallData *data = g_task_get_task_data (task);
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&activation_gate_lock);
+  ActivatingName *name = g_hash_table_lookup (activating_names, data->bus_name);
+
+  /* If the call was admitted in the meantime, it has been made with
+   * the same cancellable, so the D-Bus call returns the error. If it
+   * was dropped, it has already returned. */
+  if (name == NULL || !g_queue_remove (&name->queued_tasks, task))
+    return G_SOURCE_REMOVE;
+
+  forget_name_if_unused (data->bus_name, name);
+
+  g_clear_pointer (&locker, g_mutex_locker_free);
+  return_dropped_call (task);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* This can run in any thread, possibly with activation_gate_lock held
+ * if the cancellable was already cancelled when the call was queued,
+ * so the call is taken out of the queue from the caller's main context
+ * instead */
+static void
+on_queued_call_cancelled (GCancellable *cancellable G_GNUC_UNUSED,
+                          gpointer      user_data)
+{
+  GTask *task = user_data;
+  ActivationGateCallData *data = g_task_get_task_data (task);
+  g_autoptr(GSource) source = g_idle_source_new ();
+
+  g_source_set_callback (source,
+                         cancel_queued_call,
+                         g_object_ref (task),
+                         g_object_unref);
+  g_source_attach (source, data->context);
+}
+
+static void
+on_activation_gate_call_completed (GObject      *source,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  ActivationGateCallData *data = g_task_get_task_data (task);
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GVariant) reply = g_dbus_proxy_call_with_unix_fd_list_finish (G_DBUS_PROXY (source),
+                                                                          &data->out_fd_list,
+                                                                          result,
+                                                                          &local_error);
+
+  if (data->bus_name != NULL)
+    release_call (data->bus_name);
+
+  if (reply == NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&local_error));
+      return;
+    }
+
+  g_task_return_pointer (task,
+                         g_steal_pointer (&reply),
+                         (GDestroyNotify) g_variant_unref);
+}
+
+/*
+ * activation_gate_call:
+ * @proxy: A #GDBusProxy
+ * @method_name: The name of the method to call
+ * @parameters: A #GVariant tuple with the parameters
+ * @timeout_msec: The timeout in milliseconds, or -1 for the default
+ * @cancellable: A #GCancellable
+ * @callback: A #GAsyncReadyCallback
+ * @user_data: Closure for @callback
+ *
+ * Like g_dbus_proxy_call(), but if the bus name of @proxy has no owner,
+ * waits for its turn to be activated. @timeout_msec only starts counting
+ * once the call is actually made. Cancelling @cancellable while the call
+ * is waiting takes it out of the queue, so the name is not activated for
+ * it. Either way, @callback is called on the thread-default main context
+ * of the caller.
+ */
+void
+activation_gate_call (GDBusProxy          *proxy,
+                      const gchar         *method_name,
+                      GVariant            *parameters,
+                      gint                 timeout_msec,
+                      GCancellable        *cancellable,
+                      GAsyncReadyCallback  callback,
+                      gpointer             user_data)
+{
+  g_autoptr(GTask) task = g_task_new (proxy, cancellable, callback, user_data);
+  ActivationGateCallData *data = activation_gate_call_data_new (method_name,
+                                                                parameters,
+                                                                timeout_msec);
+  const gchar *bus_name = g_dbus_proxy_get_name (proxy);
+  g_autofree gchar *name_owner = g_dbus_proxy_get_name_owner (proxy);
+  g_autoptr(GMutexLocker) locker = NULL;
+  ActivatingName *name = NULL;
+  GQueue admitted_tasks = G_QUEUE_INIT;
+
+  g_task_set_task_data (task, data, (GDestroyNotify) activation_gate_call_data_free);
+
+  /* Unique names and peer connections can never be activated */
+  if (bus_name == NULL || g_dbus_is_unique_name (bus_name))
+    {
+      dispatch_call (g_steal_pointer (&task));
+      return;
+    }
+
+  locker = g_mutex_locker_new (&activation_gate_lock);
+  name = g_hash_table_lookup (ensure_activating_names (), bus_name);
+
+  /* If the name is already running and we are not in the middle of
+   * activating it, there is nothing to wait for */
+  if (name == NULL && name_owner != NULL)
+    {
+      g_clear_pointer (&locker, g_mutex_locker_free);
+      dispatch_call (g_steal_pointer (&task));
+      return;
+    }
+
+  if (name == NULL)
+    {
+      gchar *owned_bus_name = g_strdup (bus_name);
+
+      name = activating_name_new ();
+      g_hash_table_insert (activating_names, owned_bus_name, name);
+      g_queue_push_tail (&waiting_names, owned_bus_name);
+      admit_waiting_names (&admitted_tasks);
+    }
+
+  data->bus_name = g_strdup (bus_name);
+
+  if (name->admitted)
+    {
+      ++name->n_calls_in_flight;
+      g_queue_push_tail (&admitted_tasks, g_steal_pointer (&task));
+    }
+  else
+    {
+      /* The queue holds the reference to the task. The handler does not
+       * need one of its own, since it is disconnected before the queue
+       * lets go of the task. */
+      if (cancellable != NULL)
+        data->cancelled_id = g_cancellable_connect (cancellable,
+                                                    G_CALLBACK (on_queued_call_cancelled),
+                                                    task,
+                                                    NULL);
+      g_queue_push_tail (&name->queued_tasks, g_steal_pointer (&task));
+    }
+
+  g_clear_pointer (&locker, g_mutex_locker_free);
+  dispatch_admitted_calls (&admitted_tasks);
+}
+
+/*
+ * activation_gate_call_finish:
+ * @proxy: A #GDBusProxy
+ * @result: A #GAsyncResult
+ * @error: A #GError
+ *
+ * Complete a call to activation_gate_call().
+ *
+ * Returns: The reply #GVariant or %NULL with @error set.
+ */
+GVariant *
+activation_gate_call_finish (GDBusProxy    *proxy,
+                             GAsyncResult  *result,
+                             GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, proxy), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/*
+ * activation_gate_call_with_unix_fd_list_finish:
+ * @proxy: A #GDBusProxy
+ * @out_fd_list: (out) (optional): Return location for a #GUnixFDList
+ * @result: A #GAsyncResult
+ * @error: A #GError
+ *
+ * Like activation_gate_call_finish(), but also returns any file
+ * descriptors that were passed along with the reply in @out_fd_list,
+ * which is set to %NULL if there were none.
+ *
+ * Returns: The reply #GVariant or %NULL with @error set.
+ */
+GVariant *
+activation_gate_call_with_unix_fd_list_finish (GDBusProxy    *proxy,
+                                               GUnixFDList  **out_fd_list,
+                                               GAsyncResult  *result,
+                                               GError       **error)
+{
+  ActivationGateCallData *data = NULL;
+  GVariant *reply = NULL;
+
+  g_return_val_if_fail (g_task_is_valid (result, proxy), NULL);
+
+  data = g_task_get_task_data (G_TASK (result));
+  reply = g_task_propagate_pointer (G_TASK (result), error);
+
+  if (out_fd_list != NULL)
+    *out_fd_list = reply != NULL ? g_steal_pointer (&data->out_fd_list) : NULL;
+
+  return reply;
+}
+
+/*
+ * activation_gate_call_get_dispatch_time:
+ * @result: A #GAsyncResult from activation_gate_call()
+ *
+ * Get the time that the call was actually made, after waiting for its
+ * turn in the gate, if it had to. Measuring from here leaves out the
+ * time spent waiting for other bus names to be activated.
+ *
+ * Returns: The monotonic time that the call was made, or 0 if it was
+ *          never made.
+ */
+gint64
+activation_gate_call_get_dispatch_time (GAsyncResult *result)
+{
+  ActivationGateCallData *data = NULL;
+
+  g_return_val_if_fail (G_IS_TASK (result), 0);
+
+  data = g_task_get_task_data (G_TASK (result));
+
+  return data->dispatch_time;
+}
+
+/*
+ * activation_gate_drop_queued_calls:
+ * @cancellable: The #GCancellable that the calls were made with
+ *
+ * Take all of the calls made with @cancellable which are still waiting
+ * for their bus name to be admitted out of the queue, and fail them
+ * with %G_IO_ERROR_CANCELLED, without cancelling the ones which have
+ * already been made. Bus names which are then no longer waited for are
+ * not activated.
+ */
+void
+activation_gate_drop_queued_calls (GCancellable *cancellable)
+{
+  g_autoptr(GMutexLocker) locker = NULL;
+  GQueue dropped_tasks = G_QUEUE_INIT;
+  GHashTableIter iter;
+  gpointer bus_name = NULL;
+  gpointer name_ptr = NULL;
+  GTask *task = NULL;
+
+  g_return_if_fail (G_IS_CANCELLABLE (cancellable));
+
+  locker = g_mutex_locker_new (&activation_gate_lock);
+
+  if (activating_names == NULL)
+    return;
+
+  g_hash_table_iter_init (&iter, activating_names);
+  while (g_hash_table_iter_next (&iter, &bus_name, &name_ptr))
+    {
+      ActivatingName *name = name_ptr;
+      GList *link = name->queued_tasks.head;
+
+      while (link != NULL)
+        {
+          GList *next = link->next;
+
+          if (g_task_get_cancellable (link->data) == cancellable)
+            {
+              g_queue_push_tail (&dropped_tasks, link->data);
+              g_queue_delete_link (&name->queued_tasks, link);
+            }
+
+          link = next;
+        }
+
+      if (!name->admitted && g_queue_is_empty (&name->queued_tasks))
+        {
+          g_queue_remove (&waiting_names, bus_name);
+          g_hash_table_iter_remove (&iter);
+        }
+    }
+
+  g_clear_pointer (&locker, g_mutex_locker_free);
+
+  while ((task = g_queue_pop_head (&dropped_tasks)) != NULL)
+    return_dropped_call (task);
+}
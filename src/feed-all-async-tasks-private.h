@@ -47,6 +47,12 @@ G_BEGIN_DECLS
  * to return on the next idle if there were no tasks to be done. Otherwise,
  * #AllTasksResultsClosure will wait indefinitely for a task to be added.
  *
+ * A deadline can be set with all_tasks_results_closure_set_deadline(). If
+ * some tasks have still not completed by then, the callback is invoked
+ * anyway. The #GAsyncResult for each late task is replaced by one which
+ * fails with %G_IO_ERROR_TIMED_OUT, and the real result is dropped when
+ * the task eventually completes.
+ *
  * Callers generally should not add more tasks to the closure once
  * all_tasks_results_maybe_return_now() has been called
  * as there is a potential for a race condition where the closure
@@ -122,6 +128,8 @@ typedef struct _IndividualTaskResultClosure IndividualTaskResultClosure;
 AllTasksResultsClosure * all_tasks_results_closure_new (GDestroyNotify      result_free_func,
                                                         GAsyncReadyCallback callback,
                                                         gpointer            user_data);
+void all_tasks_results_closure_set_deadline (AllTasksResultsClosure *closure,
+                                             guint                   deadline_msec);
 gboolean all_tasks_results_has_tasks_remaining (AllTasksResultsClosure *closure);
 void all_tasks_results_return_now (AllTasksResultsClosure *closure);
 
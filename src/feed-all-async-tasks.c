@@ -24,6 +24,8 @@ struct _AllTasksResultsClosure
   GPtrArray      *results;
   guint           remaining;
   GTask          *task;
+  GSource        *deadline_source;
+  gboolean        returned;
 };
 
 AllTasksResultsClosure *
@@ -46,6 +48,10 @@ all_tasks_results_closure_free (AllTasksResultsClosure *closure)
   g_clear_pointer (&closure->results, g_ptr_array_unref);
   g_clear_pointer (&closure->task, g_object_unref);
 
+  if (closure->deadline_source != NULL)
+    g_source_destroy (closure->deadline_source);
+  g_clear_pointer (&closure->deadline_source, g_source_unref);
+
   g_free (closure);
 }
 
@@ -59,17 +65,80 @@ all_tasks_results_closure_allocate_new_result_slot (AllTasksResultsClosure *clos
   return last_len;
 }
 
-void
-all_tasks_results_return_now (AllTasksResultsClosure *closure)
+static void
+all_tasks_results_return (AllTasksResultsClosure *closure)
 {
-  g_assert (closure->remaining == 0);
+  g_assert (!closure->returned);
+
+  closure->returned = TRUE;
+
+  if (closure->deadline_source != NULL)
+    g_source_destroy (closure->deadline_source);
+  g_clear_pointer (&closure->deadline_source, g_source_unref);
 
   /* This will call into the callback immediately, since results
    * are registered in a different main context iteration */
   g_task_return_pointer (closure->task,
                          g_steal_pointer (&closure->results),
                          (GDestroyNotify) g_ptr_array_unref);
-  all_tasks_results_closure_free (closure);
+
+  /* If we returned early, stay around until the late tasks have
+   * completed, since they still point at us */
+  if (closure->remaining == 0)
+    all_tasks_results_closure_free (closure);
+}
+
+void
+all_tasks_results_return_now (AllTasksResultsClosure *closure)
+{
+  g_assert (closure->remaining == 0);
+
+  all_tasks_results_return (closure);
+}
+
+static gboolean
+all_tasks_results_deadline_passed (gpointer user_data)
+{
+  AllTasksResultsClosure *closure = user_data;
+  guint i = 0;
+
+  /* Returning G_SOURCE_REMOVE destroys the source for us */
+  g_clear_pointer (&closure->deadline_source, g_source_unref);
+
+  for (; i < closure->results->len; ++i)
+    {
+      g_autoptr(GTask) timed_out_task = NULL;
+
+      if (g_ptr_array_index (closure->results, i) != NULL)
+        continue;
+
+      timed_out_task = g_task_new (NULL, NULL, NULL, NULL);
+      g_task_return_new_error (timed_out_task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_TIMED_OUT,
+                               "Task did not complete before the deadline");
+      g_ptr_array_index (closure->results, i) = g_steal_pointer (&timed_out_task);
+    }
+
+  all_tasks_results_return (closure);
+
+  return G_SOURCE_REMOVE;
+}
+
+void
+all_tasks_results_closure_set_deadline (AllTasksResultsClosure *closure,
+                                        guint                   deadline_msec)
+{
+  g_return_if_fail (!closure->returned);
+  g_return_if_fail (closure->deadline_source == NULL);
+
+  closure->deadline_source = g_timeout_source_new (deadline_msec);
+  g_source_set_callback (closure->deadline_source,
+                         all_tasks_results_deadline_passed,
+                         closure,
+                         NULL);
+  g_source_attach (closure->deadline_source,
+                   g_task_get_context (closure->task));
 }
 
 gboolean
@@ -85,10 +154,20 @@ all_tasks_results_register_result (AllTasksResultsClosure *closure,
 {
   g_return_if_fail (closure->remaining > 0);
 
+  /* Already returned at the deadline, this result is too late to be
+   * of any use */
+  if (closure->returned)
+    {
+      if (--closure->remaining == 0)
+        all_tasks_results_closure_free (closure);
+
+      return;
+    }
+
   g_ptr_array_index (closure->results, index) = g_object_ref (result);
 
   if (--closure->remaining == 0)
-    all_tasks_results_return_now (closure);
+    all_tasks_results_return (closure);
 }
 
 struct _IndividualTaskResultClosure
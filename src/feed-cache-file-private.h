@@ -0,0 +1,85 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:cache-file
+ * @title: Cache Files
+ * @short_description: Serialized state kept in the user cache directory
+ *
+ * Some state is worth keeping between runs, but can always be rebuilt
+ * if it goes missing. It is kept as serialized #GVariants in
+ * `$XDG_CACHE_HOME/libcontentfeed`. Loading maps the file into memory
+ * rather than reading it, so only the parts that are looked at are
+ * paged in. Saving replaces the file atomically, so readers never see
+ * a partially written cache, and mappings of the old file stay valid.
+ *
+ * Cache files are untrusted: they are loaded as non-trusted #GVariants
+ * of the expected type, so a corrupt file reads as default values
+ * rather than crashing.
+ */
+gchar * cache_file_get_path (const gchar *name);
+
+GVariant * cache_file_load_variant (const gchar        *name,
+                                    const GVariantType *type);
+
+gboolean cache_file_save_variant (const gchar  *name,
+                                  GVariant     *variant,
+                                  GError      **error);
+
+/* Returns the state to save, or %NULL to skip saving. Called on the
+ * cache file saver thread. */
+typedef GVariant * (*CacheFileSnapshotFunc) (void);
+
+/**
+ * CacheFileSaver:
+ * @name: The name of the cache file
+ * @snapshot_func: Function returning the state to save
+ * @delay_seconds: How long to wait after the first change before saving
+ *
+ * State that changes often is saved at most once every @delay_seconds,
+ * so that a burst of changes only rewrites the file once. Savers are
+ * statically allocated with CACHE_FILE_SAVER_INIT() and scheduled with
+ * cache_file_saver_schedule() whenever the state changes, from any
+ * thread.
+ *
+ * All saves happen on a single thread owned by the cache files, so
+ * they never depend on a main context being run, and two saves of the
+ * same file never overlap. The state is snapshotted just before it is
+ * saved, and any change made after that schedules another save.
+ */
+typedef struct _CacheFileSaver
+{
+  const gchar           *name;
+  CacheFileSnapshotFunc  snapshot_func;
+  guint                  delay_seconds;
+
+  /*< private >*/
+  gint64                 save_time;
+} CacheFileSaver;
+
+#define CACHE_FILE_SAVER_INIT(name, snapshot_func, delay_seconds) \
+  { (name), (snapshot_func), (delay_seconds), 0 }
+
+void cache_file_saver_schedule (CacheFileSaver *saver);
+
+G_END_DECLS
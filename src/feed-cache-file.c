@@ -0,0 +1,186 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include "feed-cache-file-private.h"
+
+gchar *
+cache_file_get_path (const gchar *name)
+{
+  return g_build_filename (g_get_user_cache_dir (), "libcontentfeed", name, NULL);
+}
+
+GVariant *
+cache_file_load_variant (const gchar        *name,
+                         const GVariantType *type)
+{
+  g_autofree gchar *path = cache_file_get_path (name);
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GMappedFile) mapped_file = g_mapped_file_new (path, FALSE, &local_error);
+  g_autoptr(GBytes) bytes = NULL;
+
+  if (mapped_file == NULL)
+    {
+      if (!g_error_matches (local_error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        g_message ("Could not load cache file %s: %s", path, local_error->message);
+
+      return NULL;
+    }
+
+  bytes = g_mapped_file_get_bytes (mapped_file);
+
+  return g_variant_ref_sink (g_variant_new_from_bytes (type, bytes, FALSE));
+}
+
+gboolean
+cache_file_save_variant (const gchar  *name,
+                         GVariant     *variant,
+                         GError      **error)
+{
+  g_autofree gchar *path = cache_file_get_path (name);
+  g_autofree gchar *dir = g_path_get_dirname (path);
+  g_autoptr(GBytes) bytes = NULL;
+
+  if (g_mkdir_with_parents (dir, 0755) != 0)
+    {
+      int errsv = errno;
+
+      g_set_error (error,
+                   G_IO_ERROR,
+                   g_io_error_from_errno (errsv),
+                   "Could not create cache directory %s: %s",
+                   dir,
+                   g_strerror (errsv));
+      return FALSE;
+    }
+
+  bytes = g_variant_get_data_as_bytes (variant);
+
+  return g_file_set_contents (path,
+                              g_bytes_get_data (bytes, NULL),
+                              g_bytes_get_size (bytes),
+                              error);
+}
+
+/* Protects everything below, and the save_time of every saver */
+static GMutex cache_file_savers_lock;
+static GCond cache_file_savers_cond;
+
+/* Savers with a save_time, in no particular order */
+static GPtrArray *scheduled_savers = NULL;
+static GThread *cache_file_saver_thread = NULL;
+
+/* Must be called with cache_file_savers_lock held. Waits until one of
+ * the scheduled savers is due and unschedules it. */
+static CacheFileSaver *
+wait_for_due_saver (void)
+{
+  for (;;)
+    {
+      CacheFileSaver *next_saver = NULL;
+      guint i = 0;
+
+      for (i = 0; i < scheduled_savers->len; ++i)
+        {
+          CacheFileSaver *saver = g_ptr_array_index (scheduled_savers, i);
+
+          if (next_saver == NULL || saver->save_time < next_saver->save_time)
+            next_saver = saver;
+        }
+
+      if (next_saver == NULL)
+        {
+          g_cond_wait (&cache_file_savers_cond, &cache_file_savers_lock);
+          continue;
+        }
+
+      /* Something else may have been scheduled sooner in the meantime,
+       * so look again either way */
+      if (next_saver->save_time > g_get_monotonic_time ())
+        {
+          g_cond_wait_until (&cache_file_savers_cond,
+                             &cache_file_savers_lock,
+                             next_saver->save_time);
+          continue;
+        }
+
+      g_ptr_array_remove_fast (scheduled_savers, next_saver);
+      next_saver->save_time = 0;
+
+      return next_saver;
+    }
+}
+
+static gpointer
+cache_file_saver_thread_func (gpointer user_data G_GNUC_UNUSED)
+{
+  for (;;)
+    {
+      CacheFileSaver *saver = NULL;
+      g_autoptr(GVariant) snapshot = NULL;
+      g_autoptr(GError) local_error = NULL;
+
+      g_mutex_lock (&cache_file_savers_lock);
+      saver = wait_for_due_saver ();
+      g_mutex_unlock (&cache_file_savers_lock);
+
+      snapshot = saver->snapshot_func ();
+
+      if (snapshot != NULL &&
+          !cache_file_save_variant (saver->name, snapshot, &local_error))
+        g_message ("Could not save cache file %s: %s",
+                   saver->name,
+                   local_error->message);
+    }
+
+  return NULL;
+}
+
+/*
+ * cache_file_saver_schedule:
+ * @saver: A #CacheFileSaver
+ *
+ * Save the state of @saver in @saver->delay_seconds, unless a save is
+ * already scheduled. May be called from any thread, including with
+ * locks held that the snapshot function takes.
+ */
+void
+cache_file_saver_schedule (CacheFileSaver *saver)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&cache_file_savers_lock);
+
+  if (saver->save_time != 0)
+    return;
+
+  saver->save_time = g_get_monotonic_time () + saver->delay_seconds * G_USEC_PER_SEC;
+
+  if (scheduled_savers == NULL)
+    scheduled_savers = g_ptr_array_new ();
+
+  g_ptr_array_add (scheduled_savers, saver);
+
+  if (cache_file_saver_thread == NULL)
+    cache_file_saver_thread = g_thread_new ("cache-file-saver",
+                                            cache_file_saver_thread_func,
+                                            NULL);
+
+  g_cond_signal (&cache_file_savers_cond);
+}
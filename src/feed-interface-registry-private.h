@@ -0,0 +1,124 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <gio/gio.h>
+
+#include "feed-base-card-store.h"
+#include "feed-card-layout-direction.h"
+#include "feed-knowledge-app-card-store.h"
+
+G_BEGIN_DECLS
+
+typedef ContentFeedKnowledgeAppCardStore * (*ContentFeedKnowledgeAppCardStoreFactoryFunc) (const gchar                    *title,
+                                                                                           const gchar                    *uri,
+                                                                                           const gchar                    *synopsis,
+                                                                                           GInputStream                   *thumbnail,
+                                                                                           const gchar                    *desktop_id,
+                                                                                           const gchar                    *bus_name,
+                                                                                           const gchar                    *knowledge_search_object_path,
+                                                                                           const gchar                    *knowledge_app_id,
+                                                                                           ContentFeedCardLayoutDirection  layout_direction,
+                                                                                           guint                           thumbnail_size,
+                                                                                           const gchar                    *thumbnail_uri,
+                                                                                           const gchar                    *content_type);
+
+/* How the reply to an interface's method is turned into cards */
+typedef enum
+{
+  INTERFACE_MARSHALLER_NONE = 0,
+  INTERFACE_MARSHALLER_ARTICLE,
+  INTERFACE_MARSHALLER_VIDEO,
+  INTERFACE_MARSHALLER_ARTWORK,
+  INTERFACE_MARSHALLER_WORD,
+  INTERFACE_MARSHALLER_QUOTE,
+  INTERFACE_MARSHALLER_BULK,
+  INTERFACE_MARSHALLER_N_MARSHALLERS
+} InterfaceMarshaller;
+
+/**
+ * SECTION:interface-registry
+ * @title: Interface Registry
+ * @short_description: Everything we know about each provider interface
+ *
+ * Each interface that a discovery feed provider can implement has one
+ * entry in the registry. The entry describes both how to talk to the
+ * provider (the introspection data for the proxy and the method to
+ * call) and what to make of the reply (the kind of card, its layout
+ * and thumbnail size, and the factory and marshaller for it). Adding a
+ * new kind of card only means adding an entry.
+ *
+ * The introspection data for all the interfaces is parsed once, and
+ * each interface name is interned as a #GQuark, so looking up an entry
+ * never compares strings. The entry for a #GDBusProxy is remembered on
+ * the proxy after the first lookup.
+ *
+ * Providers may also implement com.endlessm.DiscoveryFeedBulk, which
+ * returns the items for all of their other card interfaces in one
+ * reply. Its entry uses %INTERFACE_MARSHALLER_BULK, and the items for
+ * each interface in the reply are made into cards using the entry for
+ * that interface.
+ *
+ * The card interfaces also have a variant of their method which takes
+ * an a{sv} of options. The options are hints, so providers are free to
+ * ignore any of them:
+ *
+ *  - `max-results` (u): The most items that will be used. Items are
+ *    used in the order that the provider returns them, so a provider
+ *    should return the first `max-results` items of the list that it
+ *    would otherwise have returned, not the last.
+ *  - `fields` (as): The keys that will be looked at in each item.
+ *
+ * A third variant takes the same options and also returns an a{sh}
+ * mapping the thumbnail URI of each item to a file descriptor passed
+ * along with the reply, such as a sealed memfd or a file opened by the
+ * provider. Reading from the descriptor gives the thumbnail data. This
+ * means we never have to open the shards of the provider ourselves,
+ * which we may not even be able to do from inside a sandbox. Thumbnails
+ * without a descriptor are still looked up in the shards.
+ *
+ * Older providers do not implement these methods, so the store
+ * provider falls back to the next method down for them and remembers
+ * that on the proxy.
+ *
+ * The card interfaces and com.endlessm.DiscoveryFeedBulk may also emit
+ * a ContentChanged signal when the items that the provider would return
+ * have changed, so that only that provider needs to be queried again.
+ */
+typedef struct _InterfaceRegistryEntry
+{
+  const gchar                                 *interface_name;
+  const gchar                                 *method_name;
+  const gchar                                 *options_method_name;
+  const gchar                                 *thumbnail_fds_method_name;
+  ContentFeedCardStoreType                     card_type;
+  ContentFeedCardLayoutDirection               direction;
+  guint                                        thumbnail_size;
+  ContentFeedKnowledgeAppCardStoreFactoryFunc  factory;
+  gboolean                                     has_synopsis;
+  InterfaceMarshaller                          marshaller;
+
+  /* Filled in when the registry is first used */
+  GQuark                                       interface_quark;
+  GDBusInterfaceInfo                          *interface_info;
+} InterfaceRegistryEntry;
+
+const InterfaceRegistryEntry * interface_registry_lookup (const gchar *interface_name);
+
+const InterfaceRegistryEntry * interface_registry_lookup_for_proxy (GDBusProxy *proxy);
+
+G_END_DECLS
@@ -0,0 +1,348 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <gio/gio.h>
+
+#include "feed-interface-registry-private.h"
+#include "feed-knowledge-app-news-card-store.h"
+#include "feed-sizes.h"
+
+#define DISCOVERY_FEED_CONTENT_IFACE \
+  "  <interface name=\"com.endlessm.DiscoveryFeedContent\">" \
+  "    <method name=\"ArticleCardDescriptions\">" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "    </method>" \
+  "    <method name=\"ArticleCardDescriptionsWithOptions\">" \
+  "      <arg type=\"a{sv}\" name=\"Options\" direction=\"in\" />" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "    </method>" \
+  "    <method name=\"ArticleCardDescriptionsWithThumbnailFds\">" \
+  "      <arg type=\"a{sv}\" name=\"Options\" direction=\"in\" />" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "      <arg type=\"a{sh}\" name=\"Thumbnails\" direction=\"out\" />" \
+  "    </method>" \
+  "    <signal name=\"ContentChanged\" />" \
+  "  </interface>"
+
+#define DISCOVERY_FEED_NEWS_IFACE \
+  "  <interface name=\"com.endlessm.DiscoveryFeedNews\">" \
+  "    <method name=\"GetRecentNews\">" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "    </method>" \
+  "    <method name=\"GetRecentNewsWithOptions\">" \
+  "      <arg type=\"a{sv}\" name=\"Options\" direction=\"in\" />" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "    </method>" \
+  "    <method name=\"GetRecentNewsWithThumbnailFds\">" \
+  "      <arg type=\"a{sv}\" name=\"Options\" direction=\"in\" />" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "      <arg type=\"a{sh}\" name=\"Thumbnails\" direction=\"out\" />" \
+  "    </method>" \
+  "    <signal name=\"ContentChanged\" />" \
+  "  </interface>"
+
+#define DISCOVERY_FEED_INSTALLABLE_APPS_IFACE \
+  "  <interface name=\"com.endlessm.DiscoveryFeedInstallableApps\">" \
+  "    <method name=\"GetInstallableApps\">" \
+  "      <arg type=\"aa{sv}\" name=\"Results\" direction=\"out\" />" \
+  "    </method>" \
+  "  </interface>"
+
+#define DISCOVERY_FEED_VIDEO_IFACE \
+  "  <interface name=\"com.endlessm.DiscoveryFeedVideo\">" \
+  "    <method name=\"GetVideos\">" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "    </method>" \
+  "    <method name=\"GetVideosWithOptions\">" \
+  "      <arg type=\"a{sv}\" name=\"Options\" direction=\"in\" />" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "    </method>" \
+  "    <method name=\"GetVideosWithThumbnailFds\">" \
+  "      <arg type=\"a{sv}\" name=\"Options\" direction=\"in\" />" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "      <arg type=\"a{sh}\" name=\"Thumbnails\" direction=\"out\" />" \
+  "    </method>" \
+  "    <signal name=\"ContentChanged\" />" \
+  "  </interface>"
+
+#define DISCOVERY_FEED_WORD_IFACE \
+  "  <interface name=\"com.endlessm.DiscoveryFeedWord\">" \
+  "    <method name=\"GetWordOfTheDay\">" \
+  "      <arg type=\"a{ss}\" name=\"Results\" direction=\"out\" />" \
+  "    </method>" \
+  "  </interface>"
+
+#define DISCOVERY_FEED_QUOTE_IFACE \
+  "  <interface name=\"com.endlessm.DiscoveryFeedQuote\">" \
+  "    <method name=\"GetQuoteOfTheDay\">" \
+  "      <arg type=\"a{ss}\" name=\"Results\" direction=\"out\" />" \
+  "    </method>" \
+  "  </interface>"
+
+#define DISCOVERY_FEED_ARTWORK_IFACE \
+  "  <interface name=\"com.endlessm.DiscoveryFeedArtwork\">" \
+  "    <method name=\"ArtworkCardDescriptions\">" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "    </method>" \
+  "    <method name=\"ArtworkCardDescriptionsWithOptions\">" \
+  "      <arg type=\"a{sv}\" name=\"Options\" direction=\"in\" />" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "    </method>" \
+  "    <method name=\"ArtworkCardDescriptionsWithThumbnailFds\">" \
+  "      <arg type=\"a{sv}\" name=\"Options\" direction=\"in\" />" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
+  "      <arg type=\"a{sh}\" name=\"Thumbnails\" direction=\"out\" />" \
+  "    </method>" \
+  "    <signal name=\"ContentChanged\" />" \
+  "  </interface>"
+
+/* Returns the items for each of the other interfaces that the provider
+ * implements in one reply, keyed by interface name, with a single
+ * list of shards for all of them */
+#define DISCOVERY_FEED_BULK_IFACE \
+  "  <interface name=\"com.endlessm.DiscoveryFeedBulk\">" \
+  "    <method name=\"GetAllCardDescriptions\">" \
+  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
+  "      <arg type=\"a{saa{ss}}\" name=\"Results\" direction=\"out\" />" \
+  "    </method>" \
+  "    <signal name=\"ContentChanged\" />" \
+  "  </interface>"
+
+#define DISCOVERY_FEED_INTERFACES \
+  "<node>" \
+  DISCOVERY_FEED_CONTENT_IFACE \
+  DISCOVERY_FEED_NEWS_IFACE \
+  DISCOVERY_FEED_INSTALLABLE_APPS_IFACE \
+  DISCOVERY_FEED_VIDEO_IFACE \
+  DISCOVERY_FEED_QUOTE_IFACE \
+  DISCOVERY_FEED_WORD_IFACE \
+  DISCOVERY_FEED_ARTWORK_IFACE \
+  DISCOVERY_FEED_BULK_IFACE \
+  "</node>"
+
+static InterfaceRegistryEntry interface_registry[] = {
+  {
+    "com.endlessm.DiscoveryFeedContent",
+    "ArticleCardDescriptions",
+    "ArticleCardDescriptionsWithOptions",
+    "ArticleCardDescriptionsWithThumbnailFds",
+    CONTENT_FEED_CARD_STORE_TYPE_ARTICLE_CARD,
+    CONTENT_FEED_CARD_LAYOUT_DIRECTION_IMAGE_FIRST,
+    CONTENT_FEED_THUMBNAIL_SIZE_ARTICLE,
+    content_feed_knowledge_app_card_store_new,
+    TRUE,
+    INTERFACE_MARSHALLER_ARTICLE
+  },
+  {
+    "com.endlessm.DiscoveryFeedNews",
+    "GetRecentNews",
+    "GetRecentNewsWithOptions",
+    "GetRecentNewsWithThumbnailFds",
+    CONTENT_FEED_CARD_STORE_TYPE_ARTICLE_CARD,
+    CONTENT_FEED_CARD_LAYOUT_DIRECTION_IMAGE_LAST,
+    CONTENT_FEED_THUMBNAIL_SIZE_NEWS,
+    (ContentFeedKnowledgeAppCardStoreFactoryFunc) content_feed_knowledge_app_news_card_store_new,
+    TRUE,
+    INTERFACE_MARSHALLER_ARTICLE
+  },
+  {
+    "com.endlessm.DiscoveryFeedInstallableApps",
+    "GetInstallableApps",
+    NULL,
+    NULL,
+    CONTENT_FEED_CARD_STORE_TYPE_AVAILABLE_APPS,
+    CONTENT_FEED_CARD_LAYOUT_DIRECTION_UNSET,
+    0,
+    NULL,
+    FALSE,
+    INTERFACE_MARSHALLER_NONE
+  },
+  {
+    "com.endlessm.DiscoveryFeedVideo",
+    "GetVideos",
+    "GetVideosWithOptions",
+    "GetVideosWithThumbnailFds",
+    CONTENT_FEED_CARD_STORE_TYPE_VIDEO_CARD,
+    CONTENT_FEED_CARD_LAYOUT_DIRECTION_UNSET,
+    0,
+    NULL,
+    FALSE,
+    INTERFACE_MARSHALLER_VIDEO
+  },
+  {
+    "com.endlessm.DiscoveryFeedQuote",
+    "GetQuoteOfTheDay",
+    NULL,
+    NULL,
+    CONTENT_FEED_CARD_STORE_TYPE_WORD_QUOTE_CARD,
+    CONTENT_FEED_CARD_LAYOUT_DIRECTION_UNSET,
+    0,
+    NULL,
+    FALSE,
+    INTERFACE_MARSHALLER_QUOTE
+  },
+  {
+    "com.endlessm.DiscoveryFeedWord",
+    "GetWordOfTheDay",
+    NULL,
+    NULL,
+    CONTENT_FEED_CARD_STORE_TYPE_WORD_QUOTE_CARD,
+    CONTENT_FEED_CARD_LAYOUT_DIRECTION_UNSET,
+    0,
+    NULL,
+    FALSE,
+    INTERFACE_MARSHALLER_WORD
+  },
+  {
+    "com.endlessm.DiscoveryFeedArtwork",
+    "ArtworkCardDescriptions",
+    "ArtworkCardDescriptionsWithOptions",
+    "ArtworkCardDescriptionsWithThumbnailFds",
+    CONTENT_FEED_CARD_STORE_TYPE_ARTWORK_CARD,
+    CONTENT_FEED_CARD_LAYOUT_DIRECTION_IMAGE_FIRST,
+    CONTENT_FEED_THUMBNAIL_SIZE_ARTWORK,
+    NULL,
+    FALSE,
+    INTERFACE_MARSHALLER_ARTWORK
+  },
+  {
+    "com.endlessm.DiscoveryFeedBulk",
+    "GetAllCardDescriptions",
+    NULL,
+    NULL,
+    CONTENT_FEED_CARD_STORE_TYPE_UNSET,
+    CONTENT_FEED_CARD_LAYOUT_DIRECTION_UNSET,
+    0,
+    NULL,
+    FALSE,
+    INTERFACE_MARSHALLER_BULK
+  }
+};
+
+/* Used to remember the entry for a proxy on the proxy itself */
+static GQuark interface_registry_entry_quark = 0;
+
+/* All of the interfaces are parsed together, once, and then shared
+ * between every proxy for the lifetime of the process */
+static void
+ensure_interface_registry (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      g_autoptr(GError) local_error = NULL;
+      GDBusNodeInfo *node_info = g_dbus_node_info_new_for_xml (DISCOVERY_FEED_INTERFACES,
+                                                               &local_error);
+      gsize i = 0;
+
+      if (node_info == NULL)
+        g_error ("Fatal error in parsing interface metadata: %s", local_error->message);
+
+      for (i = 0; i < G_N_ELEMENTS (interface_registry); ++i)
+        {
+          InterfaceRegistryEntry *entry = &interface_registry[i];
+
+          entry->interface_quark = g_quark_from_static_string (entry->interface_name);
+          entry->interface_info = g_dbus_interface_info_ref (g_dbus_node_info_lookup_interface (node_info,
+                                                                                               entry->interface_name));
+
+          /* Speeds up looking up methods on each call */
+          g_dbus_interface_info_cache_build (entry->interface_info);
+        }
+
+      /* The registry keeps the interfaces alive from here on */
+      g_dbus_node_info_unref (node_info);
+
+      interface_registry_entry_quark = g_quark_from_static_string ("content-feed-interface-registry-entry");
+
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
+/*
+ * interface_registry_lookup:
+ * @interface_name: A D-Bus interface name
+ *
+ * Look up the registry entry for @interface_name.
+ *
+ * Returns: The #InterfaceRegistryEntry or %NULL if the interface is
+ *          not one that we know about.
+ */
+const InterfaceRegistryEntry *
+interface_registry_lookup (const gchar *interface_name)
+{
+  GQuark interface_quark = 0;
+  gsize i = 0;
+
+  ensure_interface_registry ();
+
+  /* Any interface that we know about was interned already */
+  interface_quark = g_quark_try_string (interface_name);
+
+  if (interface_quark == 0)
+    return NULL;
+
+  for (i = 0; i < G_N_ELEMENTS (interface_registry); ++i)
+    if (interface_registry[i].interface_quark == interface_quark)
+      return &interface_registry[i];
+
+  return NULL;
+}
+
+/*
+ * interface_registry_lookup_for_proxy:
+ * @proxy: A #GDBusProxy
+ *
+ * Look up the registry entry for the interface of @proxy. The entry is
+ * remembered on @proxy, so this is cheap to call for each query.
+ *
+ * Returns: The #InterfaceRegistryEntry or %NULL if the interface is
+ *          not one that we know about.
+ */
+const InterfaceRegistryEntry *
+interface_registry_lookup_for_proxy (GDBusProxy *proxy)
+{
+  const InterfaceRegistryEntry *entry = NULL;
+
+  ensure_interface_registry ();
+
+  entry = g_object_get_qdata (G_OBJECT (proxy), interface_registry_entry_quark);
+
+  if (entry != NULL)
+    return entry;
+
+  entry = interface_registry_lookup (g_dbus_proxy_get_interface_name (proxy));
+
+  if (entry != NULL)
+    g_object_set_qdata (G_OBJECT (proxy),
+                        interface_registry_entry_quark,
+                        (gpointer) entry);
+
+  return entry;
+}
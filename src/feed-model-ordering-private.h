@@ -0,0 +1,37 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <glib.h>
+
+#include "feed-base-card-store.h"
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:model-ordering-private
+ * @title: Model Ordering Limits
+ * @short_description: How many cards ordering can use from each source
+ *
+ * content_feed_arrange_orderable_models() only ever takes a bounded
+ * number of cards of each type from each source, and never more than
+ * the feed can show at once. Anything beyond that is dropped, so
+ * there is no point in asking providers for more.
+ */
+guint model_ordering_max_cards_per_source (ContentFeedCardStoreType type);
+
+G_END_DECLS
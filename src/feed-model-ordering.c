@@ -19,6 +19,7 @@
 
 #include "feed-base-card-store.h"
 #include "feed-model-ordering.h"
+#include "feed-model-ordering-private.h"
 #include "feed-orderable-model.h"
 
 static gboolean
@@ -195,6 +196,22 @@ make_app_indices_for_card_type (void)
 
 #define CARDS_LIMIT 14
 
+/*
+ * model_ordering_max_cards_per_source:
+ * @type: A #ContentFeedCardStoreType
+ *
+ * Each source is only visited once for each card type, and at most
+ * lookup_card_limit() cards are taken from it when it is.
+ *
+ * Returns: The most cards of @type that ordering will ever take from a
+ *          single source.
+ */
+guint
+model_ordering_max_cards_per_source (ContentFeedCardStoreType type)
+{
+  return MIN (lookup_card_limit (type), CARDS_LIMIT);
+}
+
 static void
 add_first_item_from_first_source (GPtrArray *sources,
                                   GPtrArray *arranged_descriptors)
@@ -0,0 +1,60 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+#include "feed-base-card-store.h"
+#include "feed-orderable-model.h"
+
+G_BEGIN_DECLS
+
+/**
+ * OrderableModelResolveFunc:
+ * @resolve_data: The data passed to orderable_model_new_deferred()
+ *
+ * Build the #ContentFeedBaseCardStore for a deferred orderable model.
+ * This is called at most once per model and may be called on a worker
+ * thread.
+ *
+ * Returns: (transfer full) (nullable): The #ContentFeedBaseCardStore, or
+ *          %NULL if it could not be built.
+ */
+typedef ContentFeedBaseCardStore * (*OrderableModelResolveFunc) (gpointer resolve_data);
+
+/**
+ * SECTION:orderable-model-private
+ * @title: Deferred Orderable Models
+ * @short_description: Orderable models which are built on demand
+ *
+ * Ordering only needs to know the type and source of each card, so a
+ * #ContentFeedOrderableModel can be created with just those and a
+ * function to build the underlying #ContentFeedBaseCardStore later.
+ * The expensive parts of building a card (loading thumbnails and
+ * sanitizing text) are then only paid for the cards that ordering
+ * actually picks, by calling orderable_model_resolve() on them.
+ */
+ContentFeedOrderableModel * orderable_model_new_deferred (ContentFeedCardStoreType   type,
+                                                          const gchar               *source,
+                                                          OrderableModelResolveFunc  resolve_func,
+                                                          gpointer                   resolve_data,
+                                                          GDestroyNotify             resolve_data_destroy);
+
+gboolean orderable_model_resolve (ContentFeedOrderableModel *model);
+
+G_END_DECLS
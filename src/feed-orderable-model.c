@@ -18,6 +18,7 @@
 #include "feed-base-card-store.h"
 #include "feed-enums.h"
 #include "feed-orderable-model.h"
+#include "feed-orderable-model-private.h"
 
 typedef struct _ContentFeedOrderableModel {
   GObject object;
@@ -25,9 +26,14 @@ typedef struct _ContentFeedOrderableModel {
 
 typedef struct _ContentFeedOrderableModelPrivate
 {
-  ContentFeedBaseCardStore *model;
-  ContentFeedCardStoreType  type;
-  gchar                    *source;
+  ContentFeedBaseCardStore  *model;
+  ContentFeedCardStoreType   type;
+  gchar                     *source;
+
+  /* Only set for models which have not been resolved yet */
+  OrderableModelResolveFunc  resolve_func;
+  gpointer                   resolve_data;
+  GDestroyNotify             resolve_data_destroy;
 } ContentFeedOrderableModelPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (ContentFeedOrderableModel,
@@ -77,7 +83,14 @@ content_feed_orderable_model_get_card_store_type (ContentFeedOrderableModel *mod
  * content_feed_orderable_model_get_model:
  * @model: An #ContentFeedOrderableModel
  *
- * Returns: (transfer none): The #ContentFeedCardBaseCardStore of this model.
+ * Note that models returned with
+ * %CONTENT_FEED_UNORDERED_RESULTS_FLAGS_DEFER_MODELS do not have a
+ * #ContentFeedBaseCardStore until they have been passed to
+ * content_feed_resolve_orderable_models().
+ *
+ * Returns: (transfer none) (nullable): The #ContentFeedCardBaseCardStore of
+ *                                      this model, or %NULL if the model
+ *                                      has not been resolved yet.
  */
 ContentFeedBaseCardStore *
 content_feed_orderable_model_get_model (ContentFeedOrderableModel *model)
@@ -151,6 +164,9 @@ content_feed_orderable_model_finalize (GObject *object)
   g_clear_pointer (&priv->source, g_free);
   g_clear_object (&priv->model);
 
+  if (priv->resolve_data_destroy != NULL)
+    g_clear_pointer (&priv->resolve_data, priv->resolve_data_destroy);
+
   G_OBJECT_CLASS (content_feed_orderable_model_parent_class)->finalize (object);
 }
 
@@ -202,3 +218,47 @@ content_feed_orderable_model_new (ContentFeedBaseCardStore *model,
                        NULL);
 }
 
+ContentFeedOrderableModel *
+orderable_model_new_deferred (ContentFeedCardStoreType   type,
+                              const gchar               *source,
+                              OrderableModelResolveFunc  resolve_func,
+                              gpointer                   resolve_data,
+                              GDestroyNotify             resolve_data_destroy)
+{
+  ContentFeedOrderableModel *model = g_object_new (CONTENT_FEED_TYPE_ORDERABLE_MODEL,
+                                                   "type", type,
+                                                   "source", source,
+                                                   NULL);
+  ContentFeedOrderableModelPrivate *priv = content_feed_orderable_model_get_instance_private (model);
+
+  priv->resolve_func = resolve_func;
+  priv->resolve_data = resolve_data;
+  priv->resolve_data_destroy = resolve_data_destroy;
+
+  return model;
+}
+
+gboolean
+orderable_model_resolve (ContentFeedOrderableModel *model)
+{
+  ContentFeedOrderableModelPrivate *priv = content_feed_orderable_model_get_instance_private (model);
+
+  if (priv->model != NULL)
+    return TRUE;
+
+  if (priv->resolve_func == NULL)
+    return FALSE;
+
+  priv->model = priv->resolve_func (priv->resolve_data);
+
+  /* Whether or not that worked, there is no point in trying again,
+   * so release whatever we were holding on to for resolution. */
+  if (priv->resolve_data_destroy != NULL)
+    g_clear_pointer (&priv->resolve_data, priv->resolve_data_destroy);
+
+  priv->resolve_func = NULL;
+  priv->resolve_data = NULL;
+  priv->resolve_data_destroy = NULL;
+
+  return priv->model != NULL;
+}
@@ -0,0 +1,77 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:provider-index
+ * @title: Provider Index
+ * @short_description: Cache of what was found in the provider files
+ *
+ * Finding providers means listing every content-providers directory,
+ * parsing each provider file and looking up the desktop file of each
+ * provider for its language. The results rarely change between runs,
+ * so they are kept in a cache file as a #ProviderIndexEntry for each
+ * provider, before filtering by language, since the user's languages
+ * may have changed.
+ *
+ * Along with the entries, the index records the inode, size and
+ * modification time of every file and directory that the entries were
+ * built from. The index is only used if the data directories are the
+ * same and none of those have changed, so checking it costs a stat for
+ * each of them. Adding or removing a provider file or a desktop file
+ * changes the modification time of its directory. Anything modified in
+ * the same second that the scan started is never trusted, since a
+ * later change in that second would not change the modification time.
+ */
+typedef struct _ProviderIndexEntry
+{
+  gchar *provider_file_path;
+  gchar *object_path;
+  gchar *bus_name;
+  GStrv  supported_interfaces;
+  gchar *knowledge_app_id;
+  gchar *desktop_id;
+  gchar *knowledge_search_object_path;
+  gchar *language;
+} ProviderIndexEntry;
+
+ProviderIndexEntry * provider_index_entry_new (const gchar         *provider_file_path,
+                                               const gchar         *object_path,
+                                               const gchar         *bus_name,
+                                               const gchar * const *supported_interfaces,
+                                               const gchar         *knowledge_app_id,
+                                               const gchar         *desktop_id,
+                                               const gchar         *knowledge_search_object_path,
+                                               const gchar         *language);
+
+void provider_index_entry_free (ProviderIndexEntry *entry);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ProviderIndexEntry, provider_index_entry_free)
+
+GPtrArray * provider_index_load (const gchar * const *data_dirs);
+
+void provider_index_save (const gchar * const *data_dirs,
+                          GPtrArray           *entries,
+                          GPtrArray           *dependency_paths,
+                          gint64               scan_started);
+
+G_END_DECLS
@@ -0,0 +1,265 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gstdio.h>
+
+#include "feed-cache-file-private.h"
+#include "feed-provider-index-private.h"
+
+#define PROVIDER_INDEX_NAME "provider-index-v1.gvariant"
+
+/* (when the scan started, data directories, (path, stamp) for each
+ * dependency, entries), where each stamp is (inode, size, mtime) and
+ * each entry is (provider file, object path, bus name, interfaces,
+ * app ID, desktop ID, search object path, language) */
+#define PROVIDER_INDEX_TYPE "(xasa(s(txx))a(sssasmsmsmsms))"
+
+/* The stamp for a path that does not exist */
+#define MISSING_STAMP_INODE 0
+
+ProviderIndexEntry *
+provider_index_entry_new (const gchar         *provider_file_path,
+                          const gchar         *object_path,
+                          const gchar         *bus_name,
+                          const gchar * const *supported_interfaces,
+                          const gchar         *knowledge_app_id,
+                          const gchar         *desktop_id,
+                          const gchar         *knowledge_search_object_path,
+                          const gchar         *language)
+{
+  ProviderIndexEntry *entry = g_new0 (ProviderIndexEntry, 1);
+
+  entry->provider_file_path = g_strdup (provider_file_path);
+  entry->object_path = g_strdup (object_path);
+  entry->bus_name = g_strdup (bus_name);
+  entry->supported_interfaces = g_strdupv ((GStrv) supported_interfaces);
+  entry->knowledge_app_id = g_strdup (knowledge_app_id);
+  entry->desktop_id = g_strdup (desktop_id);
+  entry->knowledge_search_object_path = g_strdup (knowledge_search_object_path);
+  entry->language = g_strdup (language);
+
+  return entry;
+}
+
+void
+provider_index_entry_free (ProviderIndexEntry *entry)
+{
+  g_clear_pointer (&entry->provider_file_path, g_free);
+  g_clear_pointer (&entry->object_path, g_free);
+  g_clear_pointer (&entry->bus_name, g_free);
+  g_clear_pointer (&entry->supported_interfaces, g_strfreev);
+  g_clear_pointer (&entry->knowledge_app_id, g_free);
+  g_clear_pointer (&entry->desktop_id, g_free);
+  g_clear_pointer (&entry->knowledge_search_object_path, g_free);
+  g_clear_pointer (&entry->language, g_free);
+
+  g_free (entry);
+}
+
+static void
+stamp_path (const gchar *path,
+            guint64     *out_inode,
+            gint64      *out_size,
+            gint64      *out_mtime)
+{
+  GStatBuf stat_buf;
+
+  if (g_stat (path, &stat_buf) != 0)
+    {
+      *out_inode = MISSING_STAMP_INODE;
+      *out_size = 0;
+      *out_mtime = 0;
+      return;
+    }
+
+  *out_inode = stat_buf.st_ino;
+  *out_size = stat_buf.st_size;
+  *out_mtime = stat_buf.st_mtime;
+}
+
+static gboolean
+strv_equal (const gchar * const *a,
+            const gchar * const *b)
+{
+  for (; *a != NULL && *b != NULL; ++a, ++b)
+    if (g_strcmp0 (*a, *b) != 0)
+      return FALSE;
+
+  return *a == NULL && *b == NULL;
+}
+
+/*
+ * provider_index_load:
+ * @data_dirs: The data directories that providers are looked up in
+ *
+ * Load the entries from the index, if it was built for @data_dirs and
+ * nothing it depends on has changed since.
+ *
+ * Returns: (transfer full) (element-type ProviderIndexEntry) (nullable):
+ *          The entries in the order they were found, or %NULL if the
+ *          index is missing or out of date.
+ */
+GPtrArray *
+provider_index_load (const gchar * const *data_dirs)
+{
+  g_autoptr(GVariant) index = cache_file_load_variant (PROVIDER_INDEX_NAME,
+                                                       G_VARIANT_TYPE (PROVIDER_INDEX_TYPE));
+  g_autoptr(GPtrArray) entries = NULL;
+  g_autofree const gchar **index_data_dirs = NULL;
+  g_autoptr(GVariant) stamps = NULL;
+  g_autoptr(GVariant) entries_variant = NULL;
+  gint64 scan_started = 0;
+  GVariantIter iter;
+  const gchar *path = NULL;
+  guint64 inode = 0;
+  gint64 size = 0;
+  gint64 mtime = 0;
+  const gchar *provider_file_path = NULL;
+  const gchar *object_path = NULL;
+  const gchar *bus_name = NULL;
+  g_autofree const gchar **supported_interfaces = NULL;
+  const gchar *knowledge_app_id = NULL;
+  const gchar *desktop_id = NULL;
+  const gchar *knowledge_search_object_path = NULL;
+  const gchar *language = NULL;
+
+  if (index == NULL)
+    return NULL;
+
+  g_variant_get (index,
+                 "(x^a&s@a(s(txx))@a(sssasmsmsmsms))",
+                 &scan_started,
+                 &index_data_dirs,
+                 &stamps,
+                 &entries_variant);
+
+  if (!strv_equal ((const gchar * const *) index_data_dirs, data_dirs))
+    return NULL;
+
+  g_variant_iter_init (&iter, stamps);
+  while (g_variant_iter_next (&iter, "(&s(txx))", &path, &inode, &size, &mtime))
+    {
+      guint64 current_inode = 0;
+      gint64 current_size = 0;
+      gint64 current_mtime = 0;
+
+      stamp_path (path, &current_inode, &current_size, &current_mtime);
+
+      if (current_inode != inode ||
+          current_size != size ||
+          current_mtime != mtime)
+        return NULL;
+
+      /* It could have changed again in the same second after the scan */
+      if (inode != MISSING_STAMP_INODE && mtime >= scan_started)
+        return NULL;
+    }
+
+  entries = g_ptr_array_new_full (g_variant_n_children (entries_variant),
+                                  (GDestroyNotify) provider_index_entry_free);
+
+  g_variant_iter_init (&iter, entries_variant);
+  while (g_variant_iter_next (&iter,
+                              "(&s&s&s^a&sm&sm&sm&sm&s)",
+                              &provider_file_path,
+                              &object_path,
+                              &bus_name,
+                              &supported_interfaces,
+                              &knowledge_app_id,
+                              &desktop_id,
+                              &knowledge_search_object_path,
+                              &language))
+    {
+      g_ptr_array_add (entries,
+                       provider_index_entry_new (provider_file_path,
+                                                 object_path,
+                                                 bus_name,
+                                                 supported_interfaces,
+                                                 knowledge_app_id,
+                                                 desktop_id,
+                                                 knowledge_search_object_path,
+                                                 language));
+      g_clear_pointer (&supported_interfaces, g_free);
+    }
+
+  return g_steal_pointer (&entries);
+}
+
+/*
+ * provider_index_save:
+ * @data_dirs: The data directories that providers were looked up in
+ * @entries: (element-type ProviderIndexEntry): The entries that were found
+ * @dependency_paths: (element-type utf8): Every file and directory that
+ *                    the entries were built from, whether it existed or not
+ * @scan_started: When the scan started, in seconds since the epoch
+ *
+ * Save @entries as the index, so that provider_index_load() returns
+ * them until something in @dependency_paths changes. Failing to save is
+ * logged, since the index can always be rebuilt.
+ */
+void
+provider_index_save (const gchar * const *data_dirs,
+                     GPtrArray           *entries,
+                     GPtrArray           *dependency_paths,
+                     gint64               scan_started)
+{
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GVariant) index = NULL;
+  GVariantBuilder stamps_builder;
+  GVariantBuilder entries_builder;
+  guint i = 0;
+
+  g_variant_builder_init (&stamps_builder, G_VARIANT_TYPE ("a(s(txx))"));
+
+  for (i = 0; i < dependency_paths->len; ++i)
+    {
+      const gchar *path = g_ptr_array_index (dependency_paths, i);
+      guint64 inode = 0;
+      gint64 size = 0;
+      gint64 mtime = 0;
+
+      stamp_path (path, &inode, &size, &mtime);
+      g_variant_builder_add (&stamps_builder, "(s(txx))", path, inode, size, mtime);
+    }
+
+  g_variant_builder_init (&entries_builder, G_VARIANT_TYPE ("a(sssasmsmsmsms)"));
+
+  for (i = 0; i < entries->len; ++i)
+    {
+      ProviderIndexEntry *entry = g_ptr_array_index (entries, i);
+
+      g_variant_builder_add (&entries_builder,
+                             "(sss^asmsmsmsms)",
+                             entry->provider_file_path,
+                             entry->object_path,
+                             entry->bus_name,
+                             entry->supported_interfaces,
+                             entry->knowledge_app_id,
+                             entry->desktop_id,
+                             entry->knowledge_search_object_path,
+                             entry->language);
+    }
+
+  index = g_variant_ref_sink (g_variant_new ("(x^as@a(s(txx))@a(sssasmsmsmsms))",
+                                             scan_started,
+                                             data_dirs,
+                                             g_variant_builder_end (&stamps_builder),
+                                             g_variant_builder_end (&entries_builder)));
+
+  if (!cache_file_save_variant (PROVIDER_INDEX_NAME, index, &local_error))
+    g_message ("Could not save provider index: %s", local_error->message);
+}
@@ -0,0 +1,89 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define DISCOVERY_FEED_SECTION_NAME "Discovery Feed Content Provider"
+#define LOAD_ITEM_SECTION_NAME "Load Item Provider"
+
+/**
+ * SECTION:provider-key-file
+ * @title: Provider Key File
+ * @short_description: Parser for the keys that provider files define
+ *
+ * Finding providers parses every provider file, but only ever reads a
+ * handful of keys from two sections. Rather than building a #GKeyFile
+ * with every group, key and comment, a #ProviderKeyFile reads the file
+ * in one pass and keeps a pointer to the raw value of each
+ * #ProviderKey, in place in the contents of the file.
+ *
+ * Files are accepted and rejected by the same rules as
+ * g_key_file_load_from_file(), and later values of a key override
+ * earlier ones. Values are unescaped, validated and split into lists in
+ * the same way as g_key_file_get_string() and
+ * g_key_file_get_string_list(), and fail with the same #GKeyFileError
+ * codes.
+ */
+typedef enum
+{
+  PROVIDER_KEY_DESKTOP_ID,
+  PROVIDER_KEY_OBJECT_PATH,
+  PROVIDER_KEY_BUS_NAME,
+  PROVIDER_KEY_SUPPORTED_INTERFACES,
+  PROVIDER_KEY_APP_ID,
+  PROVIDER_KEY_LOAD_ITEM_OBJECT_PATH,
+  N_PROVIDER_KEYS
+} ProviderKey;
+
+typedef struct _ProviderKeyFile
+{
+  gchar       *contents;
+  gboolean     has_discovery_feed_section;
+  gboolean     has_load_item_section;
+  const gchar *values[N_PROVIDER_KEYS];  /* (nullable): Raw values, pointing into @contents */
+} ProviderKeyFile;
+
+#define PROVIDER_KEY_FILE_INIT { NULL, FALSE, FALSE, { NULL, } }
+
+gboolean provider_key_file_load (ProviderKeyFile  *key_file,
+                                 const gchar      *path,
+                                 GError          **error);
+
+void provider_key_file_clear (ProviderKeyFile *key_file);
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC (ProviderKeyFile, provider_key_file_clear)
+
+const gchar * provider_key_get_name (ProviderKey key);
+
+const gchar * provider_key_get_section (ProviderKey key);
+
+gboolean provider_key_file_has_key (ProviderKeyFile *key_file,
+                                    ProviderKey      key);
+
+gchar * provider_key_file_get_string (ProviderKeyFile  *key_file,
+                                      ProviderKey       key,
+                                      GError          **error);
+
+GStrv provider_key_file_get_string_list (ProviderKeyFile  *key_file,
+                                         ProviderKey       key,
+                                         GError          **error);
+
+G_END_DECLS
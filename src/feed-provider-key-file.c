@@ -0,0 +1,508 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "feed-provider-key-file-private.h"
+
+typedef enum
+{
+  SECTION_NONE,
+  SECTION_OTHER,
+  SECTION_DISCOVERY_FEED,
+  SECTION_LOAD_ITEM
+} ProviderKeyFileSection;
+
+typedef struct _ProviderKeyFileParser
+{
+  ProviderKeyFileSection  section;
+
+  /* The name of the first group in the file, pointing into the
+   * contents, and whether we are in a group with that name */
+  const gchar            *start_group;
+  gboolean                in_start_group;
+} ProviderKeyFileParser;
+
+#define PROVIDER_KEY_FILE_PARSER_INIT { SECTION_NONE, NULL, FALSE }
+
+static const struct
+{
+  ProviderKeyFileSection  section;
+  const gchar            *name;
+} provider_keys[N_PROVIDER_KEYS] = {
+  [PROVIDER_KEY_DESKTOP_ID] = { SECTION_DISCOVERY_FEED, "DesktopId" },
+  [PROVIDER_KEY_OBJECT_PATH] = { SECTION_DISCOVERY_FEED, "ObjectPath" },
+  [PROVIDER_KEY_BUS_NAME] = { SECTION_DISCOVERY_FEED, "BusName" },
+  [PROVIDER_KEY_SUPPORTED_INTERFACES] = { SECTION_DISCOVERY_FEED, "SupportedInterfaces" },
+  [PROVIDER_KEY_APP_ID] = { SECTION_DISCOVERY_FEED, "AppID" },
+  [PROVIDER_KEY_LOAD_ITEM_OBJECT_PATH] = { SECTION_LOAD_ITEM, "ObjectPath" }
+};
+
+const gchar *
+provider_key_get_name (ProviderKey key)
+{
+  return provider_keys[key].name;
+}
+
+const gchar *
+provider_key_get_section (ProviderKey key)
+{
+  return provider_keys[key].section == SECTION_LOAD_ITEM ?
+         LOAD_ITEM_SECTION_NAME : DISCOVERY_FEED_SECTION_NAME;
+}
+
+/* Same as g_key_file_line_is_group() */
+static gboolean
+line_is_group (const gchar *line)
+{
+  const gchar *p = line;
+
+  if (*p != '[')
+    return FALSE;
+
+  for (++p; *p != '\0' && *p != ']'; p = g_utf8_find_next_char (p, NULL))
+    ;
+
+  if (*p != ']')
+    return FALSE;
+
+  /* Whitespace after the ] is allowed */
+  for (++p; *p == ' ' || *p == '\t'; ++p)
+    ;
+
+  return *p == '\0';
+}
+
+/* Same as g_key_file_is_group_name() */
+static gboolean
+group_name_is_valid (const gchar *name)
+{
+  const gchar *q = name;
+
+  while (*q != '\0' && *q != ']' && *q != '[' && !g_ascii_iscntrl (*q))
+    q = g_utf8_find_next_char (q, NULL);
+
+  return *q == '\0' && q != name;
+}
+
+/* Same as g_key_file_is_key_name(), including locale suffixes */
+static gboolean
+key_name_is_valid (const gchar *name)
+{
+  const gchar *q = name;
+
+  while (*q != '\0' && *q != '=' && *q != '[' && *q != ']')
+    q = g_utf8_find_next_char (q, NULL);
+
+  if (q == name)
+    return FALSE;
+
+  if (*name == ' ' || q[-1] == ' ')
+    return FALSE;
+
+  if (*q == '[')
+    {
+      for (++q;
+           *q != '\0' &&
+           (g_unichar_isalnum (g_utf8_get_char_validated (q, -1)) ||
+            *q == '-' || *q == '_' || *q == '.' || *q == '@');
+           q = g_utf8_find_next_char (q, NULL))
+        ;
+
+      if (*q != ']')
+        return FALSE;
+
+      ++q;
+    }
+
+  return *q == '\0';
+}
+
+static gboolean
+parse_line (ProviderKeyFile        *key_file,
+            gchar                  *line,
+            ProviderKeyFileParser  *parser,
+            GError                **error)
+{
+  gchar *equals = NULL;
+  gchar *key_end = NULL;
+  gchar *value = NULL;
+  guint i = 0;
+
+  while (g_ascii_isspace (*line))
+    ++line;
+
+  /* Comments and blank lines */
+  if (*line == '#' || *line == '\0')
+    return TRUE;
+
+  if (line_is_group (line))
+    {
+      gchar *name = line + 1;
+
+      *strrchr (line, ']') = '\0';
+
+      if (!group_name_is_valid (name))
+        {
+          g_set_error (error,
+                       G_KEY_FILE_ERROR,
+                       G_KEY_FILE_ERROR_PARSE,
+                       "Invalid group name: %s",
+                       name);
+          return FALSE;
+        }
+
+      if (parser->start_group == NULL)
+        parser->start_group = name;
+
+      parser->in_start_group = strcmp (name, parser->start_group) == 0;
+
+      if (g_strcmp0 (name, DISCOVERY_FEED_SECTION_NAME) == 0)
+        {
+          parser->section = SECTION_DISCOVERY_FEED;
+          key_file->has_discovery_feed_section = TRUE;
+        }
+      else if (g_strcmp0 (name, LOAD_ITEM_SECTION_NAME) == 0)
+        {
+          parser->section = SECTION_LOAD_ITEM;
+          key_file->has_load_item_section = TRUE;
+        }
+      else
+        {
+          parser->section = SECTION_OTHER;
+        }
+
+      return TRUE;
+    }
+
+  equals = strchr (line, '=');
+
+  if (equals == NULL || equals == line)
+    {
+      g_set_error (error,
+                   G_KEY_FILE_ERROR,
+                   G_KEY_FILE_ERROR_PARSE,
+                   "Key file contains line %s which is not a key-value pair, "
+                   "group, or comment",
+                   line);
+      return FALSE;
+    }
+
+  if (parser->section == SECTION_NONE)
+    {
+      g_set_error_literal (error,
+                           G_KEY_FILE_ERROR,
+                           G_KEY_FILE_ERROR_GROUP_NOT_FOUND,
+                           "Key file does not start with a group");
+      return FALSE;
+    }
+
+  /* Whitespace around the = is not part of the key or the value, but
+   * whitespace at the end of the value is */
+  for (value = equals + 1; g_ascii_isspace (*value); ++value)
+    ;
+
+  for (key_end = equals; g_ascii_isspace (key_end[-1]); --key_end)
+    ;
+
+  *key_end = '\0';
+
+  if (!key_name_is_valid (line))
+    {
+      g_set_error (error,
+                   G_KEY_FILE_ERROR,
+                   G_KEY_FILE_ERROR_PARSE,
+                   "Invalid key name: %s",
+                   line);
+      return FALSE;
+    }
+
+  /* GKeyFile only supports UTF-8, and says so if the first group
+   * declares anything else */
+  if (parser->in_start_group &&
+      strcmp (line, "Encoding") == 0 &&
+      g_ascii_strcasecmp (value, "UTF-8") != 0)
+    {
+      g_autofree gchar *valid_value = g_utf8_make_valid (value, -1);
+
+      g_set_error (error,
+                   G_KEY_FILE_ERROR,
+                   G_KEY_FILE_ERROR_UNKNOWN_ENCODING,
+                   "Key file contains unsupported encoding %s",
+                   valid_value);
+      return FALSE;
+    }
+
+  for (i = 0; i < N_PROVIDER_KEYS; ++i)
+    {
+      if (provider_keys[i].section == parser->section &&
+          strcmp (provider_keys[i].name, line) == 0)
+        key_file->values[i] = value;
+    }
+
+  return TRUE;
+}
+
+/*
+ * provider_key_file_load:
+ * @key_file: A #ProviderKeyFile initialized with %PROVIDER_KEY_FILE_INIT
+ * @path: The path to the provider file
+ * @error: A #GError
+ *
+ * Read the provider file at @path into @key_file, failing in the same
+ * cases that g_key_file_load_from_file() would.
+ *
+ * Returns: %TRUE on success, %FALSE with @error set on failure.
+ */
+gboolean
+provider_key_file_load (ProviderKeyFile  *key_file,
+                        const gchar      *path,
+                        GError          **error)
+{
+  ProviderKeyFileParser parser = PROVIDER_KEY_FILE_PARSER_INIT;
+  gsize length = 0;
+  gchar *line = NULL;
+  gchar *end = NULL;
+
+  if (!g_file_get_contents (path, &key_file->contents, &length, error))
+    return FALSE;
+
+  line = key_file->contents;
+  end = key_file->contents + length;
+
+  /* Each line is terminated in place, so that values can point into
+   * the contents. The contents always have a terminating nul after
+   * the last line. */
+  while (line < end)
+    {
+      gchar *newline = memchr (line, '\n', end - line);
+      gchar *line_end = newline != NULL ? newline : end;
+
+      if (newline != NULL && line_end > line && line_end[-1] == '\r')
+        --line_end;
+
+      *line_end = '\0';
+
+      if (!parse_line (key_file, line, &parser, error))
+        return FALSE;
+
+      line = newline != NULL ? newline + 1 : end;
+    }
+
+  return TRUE;
+}
+
+void
+provider_key_file_clear (ProviderKeyFile *key_file)
+{
+  g_clear_pointer (&key_file->contents, g_free);
+  memset (key_file->values, 0, sizeof (key_file->values));
+}
+
+gboolean
+provider_key_file_has_key (ProviderKeyFile *key_file,
+                           ProviderKey      key)
+{
+  return key_file->values[key] != NULL;
+}
+
+/* Same as g_key_file_parse_value_as_string(), splitting @value into
+ * @pieces on unescaped list separators if @pieces is not %NULL.
+ * Returns %FALSE if @value has an invalid escape sequence. */
+static gboolean
+unescape_value (const gchar  *value,
+                GPtrArray    *pieces,
+                gchar       **out_string)
+{
+  g_autofree gchar *string = g_malloc (strlen (value) + 1);
+  const gchar *p = value;
+  gchar *q = string;
+  gchar *q0 = string;
+
+  for (; *p != '\0'; ++p, ++q)
+    {
+      if (*p != '\\')
+        {
+          *q = *p;
+
+          if (pieces != NULL && *p == ';')
+            {
+              g_ptr_array_add (pieces, g_strndup (q0, q - q0));
+              q0 = q + 1;
+            }
+
+          continue;
+        }
+
+      switch (*++p)
+        {
+        case 's':
+          *q = ' ';
+          break;
+        case 'n':
+          *q = '\n';
+          break;
+        case 't':
+          *q = '\t';
+          break;
+        case 'r':
+          *q = '\r';
+          break;
+        case '\\':
+          *q = '\\';
+          break;
+        case ';':
+          if (pieces == NULL)
+            return FALSE;
+
+          *q = ';';
+          break;
+        default:
+          /* Includes an escape character at the end of the line */
+          return FALSE;
+        }
+    }
+
+  *q = '\0';
+
+  if (pieces != NULL && q0 < q)
+    g_ptr_array_add (pieces, g_strndup (q0, q - q0));
+
+  if (out_string != NULL)
+    *out_string = g_steal_pointer (&string);
+
+  return TRUE;
+}
+
+static const gchar *
+get_validated_value (ProviderKeyFile  *key_file,
+                     ProviderKey       key,
+                     GError          **error)
+{
+  const gchar *value = key_file->values[key];
+  gboolean has_section = provider_keys[key].section == SECTION_LOAD_ITEM ?
+                         key_file->has_load_item_section :
+                         key_file->has_discovery_feed_section;
+
+  if (!has_section)
+    {
+      g_set_error (error,
+                   G_KEY_FILE_ERROR,
+                   G_KEY_FILE_ERROR_GROUP_NOT_FOUND,
+                   "Key file does not have group %s",
+                   provider_key_get_section (key));
+      return NULL;
+    }
+
+  if (value == NULL)
+    {
+      g_set_error (error,
+                   G_KEY_FILE_ERROR,
+                   G_KEY_FILE_ERROR_KEY_NOT_FOUND,
+                   "Key file does not have key %s in group %s",
+                   provider_key_get_name (key),
+                   provider_key_get_section (key));
+      return NULL;
+    }
+
+  if (!g_utf8_validate (value, -1, NULL))
+    {
+      g_set_error (error,
+                   G_KEY_FILE_ERROR,
+                   G_KEY_FILE_ERROR_UNKNOWN_ENCODING,
+                   "Key file contains key %s with a value which is not UTF-8",
+                   provider_key_get_name (key));
+      return NULL;
+    }
+
+  return value;
+}
+
+static void
+set_invalid_value_error (ProviderKey   key,
+                         GError      **error)
+{
+  g_set_error (error,
+               G_KEY_FILE_ERROR,
+               G_KEY_FILE_ERROR_INVALID_VALUE,
+               "Key file contains key %s which has a value that cannot be interpreted.",
+               provider_key_get_name (key));
+}
+
+/*
+ * provider_key_file_get_string:
+ * @key_file: A loaded #ProviderKeyFile
+ * @key: The #ProviderKey to get
+ * @error: A #GError
+ *
+ * Returns: (transfer full): The unescaped value of @key, or %NULL
+ *          with @error set if it is missing or invalid.
+ */
+gchar *
+provider_key_file_get_string (ProviderKeyFile  *key_file,
+                              ProviderKey       key,
+                              GError          **error)
+{
+  const gchar *value = get_validated_value (key_file, key, error);
+  gchar *string = NULL;
+
+  if (value == NULL)
+    return NULL;
+
+  if (!unescape_value (value, NULL, &string))
+    {
+      set_invalid_value_error (key, error);
+      return NULL;
+    }
+
+  return string;
+}
+
+/*
+ * provider_key_file_get_string_list:
+ * @key_file: A loaded #ProviderKeyFile
+ * @key: The #ProviderKey to get
+ * @error: A #GError
+ *
+ * Returns: (transfer full): The value of @key split on unescaped
+ *          semicolons, with each element unescaped, or %NULL with
+ *          @error set if it is missing or invalid.
+ */
+GStrv
+provider_key_file_get_string_list (ProviderKeyFile  *key_file,
+                                   ProviderKey       key,
+                                   GError          **error)
+{
+  const gchar *value = get_validated_value (key_file, key, error);
+  g_autoptr(GPtrArray) pieces = NULL;
+
+  if (value == NULL)
+    return NULL;
+
+  pieces = g_ptr_array_new_with_free_func (g_free);
+
+  if (!unescape_value (value, pieces, NULL))
+    {
+      set_invalid_value_error (key, error);
+      return NULL;
+    }
+
+  g_ptr_array_set_free_func (pieces, NULL);
+  g_ptr_array_add (pieces, NULL);
+
+  return (GStrv) g_ptr_array_free (g_steal_pointer (&pieces), FALSE);
+}
@@ -0,0 +1,80 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+#include "feed-provider-index-private.h"
+#include "feed-provider-info.h"
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:provider-lookup-private
+ * @title: Provider Lookup Internals
+ * @short_description: Building blocks for finding providers
+ *
+ * content_feed_find_providers() and #ContentFeedProviderRegistry both
+ * find providers the same way: a #ProviderIndexEntry is built for each
+ * provider file in the content-providers directory of each data
+ * directory, and entries are turned into #ContentFeedProviderInfo
+ * objects if their language is compatible with the user's languages.
+ * These functions expose each of those steps, so that the registry can
+ * reload a single provider file when it changes.
+ */
+GStrv provider_lookup_data_dirs (void);
+
+GStrv provider_lookup_flatpak_exports_dirs (void);
+
+GStrv provider_lookup_supported_languages (void);
+
+/**
+ * DesktopFileResolver:
+ *
+ * Finds the desktop file for each Desktop ID from a single listing of
+ * the applications directory of each data directory, and reads the
+ * content language of each desktop file at most once.
+ */
+typedef struct _DesktopFileResolver DesktopFileResolver;
+
+DesktopFileResolver * desktop_file_resolver_new (const gchar * const *data_dirs);
+
+void desktop_file_resolver_free (DesktopFileResolver *resolver);
+
+gboolean desktop_file_resolver_get_language (DesktopFileResolver  *resolver,
+                                             const gchar          *desktop_id,
+                                             gchar               **out_language,
+                                             gchar               **out_path,
+                                             GError              **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (DesktopFileResolver, desktop_file_resolver_free)
+
+gboolean provider_lookup_load_entry (DesktopFileResolver *desktop_file_resolver,
+                                     const gchar         *provider_file_path,
+                                     GPtrArray           *dependency_paths,
+                                     ProviderIndexEntry **out_entry,
+                                     GError             **error);
+
+GPtrArray * provider_lookup_entries (const gchar * const  *data_directories,
+                                     GCancellable         *cancellable,
+                                     GError              **error);
+
+ContentFeedProviderInfo * provider_lookup_info_for_entry (ProviderIndexEntry  *entry,
+                                                          const gchar * const *languages);
+
+G_END_DECLS
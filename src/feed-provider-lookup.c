@@ -15,9 +15,11 @@
  * <http://www.gnu.org/licenses/>.
  */
 
-#include <gio/gdesktopappinfo.h>
 #include <gio/gio.h>
 
+#include "feed-provider-index-private.h"
+#include "feed-provider-key-file-private.h"
+#include "feed-provider-lookup-private.h"
 #include "feed-provider-lookup.h"
 #include "feed-provider-info.h"
 
@@ -78,17 +80,37 @@ uniquify_string_lists (GStrv *strvs)
   return (GStrv) g_ptr_array_free (g_steal_pointer (&array), FALSE);
 }
 
-static GStrv
-all_relevant_data_dirs (void)
+/*
+ * provider_lookup_flatpak_exports_dirs:
+ *
+ * Returns: (transfer full): The exports/share directory of each flatpak
+ *          installation, which is where installed apps export their
+ *          provider files and desktop files.
+ */
+GStrv
+provider_lookup_flatpak_exports_dirs (void)
+{
+  g_auto(GStrv) flatpak_system_dirs = determine_flatpak_system_dirs ();
+
+  return append_suffix_to_each_path ((const gchar * const *) flatpak_system_dirs,
+                                     "exports/share");
+}
+
+/*
+ * provider_lookup_data_dirs:
+ *
+ * Returns: (transfer full): Every data directory that providers are
+ *          looked up in, in order of priority.
+ */
+GStrv
+provider_lookup_data_dirs (void)
 {
   const gchar * const host_data_dirs[] = {
     "/run/host/usr/share",
     NULL
   };
   const gchar * const *system_data_dirs = g_get_system_data_dirs ();
-  g_auto(GStrv) flatpak_system_dirs = determine_flatpak_system_dirs ();
-  g_auto(GStrv) flatpak_exports_dirs = append_suffix_to_each_path ((const gchar * const *) flatpak_system_dirs,
-                                                                   "exports/share");
+  g_auto(GStrv) flatpak_exports_dirs = provider_lookup_flatpak_exports_dirs ();
 
   const gchar * const * const all_data_dirs_strvs[] = {
     system_data_dirs,
@@ -100,73 +122,50 @@ all_relevant_data_dirs (void)
   return uniquify_string_lists ((GStrv *) all_data_dirs_strvs);
 }
 
-#define DISCOVERY_FEED_SECTION_NAME "Discovery Feed Content Provider"
-#define LOAD_ITEM_SECTION_NAME "Load Item Provider"
-
-static const gchar * const required_discovery_feed_provider_keys[] = {
-  "DesktopId",
-  "ObjectPath",
-  "BusName",
-  "SupportedInterfaces",
-  NULL
+static const ProviderKey required_discovery_feed_provider_keys[] = {
+  PROVIDER_KEY_DESKTOP_ID,
+  PROVIDER_KEY_OBJECT_PATH,
+  PROVIDER_KEY_BUS_NAME,
+  PROVIDER_KEY_SUPPORTED_INTERFACES
 };
 
 static gboolean
-key_file_has_specified_keys_in_section (GKeyFile             *key_file,
-                                        const gchar          *path,
-                                        const gchar          *section,
-                                        const gchar * const  *keys,
-                                        gboolean             *out_has_keys,
-                                        GError              **error)
+key_file_has_specified_keys (ProviderKeyFile   *key_file,
+                             const gchar       *path,
+                             const ProviderKey *keys,
+                             gsize              n_keys)
 {
-  g_autoptr(GError) local_error = NULL;
-  const gchar * const *iter = keys;
+  gsize i = 0;
 
-  g_return_val_if_fail (out_has_keys != NULL, FALSE);
-
-  for (; *iter != NULL; ++iter)
+  for (i = 0; i < n_keys; ++i)
     {
-      gboolean has_key = g_key_file_has_key (key_file, section, *iter, &local_error);
-
-      /* Documentation says that g_key_file_has_key does not follow
-       * GError rules exactly - the return value has meaning and we must
-       * check the GError outparam ourselves. */
-      if (local_error != NULL)
-        {
-          g_propagate_error (error, g_steal_pointer (&local_error));
-          return FALSE;
-        }
-
-      if (!has_key)
+      if (!provider_key_file_has_key (key_file, keys[i]))
         {
           g_message ("Key file %s does not have key %s in section %s (ignoring)",
                      path,
-                     *iter,
-                     section);
-          *out_has_keys = FALSE;
-          return TRUE;
+                     provider_key_get_name (keys[i]),
+                     provider_key_get_section (keys[i]));
+          return FALSE;
         }
     }
 
-  *out_has_keys = TRUE;
   return TRUE;
 }
 
 /* This function only has an awkward outparam because NULL
  * permissible for default_value, which has a different meaning
- * from a NULL return from g_key_file_get_string */
+ * from a NULL return from provider_key_file_get_string */
 static gboolean
-optional_get_key_file_string (GKeyFile     *key_file,
-                              const gchar  *section,
-                              const gchar  *key,
-                              const gchar  *default_value,
-                              gchar       **value_out,
-                              GError      **error)
+optional_get_key_file_string (ProviderKeyFile  *key_file,
+                              ProviderKey       key,
+                              const gchar      *default_value,
+                              gchar           **value_out,
+                              GError          **error)
 {
   g_autofree gchar *value = NULL;
   g_autoptr(GError) local_error = NULL;
 
-  value = g_key_file_get_string (key_file, section, key, &local_error);
+  value = provider_key_file_get_string (key_file, key, &local_error);
 
   if (local_error != NULL)
     {
@@ -184,29 +183,158 @@ optional_get_key_file_string (GKeyFile     *key_file,
   return TRUE;
 }
 
-/**
- * flatpak_compatible_desktop_app_info:
- * @desktop_id: The Desktop ID to create a GDesktopAppInfo for.
+struct _DesktopFileResolver
+{
+  GMutex      lock;
+  GStrv       data_dirs;
+  GHashTable *candidates;  /* desktop ID → (element-type utf8) GPtrArray of paths, in data dir order */
+  GHashTable *resolved;    /* desktop ID → ResolvedDesktopFile */
+};
+
+typedef struct _ResolvedDesktopFile
+{
+  gchar *path;
+  gchar *language;
+} ResolvedDesktopFile;
+
+static void
+resolved_desktop_file_free (ResolvedDesktopFile *resolved)
+{
+  g_clear_pointer (&resolved->path, g_free);
+  g_clear_pointer (&resolved->language, g_free);
+
+  g_free (resolved);
+}
+
+/*
+ * desktop_file_resolver_new:
+ * @data_dirs: The data directories to look for desktop files in
+ *
+ * Create a resolver that lists the applications directory of each of
+ * @data_dirs once, the first time that it is used, so that looking up
+ * the desktop file of each provider doesn't need to probe every data
+ * directory for it. The listing is never refreshed, so a new resolver
+ * is needed once desktop files have been added or removed. A resolver
+ * can be shared by scans running on different threads.
  *
- * Build a GDesktopAppInfo for a .desktop file that might be in the exports
- * directory but is not necessarily executable because the binary was
- * not mounted in the bwrap jail.
+ * Returns: (transfer full): A new #DesktopFileResolver.
  */
-static GDesktopAppInfo *
-flatpak_compatible_desktop_app_info (const gchar  *desktop_id,
-                                     GError      **error)
+DesktopFileResolver *
+desktop_file_resolver_new (const gchar * const *data_dirs)
 {
-  g_auto(GStrv) data_dirs = all_relevant_data_dirs ();
-  GStrv iter = data_dirs;
+  DesktopFileResolver *resolver = g_new0 (DesktopFileResolver, 1);
 
-  for (; *iter != NULL; ++iter)
+  g_mutex_init (&resolver->lock);
+  resolver->data_dirs = g_strdupv ((GStrv) data_dirs);
+  resolver->resolved = g_hash_table_new_full (g_str_hash,
+                                              g_str_equal,
+                                              g_free,
+                                              (GDestroyNotify) resolved_desktop_file_free);
+
+  return resolver;
+}
+
+void
+desktop_file_resolver_free (DesktopFileResolver *resolver)
+{
+  g_clear_pointer (&resolver->data_dirs, g_strfreev);
+  g_clear_pointer (&resolver->candidates, g_hash_table_unref);
+  g_clear_pointer (&resolver->resolved, g_hash_table_unref);
+  g_mutex_clear (&resolver->lock);
+
+  g_free (resolver);
+}
+
+static void
+ensure_desktop_file_candidates (DesktopFileResolver *resolver)
+{
+  GStrv iter = NULL;
+
+  if (resolver->candidates != NULL)
+    return;
+
+  resolver->candidates = g_hash_table_new_full (g_str_hash,
+                                                g_str_equal,
+                                                g_free,
+                                                (GDestroyNotify) g_ptr_array_unref);
+
+  for (iter = resolver->data_dirs; *iter != NULL; ++iter)
     {
-      g_autofree gchar *path = g_build_filename (*iter,
-                                                 "applications",
-                                                 desktop_id,
-                                                 NULL);
+      g_autofree gchar *applications_path = g_build_filename (*iter, "applications", NULL);
+      g_autoptr(GDir) applications_dir = g_dir_open (applications_path, 0, NULL);
+      const gchar *name = NULL;
+
+      if (applications_dir == NULL)
+        continue;
+
+      while ((name = g_dir_read_name (applications_dir)) != NULL)
+        {
+          GPtrArray *paths = g_hash_table_lookup (resolver->candidates, name);
+
+          if (paths == NULL)
+            {
+              paths = g_ptr_array_new_with_free_func (g_free);
+              g_hash_table_insert (resolver->candidates, g_strdup (name), paths);
+            }
+
+          g_ptr_array_add (paths, g_build_filename (applications_path, name, NULL));
+        }
+    }
+}
+
+/*
+ * desktop_file_resolver_get_language:
+ * @resolver: A #DesktopFileResolver
+ * @desktop_id: The Desktop ID to look up
+ * @out_language: (out) (transfer full) (nullable): Return location for
+ *                the X-Endless-Content-Language of the desktop file
+ * @out_path: (out) (transfer full) (optional): Return location for the
+ *            path of the desktop file that was used
+ * @error: A #GError
+ *
+ * Find the desktop file for @desktop_id in the first data directory
+ * that has one, and read its content language. The desktop file might
+ * be in the exports directory of a flatpak installation, so it is read
+ * as a plain key file rather than as a #GDesktopAppInfo, which would
+ * check that the app can be executed. Each desktop file is only read
+ * once, however many providers use it.
+ *
+ * Returns: %TRUE on success, %FALSE with @error set on failure.
+ */
+gboolean
+desktop_file_resolver_get_language (DesktopFileResolver  *resolver,
+                                    const gchar          *desktop_id,
+                                    gchar               **out_language,
+                                    gchar               **out_path,
+                                    GError              **error)
+{
+  ResolvedDesktopFile *resolved = NULL;
+  GPtrArray *paths = NULL;
+  guint i = 0;
+
+  g_return_val_if_fail (out_language != NULL, FALSE);
+
+  /* Resolved desktop files and the listing are never changed once they
+   * are in the resolver, so they can be used without holding the lock */
+  g_mutex_lock (&resolver->lock);
+  resolved = g_hash_table_lookup (resolver->resolved, desktop_id);
+
+  if (resolved == NULL)
+    {
+      ensure_desktop_file_candidates (resolver);
+      paths = g_hash_table_lookup (resolver->candidates, desktop_id);
+    }
+  g_mutex_unlock (&resolver->lock);
+
+  /* A listed desktop file can still be a dangling symlink into an
+   * app that was removed, in which case we try the next one, as if we
+   * had probed each data directory for it */
+  for (i = 0; resolved == NULL && paths != NULL && i < paths->len; ++i)
+    {
+      const gchar *path = g_ptr_array_index (paths, i);
       g_autoptr(GKeyFile) key_file = g_key_file_new ();
       g_autoptr(GError) local_error = NULL;
+      ResolvedDesktopFile *existing = NULL;
 
       if (!g_key_file_load_from_file (key_file,
                                       path,
@@ -218,47 +346,50 @@ flatpak_compatible_desktop_app_info (const gchar  *desktop_id,
                                 G_FILE_ERROR_NOENT))
             {
               g_propagate_error (error, g_steal_pointer (&local_error));
-              return NULL;
+              return FALSE;
             }
 
           continue;
         }
 
-      /* Now that we have the keyfile, set the Exec line to some well-known
-       * binary so that GDesktopAppInfo doesn't trip up when we
-       * try to read it */
-      g_key_file_set_string (key_file,
-                             G_KEY_FILE_DESKTOP_GROUP,
-                             G_KEY_FILE_DESKTOP_KEY_EXEC,
-                             "/bin/true");
+      resolved = g_new0 (ResolvedDesktopFile, 1);
+      resolved->path = g_strdup (path);
+      resolved->language = g_key_file_get_string (key_file,
+                                                   G_KEY_FILE_DESKTOP_GROUP,
+                                                   "X-Endless-Content-Language",
+                                                   NULL);
 
-      return g_desktop_app_info_new_from_keyfile (key_file);
-    }
+      /* Another scan might have read the same desktop file meanwhile */
+      g_mutex_lock (&resolver->lock);
+      existing = g_hash_table_lookup (resolver->resolved, desktop_id);
 
-  g_set_error (error,
-               G_IO_ERROR,
-               G_IO_ERROR_NOT_FOUND,
-               "Desktop file was not found for %s",
-               desktop_id);
-  return NULL;
-}
-
-static gboolean
-app_language (const gchar  *desktop_id,
-              gchar       **out_language,
-              GError      **error)
-{
-  g_autoptr(GDesktopAppInfo) app_info =  NULL;
+      if (existing != NULL)
+        {
+          resolved_desktop_file_free (resolved);
+          resolved = existing;
+        }
+      else
+        {
+          g_hash_table_insert (resolver->resolved, g_strdup (desktop_id), resolved);
+        }
+      g_mutex_unlock (&resolver->lock);
+    }
 
-  g_return_val_if_fail (out_language != NULL, FALSE);
+  if (resolved == NULL)
+    {
+      g_set_error (error,
+                   G_IO_ERROR,
+                   G_IO_ERROR_NOT_FOUND,
+                   "Desktop file was not found for %s",
+                   desktop_id);
+      return FALSE;
+    }
 
-  app_info = flatpak_compatible_desktop_app_info (desktop_id, error);
+  *out_language = g_strdup (resolved->language);
 
-  if (app_info == NULL)
-    return FALSE;
+  if (out_path != NULL)
+    *out_path = g_strdup (resolved->path);
 
-  *out_language = g_desktop_app_info_get_string (app_info,
-                                                 "X-Endless-Content-Language");
   return TRUE;
 }
 
@@ -283,10 +414,155 @@ language_code_is_compatible (const gchar         *language,
   return g_strv_contains (supported_languages, language_code);
 }
 
+/*
+ * provider_lookup_load_entry:
+ * @desktop_file_resolver: A #DesktopFileResolver for the data directories
+ * @provider_file_path: The path to a provider file
+ * @dependency_paths: (element-type utf8) (nullable): Paths that the entry
+ *                    was built from are appended here, even if the
+ *                    provider file was ignored
+ * @out_entry: (out) (transfer full) (nullable): Return location for the
+ *             entry, which is %NULL if the provider file was ignored
+ * @error: A #GError
+ *
+ * Parse a single provider file. Provider files that cannot be loaded
+ * or that are missing required keys are logged and ignored, so
+ * %FALSE is only returned for errors that should fail the whole lookup.
+ *
+ * Returns: %TRUE on success, %FALSE with @error set on failure.
+ */
+gboolean
+provider_lookup_load_entry (DesktopFileResolver *desktop_file_resolver,
+                            const gchar         *provider_file_path,
+                            GPtrArray           *dependency_paths,
+                            ProviderIndexEntry **out_entry,
+                            GError             **error)
+{
+  g_autofree gchar *knowledge_app_id = NULL;
+  g_autofree gchar *knowledge_search_object_path = NULL;
+  g_autofree gchar *desktop_id = NULL;
+  g_autofree gchar *provider_object_path = NULL;
+  g_autofree gchar *provider_bus_name = NULL;
+  g_autofree gchar *provider_locale = NULL;
+  g_auto(GStrv) provider_supported_interfaces = NULL;
+  g_auto(ProviderKeyFile) key_file = PROVIDER_KEY_FILE_INIT;
+  g_autoptr(GError) enumerate_provider_error = NULL;
+
+  g_return_val_if_fail (out_entry != NULL, FALSE);
+
+  *out_entry = NULL;
+
+  if (dependency_paths != NULL)
+    g_ptr_array_add (dependency_paths, g_strdup (provider_file_path));
+
+  if (!provider_key_file_load (&key_file,
+                               provider_file_path,
+                               &enumerate_provider_error))
+    {
+      g_message ("Key file %s could not be loaded: %s (ignoring)",
+                 provider_file_path,
+                 enumerate_provider_error->message);
+      return TRUE;
+    }
+
+  if (!key_file.has_discovery_feed_section)
+    {
+      g_message ("Key file %s does not have a section called %s (ignoring)",
+                 provider_file_path,
+                 DISCOVERY_FEED_SECTION_NAME);
+      return TRUE;
+    }
+
+  if (!key_file_has_specified_keys (&key_file,
+                                    provider_file_path,
+                                    required_discovery_feed_provider_keys,
+                                    G_N_ELEMENTS (required_discovery_feed_provider_keys)))
+    return TRUE;
+
+  if (key_file.has_load_item_section)
+    {
+      knowledge_search_object_path = provider_key_file_get_string (&key_file,
+                                                                   PROVIDER_KEY_LOAD_ITEM_OBJECT_PATH,
+                                                                   NULL);
+
+      if (knowledge_search_object_path == NULL)
+        {
+          g_message ("Key file %s does not have key 'ObjectPath' in %s (ignoring)",
+                     provider_file_path,
+                     LOAD_ITEM_SECTION_NAME);
+          return TRUE;
+        }
+    }
+
+  if (!optional_get_key_file_string (&key_file,
+                                     PROVIDER_KEY_DESKTOP_ID,
+                                     NULL,
+                                     &desktop_id,
+                                     error))
+    return FALSE;
+
+  /* Now, if we have a Desktop ID, we'll want to check it to see if there's
+   * an embedded language code in the desktop file. The entry is
+   * filtered against the user's languages when it is used, since
+   * those can change without the provider files changing. */
+  if (desktop_id != NULL)
+    {
+      g_autofree gchar *desktop_file_path = NULL;
+
+      if (!desktop_file_resolver_get_language (desktop_file_resolver,
+                                               desktop_id,
+                                               &provider_locale,
+                                               &desktop_file_path,
+                                               error))
+        return FALSE;
+
+      if (dependency_paths != NULL)
+        g_ptr_array_add (dependency_paths, g_steal_pointer (&desktop_file_path));
+    }
+
+  /* We checked for the presence of all these keys earlier, so we only
+   * assert that provider_key_file_get_string succeeded */
+  provider_object_path = provider_key_file_get_string (&key_file,
+                                                       PROVIDER_KEY_OBJECT_PATH,
+                                                       NULL);
+  g_assert (provider_object_path != NULL);
+
+  provider_bus_name = provider_key_file_get_string (&key_file,
+                                                    PROVIDER_KEY_BUS_NAME,
+                                                    NULL);
+  g_assert (provider_bus_name != NULL);
+
+  provider_supported_interfaces = provider_key_file_get_string_list (&key_file,
+                                                                     PROVIDER_KEY_SUPPORTED_INTERFACES,
+                                                                     NULL);
+  g_assert (provider_supported_interfaces != NULL);
+
+  if (!optional_get_key_file_string (&key_file,
+                                     PROVIDER_KEY_APP_ID,
+                                     NULL,
+                                     &knowledge_app_id,
+                                     error))
+    return FALSE;     
+
+  *out_entry = provider_index_entry_new (provider_file_path,
+                                         provider_object_path,
+                                         provider_bus_name,
+                                         (const gchar * const *) provider_supported_interfaces,
+                                         knowledge_app_id,
+                                         desktop_id,
+                                         knowledge_search_object_path,
+                                         provider_locale);
+
+  return TRUE;
+}
+
+/* Every provider file is added to @dependency_paths, even if it was
+ * ignored, so that fixing it invalidates the provider index */
 static gboolean
-append_providers_in_directory_to_ptr_array (GFile                *directory,
-                                            const gchar * const  *languages,
-                                            GPtrArray            *providers,
+append_provider_index_entries_in_directory (DesktopFileResolver  *desktop_file_resolver,
+                                            GFile                *directory,
+                                            GPtrArray            *entries,
+                                            GPtrArray            *dependency_paths,
                                             GCancellable         *cancellable,
                                             GError              **error)
 {
@@ -311,141 +587,208 @@ append_providers_in_directory_to_ptr_array (GFile                *directory,
 
   while (g_file_enumerator_iterate (enumerator, &info, &child, cancellable, error))
     {
-      gboolean has_required_discovery_feed_provider_keys = FALSE;
       g_autofree gchar *provider_file_path = NULL;
-      g_autofree gchar *knowledge_app_id = NULL;
-      g_autofree gchar *knowledge_search_object_path = NULL;
-      g_autofree gchar *desktop_id = NULL;
-      g_autofree gchar *provider_object_path = NULL;
-      g_autofree gchar *provider_bus_name = NULL;
-      g_auto(GStrv) provider_supported_interfaces = NULL;
-      g_autoptr(GFile) candidate_provider_file = NULL;
-      g_autoptr(GKeyFile) key_file = NULL;
-      g_autoptr(GError) enumerate_provider_error = NULL;
+      g_autoptr(ProviderIndexEntry) entry = NULL;
 
       if (child == NULL || info == NULL)
         break;
 
-      candidate_provider_file = g_file_enumerator_get_child (enumerator, info);
-      provider_file_path = g_file_get_path (candidate_provider_file);
-      key_file = g_key_file_new ();
+      provider_file_path = g_file_get_path (child);
 
-      if (!g_key_file_load_from_file (key_file,
-                                      provider_file_path,
-                                      G_KEY_FILE_NONE,
-                                      &enumerate_provider_error))
-        {
-          g_message ("Key file %s could not be loaded: %s (ignoring)",
-                     provider_file_path,
-                     enumerate_provider_error->message);
-          continue;
-        }
+      if (!provider_lookup_load_entry (desktop_file_resolver,
+                                       provider_file_path,
+                                       dependency_paths,
+                                       &entry,
+                                       error))
+        return FALSE;
 
-      if (!g_key_file_has_group (key_file, DISCOVERY_FEED_SECTION_NAME))
-        {
-          g_message ("Key file %s does not have a section called %s (ignoring)",
-                     provider_file_path,
-                     DISCOVERY_FEED_SECTION_NAME);
-          continue;
-        }
+      if (entry != NULL)
+        g_ptr_array_add (entries, g_steal_pointer (&entry));
+    }
 
-      if (!key_file_has_specified_keys_in_section (key_file,
-                                                   provider_file_path,
-                                                   DISCOVERY_FEED_SECTION_NAME,
-                                                   required_discovery_feed_provider_keys,
-                                                   &has_required_discovery_feed_provider_keys,
-                                                   error))
-        return FALSE;
+  return TRUE;
+}
 
-      if (!has_required_discovery_feed_provider_keys)
-        continue;
+/* Provider files are mostly on slow storage, so scan a few directories
+ * at once without competing with each other for the disk too much */
+#define MAX_SCAN_THREADS 4
 
-      if (g_key_file_has_group (key_file, LOAD_ITEM_SECTION_NAME))
-        {
-          knowledge_search_object_path = g_key_file_get_string (key_file,
-                                                                LOAD_ITEM_SECTION_NAME,
-                                                                "ObjectPath",
-                                                                NULL);
+typedef struct _DirectoryScan
+{
+  gchar               *path;
+  DesktopFileResolver *desktop_file_resolver;  /* (unowned) */
+  GCancellable        *cancellable;            /* (unowned) */
+  GPtrArray           *entries;
+  GPtrArray           *dependency_paths;
+  GError              *error;
+} DirectoryScan;
 
-          if (knowledge_search_object_path == NULL)
-            {
-              g_message ("Key file %s does not have key 'ObjectPath' in %s (ignoring)",
-                         provider_file_path,
-                         LOAD_ITEM_SECTION_NAME);
-              continue;
-            }
-        }
+static void
+directory_scan_free (DirectoryScan *scan)
+{
+  g_clear_pointer (&scan->path, g_free);
+  g_clear_pointer (&scan->entries, g_ptr_array_unref);
+  g_clear_pointer (&scan->dependency_paths, g_ptr_array_unref);
+  g_clear_error (&scan->error);
 
-      if (!optional_get_key_file_string (key_file,
-                                         DISCOVERY_FEED_SECTION_NAME,
-                                         "DesktopId",
-                                         NULL,
-                                         &desktop_id,
-                                         error))
-        return FALSE;
+  g_free (scan);
+}
 
-      /* Now, if we have a Desktop ID, we'll want to check it to see if there's
-       * an embedded language code in the desktop file. If so, filter out this
-       * application if it would not be compatible. */
-      if (desktop_id != NULL)
-        {
-          g_autofree gchar *provider_locale = NULL;
+static void
+scan_directory_thread (gpointer data,
+                       gpointer user_data G_GNUC_UNUSED)
+{
+  DirectoryScan *scan = data;
+  g_autoptr(GFile) directory = g_file_new_for_path (scan->path);
+
+  append_provider_index_entries_in_directory (scan->desktop_file_resolver,
+                                              directory,
+                                              scan->entries,
+                                              scan->dependency_paths,
+                                              scan->cancellable,
+                                              &scan->error);
+}
 
-          if (!app_language (desktop_id, &provider_locale, error))
-            return FALSE;
+static GPtrArray *
+scan_provider_index_entries (const gchar * const  *data_directories,
+                             GCancellable         *cancellable,
+                             GError              **error)
+{
+  g_autoptr(GPtrArray) entries = g_ptr_array_new_with_free_func ((GDestroyNotify) provider_index_entry_free);
+  g_autoptr(GPtrArray) dependency_paths = g_ptr_array_new_with_free_func (g_free);
+  g_autoptr(GPtrArray) scans = g_ptr_array_new_with_free_func ((GDestroyNotify) directory_scan_free);
+  gint64 scan_started = g_get_real_time () / G_USEC_PER_SEC;
+  g_autoptr(DesktopFileResolver) desktop_file_resolver = desktop_file_resolver_new (data_directories);
+  const gchar * const *iter = data_directories;
+  GThreadPool *pool = NULL;
+  guint i = 0;
+  guint j = 0;
 
-          if (provider_locale != NULL &&
-              !language_code_is_compatible (provider_locale, languages))
-            {
-              g_autofree gchar *language_codes_joined = g_strjoinv (", ", (GStrv) languages);
-              g_message ("Language code %s in provider %s is not compatible "
-                         "with language codes %s (ignoring)",
-                         provider_locale,
-                         provider_file_path,
-                         language_codes_joined);
-              continue;  
-            }
+  for (; *iter != NULL; ++iter)
+    {
+      DirectoryScan *scan = g_new0 (DirectoryScan, 1);
+
+      scan->path = g_build_filename (*iter,
+                                     "eos-discovery-feed",
+                                     "content-providers",
+                                     NULL);
+      scan->desktop_file_resolver = desktop_file_resolver;
+      scan->cancellable = cancellable;
+      scan->entries = g_ptr_array_new_with_free_func ((GDestroyNotify) provider_index_entry_free);
+      scan->dependency_paths = g_ptr_array_new_with_free_func (g_free);
+
+      /* Desktop files being added to or removed from any of the
+       * applications directories can change which one a provider
+       * resolves to */
+      g_ptr_array_add (scan->dependency_paths, g_strdup (scan->path));
+      g_ptr_array_add (scan->dependency_paths, g_build_filename (*iter, "applications", NULL));
+
+      g_ptr_array_add (scans, scan);
+    }
+
+  /* Scan the directories concurrently, then merge the results in the
+   * order of the data directories, so that the providers come out in
+   * the same order as if they were scanned one after the other */
+  pool = g_thread_pool_new (scan_directory_thread,
+                            NULL,
+                            MAX (1, MIN (scans->len, MAX_SCAN_THREADS)),
+                            FALSE,
+                            NULL);
+
+  for (i = 0; i < scans->len; ++i)
+    {
+      DirectoryScan *scan = g_ptr_array_index (scans, i);
+
+      if (pool == NULL || !g_thread_pool_push (pool, scan, NULL))
+        scan_directory_thread (scan, NULL);
+    }
+
+  /* Waits for all of the scans to finish */
+  if (pool != NULL)
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+  for (i = 0; i < scans->len; ++i)
+    {
+      DirectoryScan *scan = g_ptr_array_index (scans, i);
+
+      if (scan->error != NULL)
+        {
+          g_propagate_error (error, g_steal_pointer (&scan->error));
+          return NULL;
         }
 
-      /* We checked for the presence of all these keys earlier, so we only
-       * assert that g_key_file_get_string succeeded */
-      provider_object_path = g_key_file_get_string (key_file,
-                                                    DISCOVERY_FEED_SECTION_NAME,
-                                                    "ObjectPath",
-                                                    NULL);
-      g_assert (provider_object_path != NULL);
-
-      provider_bus_name = g_key_file_get_string (key_file,
-                                                 DISCOVERY_FEED_SECTION_NAME,
-                                                 "BusName",
-                                                 NULL);
-      g_assert (provider_bus_name != NULL);
-
-      provider_supported_interfaces = g_key_file_get_string_list (key_file,
-                                                                  DISCOVERY_FEED_SECTION_NAME,
-                                                                  "SupportedInterfaces",
-                                                                  NULL,
-                                                                  NULL);
-      g_assert (provider_supported_interfaces != NULL);
-
-      if (!optional_get_key_file_string (key_file,
-                                         DISCOVERY_FEED_SECTION_NAME,
-                                         "AppID",
-                                         NULL,
-                                         &knowledge_app_id,
-                                         error))
-        return FALSE;     
-
-      g_ptr_array_add (providers,
-                       content_feed_provider_info_new (provider_object_path,
-                                                       provider_bus_name,
-                                                       (const gchar * const *) provider_supported_interfaces,
-                                                       knowledge_app_id,
-                                                       desktop_id,
-                                                       knowledge_search_object_path));
+      /* The merged arrays take ownership of the elements */
+      for (j = 0; j < scan->entries->len; ++j)
+        g_ptr_array_add (entries, g_ptr_array_index (scan->entries, j));
+      g_ptr_array_set_free_func (scan->entries, NULL);
+
+      for (j = 0; j < scan->dependency_paths->len; ++j)
+        g_ptr_array_add (dependency_paths, g_ptr_array_index (scan->dependency_paths, j));
+      g_ptr_array_set_free_func (scan->dependency_paths, NULL);
     }
 
-  return TRUE;
+  provider_index_save (data_directories, entries, dependency_paths, scan_started);
+
+  return g_steal_pointer (&entries);
+}
+
+/*
+ * provider_lookup_entries:
+ * @data_directories: The data directories to look up providers in
+ * @cancellable: A #GCancellable
+ * @error: A #GError
+ *
+ * Get the entries for every provider file in @data_directories, from
+ * the provider index if it is still valid, or by scanning the
+ * directories otherwise. This does blocking I/O.
+ *
+ * Returns: (transfer full) (element-type ProviderIndexEntry): The
+ *          entries in the order they were found, or %NULL on error.
+ */
+GPtrArray *
+provider_lookup_entries (const gchar * const  *data_directories,
+                         GCancellable         *cancellable,
+                         GError              **error)
+{
+  g_autoptr(GPtrArray) entries = provider_index_load (data_directories);
+
+  if (entries != NULL)
+    return g_steal_pointer (&entries);
+
+  return scan_provider_index_entries (data_directories, cancellable, error);
+}
+
+/*
+ * provider_lookup_info_for_entry:
+ * @entry: A #ProviderIndexEntry
+ * @languages: The supported user languages
+ *
+ * Returns: (transfer full) (nullable): A #ContentFeedProviderInfo for
+ *          @entry, or %NULL if its language is not compatible with
+ *          @languages.
+ */
+ContentFeedProviderInfo *
+provider_lookup_info_for_entry (ProviderIndexEntry  *entry,
+                                const gchar * const *languages)
+{
+  if (entry->language != NULL &&
+      !language_code_is_compatible (entry->language, languages))
+    {
+      g_autofree gchar *language_codes_joined = g_strjoinv (", ", (GStrv) languages);
+      g_message ("Language code %s in provider %s is not compatible "
+                 "with language codes %s (ignoring)",
+                 entry->language,
+                 entry->provider_file_path,
+                 language_codes_joined);
+      return NULL;
+    }
+
+  return content_feed_provider_info_new (entry->object_path,
+                                         entry->bus_name,
+                                         (const gchar * const *) entry->supported_interfaces,
+                                         entry->knowledge_app_id,
+                                         entry->desktop_id,
+                                         entry->knowledge_search_object_path);
 }
 
 static GStrv
@@ -468,8 +811,14 @@ get_force_additional_languages_from_gsettings (void)
   return g_strdupv ((GStrv) empty);
 }
 
-static GStrv
-supported_languages (void)
+/*
+ * provider_lookup_supported_languages:
+ *
+ * Returns: (transfer full): The user's languages, along with any that
+ *          were forced in the settings and the "*" wildcard.
+ */
+GStrv
+provider_lookup_supported_languages (void)
 {
   GPtrArray *languages = g_ptr_array_new ();
   const gchar * const *system_languages = g_get_language_names ();
@@ -492,25 +841,25 @@ static GPtrArray *
 lookup_providers (GCancellable  *cancellable,
                   GError       **error)
 {
-  g_auto(GStrv) data_directories = all_relevant_data_dirs ();
-  g_auto(GStrv) languages = supported_languages ();
+  g_auto(GStrv) data_directories = provider_lookup_data_dirs ();
+  g_auto(GStrv) languages = provider_lookup_supported_languages ();
   g_autoptr(GPtrArray) providers = g_ptr_array_new_with_free_func (g_object_unref);
-  GStrv iter = data_directories;
+  g_autoptr(GPtrArray) entries = provider_lookup_entries ((const gchar * const *) data_directories,
+                                                          cancellable,
+                                                          error);
+  guint i = 0;
 
-  for (; *iter != NULL; ++iter)
+  if (entries == NULL)
+    return NULL;
+
+  for (i = 0; i < entries->len; ++i)
     {
-      g_autofree gchar *path = g_build_filename (*iter,
-                                                 "eos-discovery-feed",
-                                                 "content-providers",
-                                                 NULL);
-      g_autoptr(GFile) directory = g_file_new_for_path (path);
-
-      if (!append_providers_in_directory_to_ptr_array (directory,
-                                                       (const gchar * const *) languages,
-                                                       providers,
-                                                       cancellable,
-                                                       error))
-        return NULL;
+      ContentFeedProviderInfo *info =
+        provider_lookup_info_for_entry (g_ptr_array_index (entries, i),
+                                        (const gchar * const *) languages);
+
+      if (info != NULL)
+        g_ptr_array_add (providers, info);
     }
 
   return g_steal_pointer (&providers);
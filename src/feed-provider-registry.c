@@ -0,0 +1,777 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "feed-provider-index-private.h"
+#include "feed-provider-lookup-private.h"
+#include "feed-provider-registry.h"
+
+/**
+ * SECTION:provider-registry
+ * @title: Provider Registry
+ * @short_description: Live set of providers, kept current by file monitors
+ *
+ * A #ContentFeedProviderRegistry finds the same providers that
+ * content_feed_find_providers() does, but then keeps watching the
+ * content-providers directory and the applications directory of
+ * each data directory, along with the exports/share directory of each
+ * flatpak installation. When an app is installed, updated or removed,
+ * only the provider files that changed are parsed again, and the
+ * #ContentFeedProviderRegistry::provider-added and
+ * #ContentFeedProviderRegistry::provider-removed signals are emitted.
+ *
+ * A provider whose provider file changed is removed and then added
+ * again with a new #ContentFeedProviderInfo. The user's languages are
+ * read once, when the registry is loaded.
+ */
+
+/* Each monitor on a content-providers directory keeps its path here */
+#define MONITORED_DIRECTORY_KEY "content-feed-monitored-directory"
+
+typedef struct _RegisteredProvider
+{
+  ProviderIndexEntry      *entry;
+  ContentFeedProviderInfo *info;  /* (nullable): If the language is not compatible */
+} RegisteredProvider;
+
+static void
+registered_provider_free (RegisteredProvider *provider)
+{
+  g_clear_pointer (&provider->entry, provider_index_entry_free);
+  g_clear_object (&provider->info);
+
+  g_free (provider);
+}
+
+struct _ContentFeedProviderRegistry
+{
+  GObject object;
+};
+
+typedef struct _ContentFeedProviderRegistryPrivate
+{
+  GStrv       data_dirs;
+  GStrv       languages;
+  GPtrArray  *providers;     /* (element-type RegisteredProvider) */
+  GHashTable *failed_paths;  /* Provider files that failed to load, retried when desktop files change */
+  DesktopFileResolver *desktop_file_resolver;  /* (nullable): Dropped when desktop files change */
+  GPtrArray  *monitors;      /* (element-type GFileMonitor) */
+  gboolean    loaded;
+  gboolean    changed_while_loading;
+} ContentFeedProviderRegistryPrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE (ContentFeedProviderRegistry,
+                            content_feed_provider_registry,
+                            G_TYPE_OBJECT)
+
+enum {
+  SIGNAL_PROVIDER_ADDED,
+  SIGNAL_PROVIDER_REMOVED,
+  NSIGNALS
+};
+
+static guint content_feed_provider_registry_signals [NSIGNALS] = { 0, };
+
+static gboolean
+strv_equal (const gchar * const *a,
+            const gchar * const *b)
+{
+  for (; *a != NULL && *b != NULL; ++a, ++b)
+    if (g_strcmp0 (*a, *b) != 0)
+      return FALSE;
+
+  return *a == NULL && *b == NULL;
+}
+
+static gboolean
+provider_index_entries_equal (ProviderIndexEntry *a,
+                              ProviderIndexEntry *b)
+{
+  return g_strcmp0 (a->provider_file_path, b->provider_file_path) == 0 &&
+         g_strcmp0 (a->object_path, b->object_path) == 0 &&
+         g_strcmp0 (a->bus_name, b->bus_name) == 0 &&
+         strv_equal ((const gchar * const *) a->supported_interfaces,
+                     (const gchar * const *) b->supported_interfaces) &&
+         g_strcmp0 (a->knowledge_app_id, b->knowledge_app_id) == 0 &&
+         g_strcmp0 (a->desktop_id, b->desktop_id) == 0 &&
+         g_strcmp0 (a->knowledge_search_object_path, b->knowledge_search_object_path) == 0 &&
+         g_strcmp0 (a->language, b->language) == 0;
+}
+
+static gboolean
+find_registered_provider (ContentFeedProviderRegistry *registry,
+                          const gchar                 *provider_file_path,
+                          guint                       *out_index)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  guint i = 0;
+
+  for (i = 0; i < priv->providers->len; ++i)
+    {
+      RegisteredProvider *provider = g_ptr_array_index (priv->providers, i);
+
+      if (g_strcmp0 (provider->entry->provider_file_path, provider_file_path) == 0)
+        {
+          *out_index = i;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static void
+remove_provider (ContentFeedProviderRegistry *registry,
+                 const gchar                 *provider_file_path)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  RegisteredProvider *provider = NULL;
+  g_autoptr(ContentFeedProviderInfo) info = NULL;
+  guint index = 0;
+
+  g_hash_table_remove (priv->failed_paths, provider_file_path);
+
+  if (!find_registered_provider (registry, provider_file_path, &index))
+    return;
+
+  /* Remove it before emitting the signal, so that handlers don't see it */
+  provider = g_ptr_array_index (priv->providers, index);
+  info = provider->info != NULL ? g_object_ref (provider->info) : NULL;
+  g_ptr_array_remove_index (priv->providers, index);
+
+  if (info != NULL)
+    g_signal_emit (registry,
+                   content_feed_provider_registry_signals[SIGNAL_PROVIDER_REMOVED],
+                   0,
+                   info);
+}
+
+static void
+set_provider (ContentFeedProviderRegistry *registry,
+              ProviderIndexEntry          *entry)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  RegisteredProvider *provider = NULL;
+  guint index = 0;
+
+  if (find_registered_provider (registry, entry->provider_file_path, &index))
+    {
+      RegisteredProvider *existing = g_ptr_array_index (priv->providers, index);
+
+      /* Creating a file is usually followed by a hint that it is done
+       * changing, so don't report the same provider twice */
+      if (provider_index_entries_equal (existing->entry, entry))
+        {
+          provider_index_entry_free (entry);
+          return;
+        }
+
+      remove_provider (registry, entry->provider_file_path);
+    }
+
+  provider = g_new0 (RegisteredProvider, 1);
+  provider->entry = entry;
+  provider->info = provider_lookup_info_for_entry (entry,
+                                                   (const gchar * const *) priv->languages);
+  g_ptr_array_add (priv->providers, provider);
+
+  if (provider->info != NULL)
+    g_signal_emit (registry,
+                   content_feed_provider_registry_signals[SIGNAL_PROVIDER_ADDED],
+                   0,
+                   provider->info);
+}
+
+static DesktopFileResolver *
+ensure_desktop_file_resolver (ContentFeedProviderRegistry *registry)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+
+  if (priv->desktop_file_resolver == NULL)
+    priv->desktop_file_resolver = desktop_file_resolver_new ((const gchar * const *) priv->data_dirs);
+
+  return priv->desktop_file_resolver;
+}
+
+static void
+reload_provider_file (ContentFeedProviderRegistry *registry,
+                      const gchar                 *provider_file_path)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(ProviderIndexEntry) entry = NULL;
+
+  if (!provider_lookup_load_entry (ensure_desktop_file_resolver (registry),
+                                   provider_file_path,
+                                   NULL,
+                                   &entry,
+                                   &local_error))
+    {
+      g_message ("Could not reload provider file %s: %s (ignoring)",
+                 provider_file_path,
+                 local_error->message);
+      remove_provider (registry, provider_file_path);
+
+      /* Most likely its desktop file is not there yet */
+      g_hash_table_add (priv->failed_paths, g_strdup (provider_file_path));
+      return;
+    }
+
+  if (entry == NULL)
+    {
+      remove_provider (registry, provider_file_path);
+      return;
+    }
+
+  g_hash_table_remove (priv->failed_paths, provider_file_path);
+  set_provider (registry, g_steal_pointer (&entry));
+}
+
+static void
+reload_directory (ContentFeedProviderRegistry *registry,
+                  const gchar                 *directory_path)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_autoptr(GDir) directory = g_dir_open (directory_path, 0, NULL);
+  g_autoptr(GPtrArray) present_paths = g_ptr_array_new_with_free_func (g_free);
+  g_autoptr(GPtrArray) stale_paths = g_ptr_array_new_with_free_func (g_free);
+  GHashTableIter iter;
+  gpointer key = NULL;
+  const gchar *name = NULL;
+  guint i = 0;
+
+  /* The directory not existing just means that every provider in it
+   * went away */
+  if (directory != NULL)
+    while ((name = g_dir_read_name (directory)) != NULL)
+      g_ptr_array_add (present_paths, g_build_filename (directory_path, name, NULL));
+
+  for (i = 0; i < priv->providers->len; ++i)
+    {
+      RegisteredProvider *provider = g_ptr_array_index (priv->providers, i);
+      g_autofree gchar *provider_directory = g_path_get_dirname (provider->entry->provider_file_path);
+
+      if (g_strcmp0 (provider_directory, directory_path) == 0)
+        g_ptr_array_add (stale_paths, g_strdup (provider->entry->provider_file_path));
+    }
+
+  g_hash_table_iter_init (&iter, priv->failed_paths);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      g_autofree gchar *failed_directory = g_path_get_dirname (key);
+
+      if (g_strcmp0 (failed_directory, directory_path) == 0)
+        g_ptr_array_add (stale_paths, g_strdup (key));
+    }
+
+  for (i = 0; i < stale_paths->len; ++i)
+    {
+      const gchar *path = g_ptr_array_index (stale_paths, i);
+
+      if (!g_ptr_array_find_with_equal_func (present_paths, path, g_str_equal, NULL))
+        remove_provider (registry, path);
+    }
+
+  for (i = 0; i < present_paths->len; ++i)
+    reload_provider_file (registry, g_ptr_array_index (present_paths, i));
+}
+
+static void
+reload_all_directories (ContentFeedProviderRegistry *registry)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  GStrv iter = priv->data_dirs;
+
+  g_clear_pointer (&priv->desktop_file_resolver, desktop_file_resolver_free);
+
+  for (; *iter != NULL; ++iter)
+    {
+      g_autofree gchar *path = g_build_filename (*iter,
+                                                 "eos-discovery-feed",
+                                                 "content-providers",
+                                                 NULL);
+
+      reload_directory (registry, path);
+    }
+}
+
+static void
+reload_providers_for_desktop_id (ContentFeedProviderRegistry *registry,
+                                 const gchar                 *desktop_id)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_autoptr(GPtrArray) paths = g_ptr_array_new_with_free_func (g_free);
+  GHashTableIter iter;
+  gpointer key = NULL;
+  guint i = 0;
+
+  for (i = 0; i < priv->providers->len; ++i)
+    {
+      RegisteredProvider *provider = g_ptr_array_index (priv->providers, i);
+
+      if (g_strcmp0 (provider->entry->desktop_id, desktop_id) == 0)
+        g_ptr_array_add (paths, g_strdup (provider->entry->provider_file_path));
+    }
+
+  /* We don't know which desktop file a provider that failed to load
+   * was waiting for, so retry all of them */
+  g_hash_table_iter_init (&iter, priv->failed_paths);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    g_ptr_array_add (paths, g_strdup (key));
+
+  for (i = 0; i < paths->len; ++i)
+    reload_provider_file (registry, g_ptr_array_index (paths, i));
+}
+
+/* Returns TRUE if the event should be handled now, or FALSE if it
+ * arrived before the providers were loaded, in which case everything
+ * is reloaded once they are */
+static gboolean
+check_loaded (ContentFeedProviderRegistry *registry)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+
+  if (priv->loaded)
+    return TRUE;
+
+  priv->changed_while_loading = TRUE;
+  return FALSE;
+}
+
+static void
+content_providers_directory_changed (GFileMonitor      *monitor,
+                                     GFile             *file,
+                                     GFile             *other_file,
+                                     GFileMonitorEvent  event_type,
+                                     gpointer           user_data)
+{
+  ContentFeedProviderRegistry *registry = user_data;
+  const gchar *directory_path = g_object_get_data (G_OBJECT (monitor), MONITORED_DIRECTORY_KEY);
+  g_autofree gchar *path = g_file_get_path (file);
+  g_autofree gchar *other_path = NULL;
+
+  if (!check_loaded (registry))
+    return;
+
+  /* The directory itself was created or removed */
+  if (g_strcmp0 (path, directory_path) == 0)
+    {
+      reload_directory (registry, directory_path);
+      return;
+    }
+
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+      reload_provider_file (registry, path);
+      break;
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+      remove_provider (registry, path);
+      break;
+    case G_FILE_MONITOR_EVENT_RENAMED:
+      other_path = g_file_get_path (other_file);
+      remove_provider (registry, path);
+      reload_provider_file (registry, other_path);
+      break;
+    default:
+      break;
+    }
+}
+
+static void
+applications_directory_changed (GFileMonitor      *monitor G_GNUC_UNUSED,
+                                GFile             *file,
+                                GFile             *other_file,
+                                GFileMonitorEvent  event_type,
+                                gpointer           user_data)
+{
+  ContentFeedProviderRegistry *registry = user_data;
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_autofree gchar *desktop_id = g_file_get_basename (file);
+
+  if (!check_loaded (registry))
+    return;
+
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+    case G_FILE_MONITOR_EVENT_RENAMED:
+      break;
+    default:
+      return;
+    }
+
+  /* The listing of desktop files is out of date */
+  g_clear_pointer (&priv->desktop_file_resolver, desktop_file_resolver_free);
+
+  if (event_type == G_FILE_MONITOR_EVENT_RENAMED)
+    {
+      g_autofree gchar *other_desktop_id = g_file_get_basename (other_file);
+
+      reload_providers_for_desktop_id (registry, other_desktop_id);
+    }
+
+  reload_providers_for_desktop_id (registry, desktop_id);
+}
+
+/* The content-providers directory of a flatpak installation does not
+ * exist until the first app that has one is installed, so watch the
+ * exports/share directory for it appearing */
+static void
+flatpak_exports_directory_changed (GFileMonitor      *monitor G_GNUC_UNUSED,
+                                   GFile             *file,
+                                   GFile             *other_file G_GNUC_UNUSED,
+                                   GFileMonitorEvent  event_type,
+                                   gpointer           user_data)
+{
+  ContentFeedProviderRegistry *registry = user_data;
+  g_autoptr(GFile) exports_directory = NULL;
+  g_autofree gchar *exports_path = NULL;
+  g_autofree gchar *name = g_file_get_basename (file);
+  g_autofree gchar *content_providers_path = NULL;
+
+  if (!check_loaded (registry))
+    return;
+
+  if (g_strcmp0 (name, "eos-discovery-feed") != 0)
+    return;
+
+  switch (event_type)
+    {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_IN:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT:
+      exports_directory = g_file_get_parent (file);
+      exports_path = g_file_get_path (exports_directory);
+      content_providers_path = g_build_filename (exports_path,
+                                                 "eos-discovery-feed",
+                                                 "content-providers",
+                                                 NULL);
+      reload_directory (registry, content_providers_path);
+      break;
+    default:
+      break;
+    }
+}
+
+static void
+add_monitor (ContentFeedProviderRegistry *registry,
+             const gchar                 *path,
+             GCallback                    changed_callback)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_autoptr(GFile) directory = g_file_new_for_path (path);
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GFileMonitor) monitor = g_file_monitor_directory (directory,
+                                                              G_FILE_MONITOR_WATCH_MOVES,
+                                                              NULL,
+                                                              &local_error);
+
+  if (monitor == NULL)
+    {
+      g_message ("Could not monitor %s for provider changes: %s",
+                 path,
+                 local_error->message);
+      return;
+    }
+
+  g_object_set_data_full (G_OBJECT (monitor),
+                          MONITORED_DIRECTORY_KEY,
+                          g_strdup (path),
+                          g_free);
+  g_signal_connect (monitor, "changed", changed_callback, registry);
+  g_ptr_array_add (priv->monitors, g_steal_pointer (&monitor));
+}
+
+static void
+start_monitoring (ContentFeedProviderRegistry *registry)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_auto(GStrv) flatpak_exports_dirs = provider_lookup_flatpak_exports_dirs ();
+  GStrv iter = NULL;
+
+  for (iter = priv->data_dirs; *iter != NULL; ++iter)
+    {
+      g_autofree gchar *content_providers_path = g_build_filename (*iter,
+                                                                   "eos-discovery-feed",
+                                                                   "content-providers",
+                                                                   NULL);
+      g_autofree gchar *applications_path = g_build_filename (*iter,
+                                                              "applications",
+                                                              NULL);
+
+      add_monitor (registry,
+                   content_providers_path,
+                   G_CALLBACK (content_providers_directory_changed));
+      add_monitor (registry,
+                   applications_path,
+                   G_CALLBACK (applications_directory_changed));
+    }
+
+  for (iter = flatpak_exports_dirs; *iter != NULL; ++iter)
+    add_monitor (registry,
+                 *iter,
+                 G_CALLBACK (flatpak_exports_directory_changed));
+}
+
+/**
+ * content_feed_provider_registry_get_providers:
+ * @registry: A #ContentFeedProviderRegistry
+ *
+ * Get the providers that are currently installed, in the same order
+ * that content_feed_find_providers() would find them in, followed by
+ * any that were added since the registry was loaded.
+ *
+ * Returns: (transfer full) (element-type ContentFeedProviderInfo): A
+ *          #GPtrArray of #ContentFeedProviderInfo.
+ */
+GPtrArray *
+content_feed_provider_registry_get_providers (ContentFeedProviderRegistry *registry)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_autoptr(GPtrArray) infos = g_ptr_array_new_with_free_func (g_object_unref);
+  guint i = 0;
+
+  for (i = 0; i < priv->providers->len; ++i)
+    {
+      RegisteredProvider *provider = g_ptr_array_index (priv->providers, i);
+
+      if (provider->info != NULL)
+        g_ptr_array_add (infos, g_object_ref (provider->info));
+    }
+
+  return g_steal_pointer (&infos);
+}
+
+static void
+content_feed_provider_registry_init (ContentFeedProviderRegistry *registry)
+{
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+
+  priv->data_dirs = provider_lookup_data_dirs ();
+  priv->languages = provider_lookup_supported_languages ();
+  priv->providers = g_ptr_array_new_with_free_func ((GDestroyNotify) registered_provider_free);
+  priv->failed_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  priv->monitors = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+static void
+content_feed_provider_registry_dispose (GObject *object)
+{
+  ContentFeedProviderRegistry *registry = CONTENT_FEED_PROVIDER_REGISTRY (object);
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  guint i = 0;
+
+  for (i = 0; priv->monitors != NULL && i < priv->monitors->len; ++i)
+    {
+      GFileMonitor *monitor = g_ptr_array_index (priv->monitors, i);
+
+      g_signal_handlers_disconnect_by_data (monitor, registry);
+      g_file_monitor_cancel (monitor);
+    }
+
+  g_clear_pointer (&priv->monitors, g_ptr_array_unref);
+
+  G_OBJECT_CLASS (content_feed_provider_registry_parent_class)->dispose (object);
+}
+
+static void
+content_feed_provider_registry_finalize (GObject *object)
+{
+  ContentFeedProviderRegistry *registry = CONTENT_FEED_PROVIDER_REGISTRY (object);
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+
+  g_clear_pointer (&priv->data_dirs, g_strfreev);
+  g_clear_pointer (&priv->languages, g_strfreev);
+  g_clear_pointer (&priv->providers, g_ptr_array_unref);
+  g_clear_pointer (&priv->failed_paths, g_hash_table_unref);
+  g_clear_pointer (&priv->desktop_file_resolver, desktop_file_resolver_free);
+
+  G_OBJECT_CLASS (content_feed_provider_registry_parent_class)->finalize (object);
+}
+
+static void
+content_feed_provider_registry_class_init (ContentFeedProviderRegistryClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = content_feed_provider_registry_dispose;
+  object_class->finalize = content_feed_provider_registry_finalize;
+
+  /**
+   * ContentFeedProviderRegistry::provider-added:
+   * @registry: The #ContentFeedProviderRegistry
+   * @provider_info: The #ContentFeedProviderInfo that was added
+   *
+   * Emitted when a provider is installed, or when its provider file
+   * changes, after #ContentFeedProviderRegistry::provider-removed was
+   * emitted for the old #ContentFeedProviderInfo.
+   */
+  content_feed_provider_registry_signals[SIGNAL_PROVIDER_ADDED] =
+    g_signal_new ("provider-added",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL,
+                  NULL,
+                  NULL,
+                  G_TYPE_NONE,
+                  1,
+                  CONTENT_FEED_TYPE_PROVIDER_INFO);
+
+  /**
+   * ContentFeedProviderRegistry::provider-removed:
+   * @registry: The #ContentFeedProviderRegistry
+   * @provider_info: The #ContentFeedProviderInfo that was removed
+   *
+   * Emitted when a provider is removed, or when its provider file
+   * changes.
+   */
+  content_feed_provider_registry_signals[SIGNAL_PROVIDER_REMOVED] =
+    g_signal_new ("provider-removed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL,
+                  NULL,
+                  NULL,
+                  G_TYPE_NONE,
+                  1,
+                  CONTENT_FEED_TYPE_PROVIDER_INFO);
+}
+
+static void
+load_entries_thread (GTask        *task,
+                     gpointer      source,
+                     gpointer      task_data G_GNUC_UNUSED,
+                     GCancellable *cancellable)
+{
+  ContentFeedProviderRegistry *registry = source;
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GPtrArray) entries = provider_lookup_entries ((const gchar * const *) priv->data_dirs,
+                                                          cancellable,
+                                                          &local_error);
+
+  if (entries == NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&local_error));
+      return;
+    }
+
+  g_task_return_pointer (task,
+                         g_steal_pointer (&entries),
+                         (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+received_entries (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  ContentFeedProviderRegistry *registry = CONTENT_FEED_PROVIDER_REGISTRY (source);
+  ContentFeedProviderRegistryPrivate *priv = content_feed_provider_registry_get_instance_private (registry);
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GPtrArray) entries = g_task_propagate_pointer (G_TASK (result), &local_error);
+  guint i = 0;
+
+  if (entries == NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&local_error));
+      return;
+    }
+
+  /* Nobody can be connected to the signals yet, so there is no
+   * need to emit them */
+  for (i = 0; i < entries->len; ++i)
+    {
+      RegisteredProvider *provider = g_new0 (RegisteredProvider, 1);
+
+      provider->entry = g_ptr_array_index (entries, i);
+      provider->info = provider_lookup_info_for_entry (provider->entry,
+                                                       (const gchar * const *) priv->languages);
+      g_ptr_array_add (priv->providers, provider);
+    }
+
+  /* The entries are now owned by the registered providers */
+  g_ptr_array_set_free_func (entries, NULL);
+
+  priv->loaded = TRUE;
+
+  /* Something changed while the directories were being scanned, and we
+   * don't know whether the scan saw it */
+  if (priv->changed_while_loading)
+    reload_all_directories (registry);
+
+  g_task_return_pointer (task, g_object_ref (registry), g_object_unref);
+}
+
+/**
+ * content_feed_provider_registry_load_finish:
+ * @result: A #GAsyncResult
+ * @error: A #GError
+ *
+ * Complete a call to content_feed_provider_registry_load().
+ *
+ * Returns: (transfer full): A #ContentFeedProviderRegistry, or %NULL
+ *          on error.
+ */
+ContentFeedProviderRegistry *
+content_feed_provider_registry_load_finish (GAsyncResult  *result,
+                                            GError       **error)
+{
+  GTask *task = G_TASK (result);
+  return g_task_propagate_pointer (task, error);
+}
+
+/**
+ * content_feed_provider_registry_load:
+ * @cancellable: A #GCancellable
+ * @callback: (scope async): Callback function
+ * @user_data: Closure for @callback
+ *
+ * Create a #ContentFeedProviderRegistry, and look up all provider files
+ * on the filesystem in the background. The registry starts watching
+ * for changes before the lookup starts, so nothing that changes in
+ * the meantime is missed. Use content_feed_provider_registry_load_finish()
+ * to complete the call.
+ */
+void
+content_feed_provider_registry_load (GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  g_autoptr(ContentFeedProviderRegistry) registry = g_object_new (CONTENT_FEED_TYPE_PROVIDER_REGISTRY, NULL);
+  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
+  g_autoptr(GTask) entries_task = g_task_new (registry,
+                                              cancellable,
+                                              received_entries,
+                                              g_object_ref (task));
+
+  start_monitoring (registry);
+  g_task_run_in_thread (entries_task, load_entries_thread);
+}
@@ -0,0 +1,38 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <feed-provider-info.h>
+#include <gio/gio.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define CONTENT_FEED_TYPE_PROVIDER_REGISTRY content_feed_provider_registry_get_type ()
+G_DECLARE_FINAL_TYPE (ContentFeedProviderRegistry, content_feed_provider_registry, CONTENT_FEED, PROVIDER_REGISTRY, GObject)
+
+GPtrArray * content_feed_provider_registry_get_providers (ContentFeedProviderRegistry *registry);
+
+ContentFeedProviderRegistry * content_feed_provider_registry_load_finish (GAsyncResult  *result,
+                                                                          GError       **error);
+
+void content_feed_provider_registry_load (GCancellable        *cancellable,
+                                          GAsyncReadyCallback  callback,
+                                          gpointer             user_data);
+
+G_END_DECLS
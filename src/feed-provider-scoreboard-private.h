@@ -0,0 +1,54 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:provider-scoreboard
+ * @title: Provider Scoreboard
+ * @short_description: Skips providers which keep failing or are slow
+ *
+ * A broken knowledge app makes every refresh wait for it to fail. The
+ * scoreboard keeps the latency and outcome of the most recent queries
+ * to each provider, keyed by desktop ID, and acts as a circuit breaker
+ * for each one.
+ *
+ * Once enough queries have been recorded, a provider whose queries
+ * mostly fail, or whose 90th percentile latency is too high, is skipped
+ * for a back-off period. After that, one refresh is allowed through as
+ * a probe. If the probe succeeds quickly, the provider is used as
+ * normal again and its history is cleared. Otherwise it is skipped
+ * again for twice as long, up to a limit.
+ *
+ * The scoreboard is kept in a cache file, so a provider that was broken
+ * the last time the feed was used is not waited on again straight
+ * away. Changes are written back a few seconds after the last one, on
+ * a worker thread.
+ *
+ * The scoreboard is safe to use from multiple threads.
+ */
+gboolean provider_scoreboard_admit (const gchar *desktop_id);
+
+void provider_scoreboard_record (const gchar *desktop_id,
+                                 gint64       latency_usec,
+                                 gboolean     succeeded);
+
+G_END_DECLS
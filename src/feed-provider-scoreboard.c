@@ -0,0 +1,407 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include <gio/gio.h>
+
+#include "feed-cache-file-private.h"
+#include "feed-provider-scoreboard-private.h"
+
+#define PROVIDER_SCOREBOARD_NAME "provider-scoreboard-v1.gvariant"
+
+/* desktop ID to (samples, state, back-off, open until), where the
+ * samples are (latency in milliseconds, succeeded), oldest first */
+#define PROVIDER_SCOREBOARD_TYPE "a{s(a(ub)uut)}"
+
+/* How many of the most recent queries to each provider are kept */
+#define PROVIDER_SCORE_WINDOW 20
+
+/* Nothing is decided about a provider until it has this many samples,
+ * unless it fails this many times in a row */
+#define PROVIDER_SCORE_MIN_SAMPLES 5
+#define PROVIDER_SCORE_MAX_CONSECUTIVE_FAILURES 3
+
+/* Percentage of failed queries at which a provider is skipped */
+#define PROVIDER_SCORE_MAX_FAILURE_PERCENT 50
+
+/* A provider is skipped if the 90th percentile of its latency is over
+ * this, since it is holding up every refresh */
+#define PROVIDER_SCORE_MAX_P90_LATENCY_MSEC 10000
+
+#define PROVIDER_SCORE_INITIAL_BACKOFF_SECONDS 60
+#define PROVIDER_SCORE_MAX_BACKOFF_SECONDS (60 * 60)
+
+/* If a probe has not been recorded after this long, it was probably
+ * cancelled, so let another one through */
+#define PROVIDER_SCORE_PROBE_TIMEOUT_SECONDS 60
+
+#define PROVIDER_SCOREBOARD_SAVE_DELAY_SECONDS 5
+
+typedef enum
+{
+  PROVIDER_STATE_CLOSED = 0,
+  PROVIDER_STATE_OPEN,
+  PROVIDER_STATE_HALF_OPEN
+} ProviderState;
+
+typedef struct _ProviderScoreSample
+{
+  guint32  latency_msec;
+  gboolean succeeded;
+} ProviderScoreSample;
+
+typedef struct _ProviderScore
+{
+  /* Ring buffer of the most recent samples */
+  ProviderScoreSample samples[PROVIDER_SCORE_WINDOW];
+  guint               n_samples;
+  guint               next_sample;
+  guint               consecutive_failures;
+
+  ProviderState       state;
+  guint32             backoff_seconds;
+
+  /* Wall clock seconds, since it is kept across runs */
+  guint64             open_until;
+  guint64             probe_started;
+} ProviderScore;
+
+/* Protects everything below */
+static GMutex provider_scoreboard_lock;
+
+/* desktop ID to ProviderScore, or NULL if not loaded yet */
+static GHashTable *provider_scores = NULL;
+
+static guint64
+now_seconds (void)
+{
+  return g_get_real_time () / G_USEC_PER_SEC;
+}
+
+static void
+provider_score_add_sample (ProviderScore *score,
+                           guint32        latency_msec,
+                           gboolean       succeeded)
+{
+  score->samples[score->next_sample].latency_msec = latency_msec;
+  score->samples[score->next_sample].succeeded = succeeded;
+  score->next_sample = (score->next_sample + 1) % PROVIDER_SCORE_WINDOW;
+  score->n_samples = MIN (score->n_samples + 1, PROVIDER_SCORE_WINDOW);
+  score->consecutive_failures = succeeded ? 0 : score->consecutive_failures + 1;
+}
+
+/* The @index'th oldest sample */
+static const ProviderScoreSample *
+provider_score_get_sample (ProviderScore *score,
+                           guint          index)
+{
+  guint oldest = (score->next_sample + PROVIDER_SCORE_WINDOW - score->n_samples) % PROVIDER_SCORE_WINDOW;
+
+  return &score->samples[(oldest + index) % PROVIDER_SCORE_WINDOW];
+}
+
+static void
+provider_score_clear_samples (ProviderScore *score)
+{
+  score->n_samples = 0;
+  score->next_sample = 0;
+  score->consecutive_failures = 0;
+}
+
+static gint
+compare_latencies (gconstpointer a,
+                   gconstpointer b)
+{
+  guint32 latency_a = *(const guint32 *) a;
+  guint32 latency_b = *(const guint32 *) b;
+
+  return latency_a < latency_b ? -1 : latency_a > latency_b;
+}
+
+/* The latency that @percentile percent of the samples are at or under */
+static guint32
+provider_score_latency_percentile (ProviderScore *score,
+                                   guint          percentile)
+{
+  guint32 latencies[PROVIDER_SCORE_WINDOW];
+  guint i = 0;
+
+  if (score->n_samples == 0)
+    return 0;
+
+  for (i = 0; i < score->n_samples; ++i)
+    latencies[i] = provider_score_get_sample (score, i)->latency_msec;
+
+  qsort (latencies, score->n_samples, sizeof (guint32), compare_latencies);
+
+  return latencies[(score->n_samples * percentile + 99) / 100 - 1];
+}
+
+static guint
+provider_score_failure_percent (ProviderScore *score)
+{
+  guint n_failures = 0;
+  guint i = 0;
+
+  if (score->n_samples == 0)
+    return 0;
+
+  for (i = 0; i < score->n_samples; ++i)
+    if (!provider_score_get_sample (score, i)->succeeded)
+      ++n_failures;
+
+  return n_failures * 100 / score->n_samples;
+}
+
+static gboolean
+provider_score_is_unhealthy (ProviderScore *score)
+{
+  if (score->consecutive_failures >= PROVIDER_SCORE_MAX_CONSECUTIVE_FAILURES)
+    return TRUE;
+
+  if (score->n_samples < PROVIDER_SCORE_MIN_SAMPLES)
+    return FALSE;
+
+  return provider_score_failure_percent (score) >= PROVIDER_SCORE_MAX_FAILURE_PERCENT ||
+         provider_score_latency_percentile (score, 90) >= PROVIDER_SCORE_MAX_P90_LATENCY_MSEC;
+}
+
+static void
+provider_score_open (ProviderScore *score,
+                     const gchar   *desktop_id)
+{
+  if (score->backoff_seconds == 0)
+    score->backoff_seconds = PROVIDER_SCORE_INITIAL_BACKOFF_SECONDS;
+  else
+    score->backoff_seconds = MIN (score->backoff_seconds * 2,
+                                  PROVIDER_SCORE_MAX_BACKOFF_SECONDS);
+
+  score->state = PROVIDER_STATE_OPEN;
+  score->open_until = now_seconds () + score->backoff_seconds;
+
+  g_message ("Skipping %s for %u seconds, %u%% of its recent queries failed "
+             "and they took %ums at the median and %ums at the 90th percentile",
+             desktop_id,
+             score->backoff_seconds,
+             provider_score_failure_percent (score),
+             provider_score_latency_percentile (score, 50),
+             provider_score_latency_percentile (score, 90));
+}
+
+/* Must be called with provider_scoreboard_lock held */
+static GHashTable *
+ensure_provider_scores (void)
+{
+  g_autoptr(GVariant) saved = NULL;
+  GVariantIter iter;
+  const gchar *desktop_id = NULL;
+  g_autoptr(GVariant) samples = NULL;
+  guint32 state = 0;
+  guint32 backoff_seconds = 0;
+  guint64 open_until = 0;
+
+  if (provider_scores != NULL)
+    return provider_scores;
+
+  provider_scores = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  saved = cache_file_load_variant (PROVIDER_SCOREBOARD_NAME,
+                                   G_VARIANT_TYPE (PROVIDER_SCOREBOARD_TYPE));
+
+  if (saved == NULL)
+    return provider_scores;
+
+  g_variant_iter_init (&iter, saved);
+  while (g_variant_iter_next (&iter, "{&s(@a(ub)uut)}", &desktop_id, &samples, &state, &backoff_seconds, &open_until))
+    {
+      ProviderScore *score = g_new0 (ProviderScore, 1);
+      gsize n_samples = g_variant_n_children (samples);
+      gsize i = n_samples > PROVIDER_SCORE_WINDOW ? n_samples - PROVIDER_SCORE_WINDOW : 0;
+
+      for (; i < n_samples; ++i)
+        {
+          guint32 latency_msec = 0;
+          gboolean succeeded = FALSE;
+
+          g_variant_get_child (samples, i, "(ub)", &latency_msec, &succeeded);
+          provider_score_add_sample (score, latency_msec, succeeded);
+        }
+
+      /* A probe from the last run never completed, so it still counts
+       * as open and will be probed again */
+      score->state = state == PROVIDER_STATE_CLOSED ? PROVIDER_STATE_CLOSED : PROVIDER_STATE_OPEN;
+      score->backoff_seconds = MIN (backoff_seconds, PROVIDER_SCORE_MAX_BACKOFF_SECONDS);
+      score->open_until = MIN (open_until, now_seconds () + score->backoff_seconds);
+
+      g_hash_table_replace (provider_scores, g_strdup (desktop_id), score);
+      g_clear_pointer (&samples, g_variant_unref);
+    }
+
+  return provider_scores;
+}
+
+/* Must be called with provider_scoreboard_lock held */
+static GVariant *
+provider_scores_to_variant (void)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer key = NULL;
+  gpointer value = NULL;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (PROVIDER_SCOREBOARD_TYPE));
+
+  g_hash_table_iter_init (&iter, provider_scores);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      ProviderScore *score = value;
+      GVariantBuilder samples_builder;
+      guint i = 0;
+
+      g_variant_builder_init (&samples_builder, G_VARIANT_TYPE ("a(ub)"));
+
+      for (i = 0; i < score->n_samples; ++i)
+        {
+          const ProviderScoreSample *sample = provider_score_get_sample (score, i);
+
+          g_variant_builder_add (&samples_builder, "(ub)", sample->latency_msec, sample->succeeded);
+        }
+
+      g_variant_builder_add (&builder,
+                             "{s(a(ub)uut)}",
+                             key,
+                             &samples_builder,
+                             (guint32) score->state,
+                             score->backoff_seconds,
+                             score->open_until);
+    }
+
+  return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static GVariant *
+snapshot_provider_scoreboard (void)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&provider_scoreboard_lock);
+
+  return provider_scores_to_variant ();
+}
+
+static CacheFileSaver provider_scoreboard_saver = CACHE_FILE_SAVER_INIT (PROVIDER_SCOREBOARD_NAME,
+                                                                         snapshot_provider_scoreboard,
+                                                                         PROVIDER_SCOREBOARD_SAVE_DELAY_SECONDS);
+
+/*
+ * provider_scoreboard_admit:
+ * @desktop_id: The desktop ID of a provider
+ *
+ * Check whether @desktop_id should be queried in this refresh. If it
+ * has been skipped for long enough, this lets the refresh through as
+ * the probe, and any other refreshes are turned away until the probe
+ * is recorded.
+ *
+ * Returns: %TRUE if the provider should be queried.
+ */
+gboolean
+provider_scoreboard_admit (const gchar *desktop_id)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&provider_scoreboard_lock);
+  ProviderScore *score = g_hash_table_lookup (ensure_provider_scores (), desktop_id);
+  guint64 now = now_seconds ();
+
+  if (score == NULL)
+    return TRUE;
+
+  switch (score->state)
+    {
+    case PROVIDER_STATE_CLOSED:
+      return TRUE;
+    case PROVIDER_STATE_OPEN:
+      if (now < score->open_until)
+        return FALSE;
+      break;
+    case PROVIDER_STATE_HALF_OPEN:
+      if (now < score->probe_started + PROVIDER_SCORE_PROBE_TIMEOUT_SECONDS)
+        return FALSE;
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  score->state = PROVIDER_STATE_HALF_OPEN;
+  score->probe_started = now;
+
+  return TRUE;
+}
+
+/*
+ * provider_scoreboard_record:
+ * @desktop_id: The desktop ID of a provider
+ * @latency_usec: How long the query took, in microseconds
+ * @succeeded: Whether the query succeeded
+ *
+ * Record the outcome of a query to @desktop_id, and skip it from now on
+ * if it has become unhealthy.
+ */
+void
+provider_scoreboard_record (const gchar *desktop_id,
+                            gint64       latency_usec,
+                            gboolean     succeeded)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&provider_scoreboard_lock);
+  GHashTable *scores = ensure_provider_scores ();
+  ProviderScore *score = g_hash_table_lookup (scores, desktop_id);
+  guint32 latency_msec = (guint32) CLAMP (latency_usec / 1000, 0, G_MAXUINT32);
+
+  if (score == NULL)
+    {
+      score = g_new0 (ProviderScore, 1);
+      g_hash_table_insert (scores, g_strdup (desktop_id), score);
+    }
+
+  provider_score_add_sample (score, latency_msec, succeeded);
+
+  switch (score->state)
+    {
+    case PROVIDER_STATE_CLOSED:
+      if (provider_score_is_unhealthy (score))
+        provider_score_open (score, desktop_id);
+      break;
+    case PROVIDER_STATE_HALF_OPEN:
+      if (succeeded && latency_msec < PROVIDER_SCORE_MAX_P90_LATENCY_MSEC)
+        {
+          /* Start afresh, so that the samples which got the provider
+           * skipped do not get it skipped again */
+          provider_score_clear_samples (score);
+          provider_score_add_sample (score, latency_msec, succeeded);
+          score->state = PROVIDER_STATE_CLOSED;
+          score->backoff_seconds = 0;
+        }
+      else
+        {
+          provider_score_open (score, desktop_id);
+        }
+      break;
+    case PROVIDER_STATE_OPEN:
+      /* A query that was made before the provider was skipped */
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  cache_file_saver_schedule (&provider_scoreboard_saver);
+}
@@ -19,250 +19,343 @@
 #include <gio/gio.h>
 
 #include "feed-all-async-tasks-private.h"
+#include "feed-interface-registry-private.h"
 #include "feed-knowledge-app-proxy.h"
 #include "feed-provider-info.h"
 #include "feed-proxy-factory.h"
 
-#define DISCOVERY_FEED_CONTENT_IFACE \
-  "<node>" \
-  "  <interface name=\"com.endlessm.DiscoveryFeedContent\">" \
-  "    <method name=\"ArticleCardDescriptions\">" \
-  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
-  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
-  "    </method>" \
-  "  </interface>" \
-  "</node>"
-
-#define DISCOVERY_FEED_NEWS_IFACE \
-  "<node>" \
-  "  <interface name=\"com.endlessm.DiscoveryFeedNews\">" \
-  "    <method name=\"GetRecentNews\">" \
-  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
-  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
-  "    </method>" \
-  "  </interface>" \
-  "</node>"
-
-#define DISCOVERY_FEED_INSTALLABLE_APPS_IFACE \
-  "<node>" \
-  "  <interface name=\"com.endlessm.DiscoveryFeedInstallableApps\">" \
-  "    <method name=\"GetInstallableApps\">" \
-  "      <arg type=\"aa{sv}\" name=\"Results\" direction=\"out\" />" \
-  "    </method>" \
-  "  </interface>" \
-  "</node>"
-
-#define DISCOVERY_FEED_VIDEO_IFACE \
-  "<node>" \
-  "  <interface name=\"com.endlessm.DiscoveryFeedVideo\">" \
-  "    <method name=\"GetVideos\">" \
-  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
-  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
-  "    </method>" \
-  "  </interface>" \
-  "</node>"
-
-#define DISCOVERY_FEED_WORD_IFACE \
-  "<node>" \
-  "  <interface name=\"com.endlessm.DiscoveryFeedWord\">" \
-  "    <method name=\"GetWordOfTheDay\">" \
-  "      <arg type=\"a{ss}\" name=\"Results\" direction=\"out\" />" \
-  "    </method>" \
-  "  </interface>" \
-  "</node>"
-
-#define DISCOVERY_FEED_QUOTE_IFACE \
-  "<node>" \
-  "  <interface name=\"com.endlessm.DiscoveryFeedQuote\">" \
-  "    <method name=\"GetQuoteOfTheDay\">" \
-  "      <arg type=\"a{ss}\" name=\"Results\" direction=\"out\" />" \
-  "    </method>" \
-  "  </interface>" \
-  "</node>"
-
-#define DISCOVERY_FEED_ARTWORK_IFACE \
-  "<node>" \
-  "  <interface name=\"com.endlessm.DiscoveryFeedArtwork\">" \
-  "    <method name=\"ArtworkCardDescriptions\">" \
-  "      <arg type=\"as\" name=\"Shards\" direction=\"out\" />" \
-  "      <arg type=\"aa{ss}\" name=\"Result\" direction=\"out\" />" \
-  "    </method>" \
-  "  </interface>" \
-  "</node>"
-
-typedef struct _DiscoveryFeedInterfaceNameToInterfaceMetadata {
-  const gchar *interface_name;
-  const gchar *interface_metadata;
-} DiscoveryFeedInterfaceNameToInterfaceMetadata;
-
-static const DiscoveryFeedInterfaceNameToInterfaceMetadata metadata_table[] = {
-  { "com.endlessm.DiscoveryFeedContent", DISCOVERY_FEED_CONTENT_IFACE },
-  { "com.endlessm.DiscoveryFeedNews", DISCOVERY_FEED_NEWS_IFACE },
-  { "com.endlessm.DiscoveryFeedInstallableApps", DISCOVERY_FEED_INSTALLABLE_APPS_IFACE },
-  { "com.endlessm.DiscoveryFeedVideo", DISCOVERY_FEED_VIDEO_IFACE },
-  { "com.endlessm.DiscoveryFeedQuote", DISCOVERY_FEED_QUOTE_IFACE },
-  { "com.endlessm.DiscoveryFeedWord", DISCOVERY_FEED_WORD_IFACE },
-  { "com.endlessm.DiscoveryFeedArtwork", DISCOVERY_FEED_ARTWORK_IFACE }
-};
-static const gsize metadata_table_len = G_N_ELEMENTS (metadata_table);
-
-static const gchar *
-lookup_metadata_for_interface_name (const gchar *interface_name)
+static void
+on_instantiated_dbus_proxy_for_interface (GObject      *source G_GNUC_UNUSED,
+                                          GAsyncResult *result,
+                                          gpointer      user_data)
 {
-  gsize i = 0;
+  g_autoptr(GTask) task = user_data;
+  ContentFeedProviderInfo *provider_info = g_task_get_task_data (task);
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GDBusProxy) proxy = g_dbus_proxy_new_finish (result, &local_error);
 
-  for (; i < metadata_table_len; ++i)
-    if (g_strcmp0 (metadata_table[i].interface_name, interface_name) == 0)
-      return metadata_table[i].interface_metadata;
+  if (proxy == NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&local_error));
+      return;
+    }
+
+  g_task_return_pointer (task,
+                         content_feed_knowledge_app_proxy_new (proxy,
+                                                               content_feed_provider_info_get_desktop_file_id (provider_info),
+                                                               content_feed_provider_info_get_knowledge_search_object_path (provider_info),
+                                                               content_feed_provider_info_get_knowledge_app_id (provider_info)),
+                         g_object_unref);
+}
+
+static void
+instantiate_proxy_for_interface (GDBusConnection         *connection,
+                                 ContentFeedProviderInfo *provider_info,
+                                 const gchar             *interface_name,
+                                 GDBusInterfaceInfo      *interface_info,
+                                 GCancellable            *cancellable,
+                                 GAsyncReadyCallback      callback,
+                                 gpointer                 user_data)
+{
+  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
+  const gchar *object_path = content_feed_provider_info_get_object_path (provider_info);
+
+  /* Make sure that the object path is valid. If it is not, return an error. This
+   * will cause the current feed provider to not load with a warning but it is
+   * better than hitting an assertion in g_dbus_proxy_new */
+  if (!g_variant_is_object_path (object_path))
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_FAILED,
+                               "Object path %s is not valid",
+                               object_path);
+      return;
+    }
 
-  return NULL;
+  g_task_set_task_data (task, g_object_ref (provider_info), g_object_unref);
+
+  /* We only ever call methods on the proxy, so there is no need to
+   * wait for its properties to be loaded or to subscribe to its
+   * signals. The provider is not activated just because we constructed
+   * a proxy for it either; that happens on the first call, which goes
+   * through the activation gate. */
+  g_dbus_proxy_new (connection,
+                    G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES |
+                    G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS |
+                    G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START_AT_CONSTRUCTION,
+                    interface_info,
+                    content_feed_provider_info_get_bus_name (provider_info),
+                    object_path,
+                    interface_name,
+                    cancellable,
+                    on_instantiated_dbus_proxy_for_interface,
+                    g_steal_pointer (&task));
 }
 
-typedef struct _InstantiateProxyForInterfaceData
+/* Proxies are kept in a process-wide pool between feed refreshes, keyed
+ * by bus name, object path and interface name, so that a warm refresh
+ * does not need to construct any proxies at all.
+ *
+ * The pool only holds the proxies that were returned by the most recent
+ * call to content_feed_instantiate_proxies_from_discovery_feed_providers,
+ * so proxies for providers that have gone away are dropped on the next
+ * refresh. The entries for a bus name are also dropped as soon as its
+ * owner vanishes, since the service that comes back may export
+ * something different. A name that has never had an owner just means
+ * that the service has not been activated yet, so that does not drop
+ * anything. */
+
+/* There is one watch for each bus name in the pool, shared by all of
+ * the entries for the interfaces of that name */
+typedef struct _ProxyPoolNameWatch
 {
-  GDBusConnection         *connection;
-  ContentFeedProviderInfo *provider_info;
-  gchar                   *interface_name;
-  const gchar             *interface_metadata;
-} InstantiateProxyForInterfaceData;
-
-static InstantiateProxyForInterfaceData *
-instantiate_proxy_for_interface_data_new (GDBusConnection         *connection,
-                                          ContentFeedProviderInfo *provider_info,
-                                          const gchar             *interface_name,
-                                          const gchar             *interface_metadata)
+  guint    ref_count;
+  gchar   *bus_name;
+  guint    watch_id;
+  gboolean name_has_had_owner;
+} ProxyPoolNameWatch;
+
+typedef struct _ProxyPoolEntry
 {
-  InstantiateProxyForInterfaceData *data = g_new0 (InstantiateProxyForInterfaceData, 1);
+  gchar                        *key;
+  ContentFeedKnowledgeAppProxy *ka_proxy;
+  ProxyPoolNameWatch           *name_watch;
+} ProxyPoolEntry;
+
+/* Protects everything below, including the reference counts of the
+ * name watches */
+static GMutex proxy_pool_lock;
+static GHashTable *proxy_pool = NULL;
+
+/* Bus name to ProxyPoolNameWatch */
+static GHashTable *proxy_pool_name_watches = NULL;
+
+static void on_proxy_pool_name_appeared (GDBusConnection *connection,
+                                         const gchar     *name,
+                                         const gchar     *name_owner,
+                                         gpointer         user_data);
+static void on_proxy_pool_name_vanished (GDBusConnection *connection,
+                                         const gchar     *name,
+                                         gpointer         user_data);
+
+/* Must be called with proxy_pool_lock held */
+static ProxyPoolNameWatch *
+proxy_pool_name_watch_acquire (GDBusConnection *connection,
+                               const gchar     *bus_name)
+{
+  ProxyPoolNameWatch *name_watch = NULL;
 
-  data->connection = g_object_ref (connection);
-  data->provider_info = g_object_ref (provider_info);
-  data->interface_name = g_strdup (interface_name);
+  if (proxy_pool_name_watches == NULL)
+    proxy_pool_name_watches = g_hash_table_new (g_str_hash, g_str_equal);
 
-  /* Assumed to be a static string */
-  data->interface_metadata = interface_metadata;
+  name_watch = g_hash_table_lookup (proxy_pool_name_watches, bus_name);
 
-  return data;
+  if (name_watch != NULL)
+    {
+      ++name_watch->ref_count;
+      return name_watch;
+    }
+
+  name_watch = g_new0 (ProxyPoolNameWatch, 1);
+  name_watch->ref_count = 1;
+  name_watch->bus_name = g_strdup (bus_name);
+  name_watch->watch_id = g_bus_watch_name_on_connection (connection,
+                                                         bus_name,
+                                                         G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                         on_proxy_pool_name_appeared,
+                                                         on_proxy_pool_name_vanished,
+                                                         NULL,
+                                                         NULL);
+  g_hash_table_insert (proxy_pool_name_watches, name_watch->bus_name, name_watch);
+
+  return name_watch;
 }
 
+/* Must be called with proxy_pool_lock held */
 static void
-instantiate_proxy_for_interface_data_free (InstantiateProxyForInterfaceData *data)
+proxy_pool_name_watch_release (ProxyPoolNameWatch *name_watch)
 {
-  g_clear_object (&data->connection);
-  g_clear_object (&data->provider_info);
-  g_clear_pointer (&data->interface_name, g_free);
+  if (--name_watch->ref_count > 0)
+    return;
+
+  g_hash_table_remove (proxy_pool_name_watches, name_watch->bus_name);
+  g_bus_unwatch_name (name_watch->watch_id);
+  g_clear_pointer (&name_watch->bus_name, g_free);
 
-  g_free (data);
+  g_free (name_watch);
 }
 
-static ContentFeedKnowledgeAppProxy *
-instantiate_proxy_for_interface_sync (GDBusConnection          *connection,
-                                      ContentFeedProviderInfo  *provider_info,
-                                      const gchar              *interface_name,
-                                      const gchar              *interface_metadata,
-                                      GCancellable             *cancellable,
-                                      GError                  **error)
+/* Must be called with proxy_pool_lock held */
+static void
+proxy_pool_entry_free (ProxyPoolEntry *entry)
 {
-  g_autoptr(GDBusNodeInfo) node_info = g_dbus_node_info_new_for_xml (interface_metadata,
-                                                                     error);
-  GDBusInterfaceInfo *interface_info = NULL;
-  g_autoptr(GDBusProxy) proxy = NULL;
-
-  const gchar *bus_name = NULL;
-  const gchar *object_path = NULL; 
-  const gchar *desktop_id = NULL;
-  const gchar *knowledge_search_object_path = NULL;
-  const gchar *knowledge_app_id = NULL;
-
-  if (node_info == NULL)
-    return NULL;
+  g_clear_pointer (&entry->key, g_free);
+  g_clear_object (&entry->ka_proxy);
+  g_clear_pointer (&entry->name_watch, proxy_pool_name_watch_release);
 
-  /* This will be NULL in the event that interface_name could
-   * not be found in node_info. The worst that will happen in that
-   * case is that we do not get any validation that the proxy supports
-   * the methods that we would like it to support. */
-  interface_info = g_dbus_node_info_lookup_interface (node_info, interface_name);
+  g_free (entry);
+}
 
-  bus_name = content_feed_provider_info_get_bus_name (provider_info);
-  object_path = content_feed_provider_info_get_object_path (provider_info);
-  desktop_id = content_feed_provider_info_get_desktop_file_id (provider_info);
-  knowledge_search_object_path = content_feed_provider_info_get_knowledge_search_object_path (provider_info);
-  knowledge_app_id = content_feed_provider_info_get_knowledge_app_id (provider_info);
+static gchar *
+proxy_pool_key (const gchar *bus_name,
+                const gchar *object_path,
+                const gchar *interface_name)
+{
+  return g_strjoin (" ", bus_name, object_path, interface_name, NULL);
+}
 
-  /* Make sure that the object path is valid. If it is not, return an error. This
-   * will cause the current feed provider to not load with a warning but it is
-   * better than hitting an assertion in g_dbus_proxy_new_sync */
-  if (!g_variant_is_object_path (object_path))
-    {
-      g_set_error (error,
-                   G_IO_ERROR,
-                   G_IO_ERROR_FAILED,
-                   "Object path %s is not valid",
-                   object_path);
-      return NULL;
-    }
+static GHashTable *
+proxy_pool_table_new (void)
+{
+  /* The keys are owned by the entries */
+  return g_hash_table_new_full (g_str_hash,
+                                g_str_equal,
+                                NULL,
+                                (GDestroyNotify) proxy_pool_entry_free);
+}
 
-  proxy = g_dbus_proxy_new_sync (connection,
-                                 G_DBUS_PROXY_FLAGS_NONE,
-                                 interface_info,
-                                 bus_name,
-                                 object_path,
-                                 interface_name,
-                                 cancellable,
-                                 error);
+static void
+on_proxy_pool_name_appeared (GDBusConnection *connection G_GNUC_UNUSED,
+                             const gchar     *name,
+                             const gchar     *name_owner G_GNUC_UNUSED,
+                             gpointer         user_data G_GNUC_UNUSED)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&proxy_pool_lock);
+  ProxyPoolNameWatch *name_watch = NULL;
 
-  if (proxy == NULL)
+  if (proxy_pool_name_watches == NULL)
+    return;
+
+  name_watch = g_hash_table_lookup (proxy_pool_name_watches, name);
+
+  if (name_watch != NULL)
+    name_watch->name_has_had_owner = TRUE;
+}
+
+static gboolean
+proxy_pool_entry_has_name_watch (gpointer key G_GNUC_UNUSED,
+                                 gpointer value,
+                                 gpointer user_data)
+{
+  ProxyPoolEntry *entry = value;
+
+  return entry->name_watch == user_data;
+}
+
+static void
+on_proxy_pool_name_vanished (GDBusConnection *connection G_GNUC_UNUSED,
+                             const gchar     *name,
+                             gpointer         user_data G_GNUC_UNUSED)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&proxy_pool_lock);
+  ProxyPoolNameWatch *name_watch = NULL;
+
+  if (proxy_pool == NULL || proxy_pool_name_watches == NULL)
+    return;
+
+  name_watch = g_hash_table_lookup (proxy_pool_name_watches, name);
+
+  /* Dropping the last entry for the name also drops the watch, so
+   * name_watch is only compared against from here on */
+  if (name_watch != NULL && name_watch->name_has_had_owner)
+    g_hash_table_foreach_remove (proxy_pool,
+                                 proxy_pool_entry_has_name_watch,
+                                 name_watch);
+}
+
+/* Must be called with proxy_pool_lock held */
+static ProxyPoolEntry *
+proxy_pool_entry_new (gchar                        *key,
+                      ContentFeedKnowledgeAppProxy *ka_proxy)
+{
+  ProxyPoolEntry *entry = g_new0 (ProxyPoolEntry, 1);
+  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
+
+  entry->key = key;
+  entry->ka_proxy = g_object_ref (ka_proxy);
+  entry->name_watch = proxy_pool_name_watch_acquire (g_dbus_proxy_get_connection (dbus_proxy),
+                                                     g_dbus_proxy_get_name (dbus_proxy));
+
+  return entry;
+}
+
+/* Returns a new reference to the pooled proxy for this interface on
+ * @provider_info, or %NULL if there is not one or if it was constructed
+ * for a provider which differs from @provider_info */
+static ContentFeedKnowledgeAppProxy *
+proxy_pool_lookup (GDBusConnection         *connection,
+                   ContentFeedProviderInfo *provider_info,
+                   const gchar             *interface_name)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&proxy_pool_lock);
+  g_autofree gchar *key = NULL;
+  ProxyPoolEntry *entry = NULL;
+
+  if (proxy_pool == NULL)
     return NULL;
 
-  return content_feed_knowledge_app_proxy_new (proxy,
-                                               desktop_id,
-                                               knowledge_search_object_path,
-                                               knowledge_app_id);
+  key = proxy_pool_key (content_feed_provider_info_get_bus_name (provider_info),
+                        content_feed_provider_info_get_object_path (provider_info),
+                        interface_name);
+  entry = g_hash_table_lookup (proxy_pool, key);
+
+  if (entry == NULL)
+    return NULL;
+
+  if (g_dbus_proxy_get_connection (content_feed_knowledge_app_proxy_get_dbus_proxy (entry->ka_proxy)) != connection ||
+      g_strcmp0 (content_feed_knowledge_app_proxy_get_desktop_id (entry->ka_proxy),
+                 content_feed_provider_info_get_desktop_file_id (provider_info)) != 0 ||
+      g_strcmp0 (content_feed_knowledge_app_proxy_get_knowledge_search_object_path (entry->ka_proxy),
+                 content_feed_provider_info_get_knowledge_search_object_path (provider_info)) != 0 ||
+      g_strcmp0 (content_feed_knowledge_app_proxy_get_knowledge_app_id (entry->ka_proxy),
+                 content_feed_provider_info_get_knowledge_app_id (provider_info)) != 0)
+    return NULL;
+
+  return g_object_ref (entry->ka_proxy);
 }
 
+/* Replaces the contents of the pool with @proxies, keeping the entries
+ * (and name watches) for proxies which were already pooled */
 static void
-instantiate_proxy_for_interface_thread (GTask        *task,
-                                        gpointer      source G_GNUC_UNUSED,
-                                        gpointer      task_data,
-                                        GCancellable *cancellable)
+proxy_pool_replace (GPtrArray *proxies)
 {
-  InstantiateProxyForInterfaceData *data = task_data;
-  g_autoptr(GError) local_error = NULL;
-  g_autoptr(ContentFeedKnowledgeAppProxy) ka_proxy =
-    instantiate_proxy_for_interface_sync (data->connection,
-                                          data->provider_info,
-                                          data->interface_name,
-                                          data->interface_metadata,
-                                          cancellable,
-                                          &local_error);
-
-  if (ka_proxy == NULL)
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&proxy_pool_lock);
+  g_autoptr(GHashTable) old_proxy_pool = g_steal_pointer (&proxy_pool);
+  guint i = 0;
+
+  proxy_pool = proxy_pool_table_new ();
+
+  for (i = 0; i < proxies->len; ++i)
     {
-      g_task_return_error (task, g_steal_pointer (&local_error));
-      return;
+      ContentFeedKnowledgeAppProxy *ka_proxy = g_ptr_array_index (proxies, i);
+      GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
+      g_autofree gchar *key = proxy_pool_key (g_dbus_proxy_get_name (dbus_proxy),
+                                              g_dbus_proxy_get_object_path (dbus_proxy),
+                                              g_dbus_proxy_get_interface_name (dbus_proxy));
+      ProxyPoolEntry *entry = NULL;
+
+      if (old_proxy_pool != NULL)
+        entry = g_hash_table_lookup (old_proxy_pool, key);
+
+      if (entry != NULL && entry->ka_proxy == ka_proxy)
+        g_hash_table_steal (old_proxy_pool, key);
+      else
+        entry = proxy_pool_entry_new (g_steal_pointer (&key), ka_proxy);
+
+      g_hash_table_replace (proxy_pool, entry->key, entry);
     }
-
-  g_task_return_pointer (task, g_steal_pointer (&ka_proxy), g_object_unref);
 }
 
 static void
-instantiate_proxy_for_interface (GDBusConnection         *connection,
-                                 ContentFeedProviderInfo *provider_info,
-                                 const gchar             *interface_name,
-                                 const gchar             *interface_metadata,
-                                 GCancellable            *cancellable,
-                                 GAsyncReadyCallback      callback,
-                                 gpointer                 user_data)
+return_pooled_proxy (ContentFeedKnowledgeAppProxy *ka_proxy,
+                     GCancellable                 *cancellable,
+                     GAsyncReadyCallback           callback,
+                     gpointer                      user_data)
 {
   g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
 
-  g_task_set_return_on_cancel (task, TRUE);
-  g_task_set_task_data (task,
-                        instantiate_proxy_for_interface_data_new (connection,
-                                                                  provider_info,
-                                                                  interface_name,
-                                                                  interface_metadata),
-                        (GDestroyNotify) instantiate_proxy_for_interface_data_free);
-  g_task_run_in_thread (task, instantiate_proxy_for_interface_thread);
+  g_task_return_pointer (task, g_object_ref (ka_proxy), g_object_unref);
 }
 
 static void
@@ -306,6 +399,8 @@ on_received_all_instantiation_results (GObject      *source G_GNUC_UNUSED,
       g_ptr_array_add (proxies, g_steal_pointer (&ka_proxy));
     }
 
+  proxy_pool_replace (proxies);
+
   g_task_return_pointer (task,
                          g_steal_pointer (&proxies),
                          (GDestroyNotify) g_ptr_array_unref);
@@ -348,6 +443,10 @@ content_feed_instantiate_proxies_from_discovery_feed_providers_finish (GAsyncRes
  * interface specified in the array of #ContentFeedProviderInfo objects
  * passed in @providers. The caller will need to check the result of construction
  * for each #GAsyncResult in the #GPtrArray passed to the callback.
+ *
+ * Proxies are reused from one call to the next for as long as the
+ * provider stays the same and its bus name does not lose its owner, so
+ * calling this again on every refresh is cheap.
  */
 void
 content_feed_instantiate_proxies_from_discovery_feed_providers (GDBusConnection     *connection,
@@ -369,22 +468,37 @@ content_feed_instantiate_proxies_from_discovery_feed_providers (GDBusConnection
 
       for (; *iter != NULL; ++iter)
         {
-          const gchar *interface_metadata = lookup_metadata_for_interface_name (*iter);
+          const InterfaceRegistryEntry *registry_entry = interface_registry_lookup (*iter);
+          g_autoptr(ContentFeedKnowledgeAppProxy) pooled_proxy = NULL;
 
-          if (interface_metadata == NULL)
+          if (registry_entry == NULL)
             {
               g_message ("Unable to find interface metadata for %s", *iter);
               continue;
             }
 
+          pooled_proxy = proxy_pool_lookup (connection, provider_info, *iter);
+
+          if (pooled_proxy != NULL)
+            {
+              return_pooled_proxy (pooled_proxy,
+                                   cancellable,
+                                   individual_task_result_completed,
+                                   individual_task_result_closure_new (all_tasks_closure));
+              continue;
+            }
+
           instantiate_proxy_for_interface (connection,
                                            provider_info,
                                            *iter,
-                                           interface_metadata,
+                                           registry_entry->interface_info,
                                            cancellable,
                                            individual_task_result_completed,
                                            individual_task_result_closure_new (all_tasks_closure));
         }
     }
+
+  if (!all_tasks_results_has_tasks_remaining (all_tasks_closure))
+    all_tasks_results_return_now (all_tasks_closure);
 }
 
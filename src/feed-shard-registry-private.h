@@ -0,0 +1,108 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+#include <eos-shard/eos-shard-shard-file.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:shard-registry
+ * @title: Shard Registry
+ * @short_description: Process-wide cache of open shard files
+ *
+ * Opening an #EosShardShardFile means opening the file and parsing its
+ * header, which is far too expensive to do for every thumbnail that we
+ * look up. The shard registry keeps each shard file open for the lifetime
+ * of the process, keyed by path, so that all cards, providers and
+ * refreshes share the same #EosShardShardFile.
+ *
+ * Every lookup stats the path and compares the device, inode, size and
+ * modification time against the ones that were recorded when the shard
+ * was opened. If the shard was replaced on disk (for instance, because
+ * the app was updated), the stale entry is dropped and the shard is
+ * opened again. If the path no longer exists, the entry is dropped
+ * and an error is returned.
+ *
+ * The registry is safe to use from multiple threads.
+ */
+EosShardShardFile * shard_registry_lookup (const gchar  *path,
+                                           GError      **error);
+
+/**
+ * SECTION:shard-record-index
+ * @title: Shard Record Index
+ * @short_description: Routing table from record names to shards
+ *
+ * Providers hand us a list of shards along with the thumbnail URIs for
+ * each card, but not which shard the thumbnail lives in. Rather than
+ * probing each shard in turn for every thumbnail, a #ShardRecordIndex
+ * is built once per set of shards. It contains the binary name of every
+ * record that has data, sorted so that it can be binary-searched, along
+ * with the shard that owns it. If more than one shard has a record with
+ * the same name, the shard that comes first in the set wins, which is
+ * what probing the shards in order would have done.
+ *
+ * Indices are cached by shard set and reused across refreshes for as
+ * long as the shard registry hands back the same shard files, so the
+ * cost of building them is only paid when an app is installed or
+ * updated. Only the indices for the most recently used shard sets are
+ * kept, since each one holds its shards open.
+ */
+typedef struct _ShardRecordIndex ShardRecordIndex;
+
+ShardRecordIndex * shard_record_index_lookup (const gchar * const *shards);
+
+ShardRecordIndex * shard_record_index_ref (ShardRecordIndex *index);
+void shard_record_index_unref (ShardRecordIndex *index);
+
+GInputStream * shard_record_index_find_data_stream (ShardRecordIndex *index,
+                                                    const gchar      *hex_name);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ShardRecordIndex, shard_record_index_unref)
+
+/**
+ * SECTION:shard-set
+ * @title: Shard Set
+ * @short_description: The shards named in a provider reply
+ *
+ * Providers that pass thumbnails as file descriptors never need their
+ * shards at all, unless one of the thumbnails is missing from the
+ * reply. A #ShardSet only remembers the paths to the shards; the
+ * #ShardRecordIndex for them, along with the stat of every shard that
+ * it takes to look one up, is only fetched the first time a record
+ * has to be found in the shards.
+ *
+ * A #ShardSet may be shared between threads.
+ */
+typedef struct _ShardSet ShardSet;
+
+ShardSet * shard_set_new (const gchar * const *shards);
+
+ShardSet * shard_set_ref (ShardSet *shard_set);
+void shard_set_unref (ShardSet *shard_set);
+
+GInputStream * shard_set_find_data_stream (ShardSet    *shard_set,
+                                           const gchar *hex_name);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ShardSet, shard_set_unref)
+
+G_END_DECLS
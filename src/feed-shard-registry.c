@@ -0,0 +1,598 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include <eos-shard/eos-shard-blob.h>
+#include <eos-shard/eos-shard-record.h>
+
+#include "feed-shard-registry-private.h"
+
+typedef struct _ShardRegistryEntry
+{
+  EosShardShardFile *shard_file;
+  guint64            device;
+  guint64            inode;
+  gint64             size;
+  gint64             mtime;
+} ShardRegistryEntry;
+
+static ShardRegistryEntry *
+shard_registry_entry_new (EosShardShardFile *shard_file,
+                          GStatBuf          *stat_buf)
+{
+  ShardRegistryEntry *entry = g_new0 (ShardRegistryEntry, 1);
+
+  entry->shard_file = g_object_ref (shard_file);
+  entry->device = stat_buf->st_dev;
+  entry->inode = stat_buf->st_ino;
+  entry->size = stat_buf->st_size;
+  entry->mtime = stat_buf->st_mtime;
+
+  return entry;
+}
+
+static void
+shard_registry_entry_free (ShardRegistryEntry *entry)
+{
+  g_clear_object (&entry->shard_file);
+
+  g_free (entry);
+}
+
+static gboolean
+shard_registry_entry_matches_stat (ShardRegistryEntry *entry,
+                                   GStatBuf           *stat_buf)
+{
+  return entry->device == (guint64) stat_buf->st_dev &&
+         entry->inode == (guint64) stat_buf->st_ino &&
+         entry->size == (gint64) stat_buf->st_size &&
+         entry->mtime == (gint64) stat_buf->st_mtime;
+}
+
+/* Protects shard_registry. We hold the lock while opening a shard so
+ * that two threads looking up the same path do not both open it. */
+static GMutex shard_registry_lock;
+static GHashTable *shard_registry = NULL;
+
+static GHashTable *
+ensure_shard_registry (void)
+{
+  if (shard_registry == NULL)
+    shard_registry = g_hash_table_new_full (g_str_hash,
+                                            g_str_equal,
+                                            g_free,
+                                            (GDestroyNotify) shard_registry_entry_free);
+
+  return shard_registry;
+}
+
+EosShardShardFile *
+shard_registry_lookup (const gchar  *path,
+                       GError      **error)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&shard_registry_lock);
+  GHashTable *registry = ensure_shard_registry ();
+  g_autoptr(EosShardShardFile) shard_file = NULL;
+  ShardRegistryEntry *entry = NULL;
+  GStatBuf stat_buf;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  if (g_stat (path, &stat_buf) != 0)
+    {
+      int errsv = errno;
+
+      /* The shard went away, don't keep the old one alive */
+      g_hash_table_remove (registry, path);
+      g_set_error (error,
+                   G_IO_ERROR,
+                   g_io_error_from_errno (errsv),
+                   "Could not stat shard file %s: %s",
+                   path,
+                   g_strerror (errsv));
+      return NULL;
+    }
+
+  entry = g_hash_table_lookup (registry, path);
+
+  if (entry != NULL && shard_registry_entry_matches_stat (entry, &stat_buf))
+    return g_object_ref (entry->shard_file);
+
+  /* Either we have never seen this shard or it changed on disk since we
+   * last opened it. Existing users of the old shard file keep their
+   * reference and will continue to read from the old file. */
+  shard_file = g_initable_new (EOS_SHARD_TYPE_SHARD_FILE,
+                               NULL,
+                               error,
+                               "path",
+                               path,
+                               NULL);
+
+  if (shard_file == NULL)
+    {
+      g_hash_table_remove (registry, path);
+      return NULL;
+    }
+
+  g_hash_table_replace (registry,
+                        g_strdup (path),
+                        shard_registry_entry_new (shard_file, &stat_buf));
+
+  return g_steal_pointer (&shard_file);
+}
+
+/* The size of the binary form of a record name (a SHA-1 hash) */
+#define SHARD_RAW_NAME_SIZE 20
+
+typedef struct _ShardRecordIndexEntry
+{
+  guint8  raw_name[SHARD_RAW_NAME_SIZE];
+  guint32 shard_index;
+} ShardRecordIndexEntry;
+
+struct _ShardRecordIndex
+{
+  volatile gint          ref_count;
+  GPtrArray             *shard_files;
+  ShardRecordIndexEntry *entries;
+  gsize                  n_entries;
+};
+
+static gboolean
+hex_name_to_raw_name (const gchar *hex_name,
+                      guint8      *raw_name)
+{
+  gsize i = 0;
+
+  for (; i < SHARD_RAW_NAME_SIZE; ++i)
+    {
+      gint high = g_ascii_xdigit_value (hex_name[i * 2]);
+      gint low = 0;
+
+      /* Checking the high nibble first also stops us from reading
+       * past the end of a string which is too short */
+      if (high < 0)
+        return FALSE;
+
+      low = g_ascii_xdigit_value (hex_name[i * 2 + 1]);
+
+      if (low < 0)
+        return FALSE;
+
+      raw_name[i] = (guint8) ((high << 4) | low);
+    }
+
+  return hex_name[SHARD_RAW_NAME_SIZE * 2] == '\0';
+}
+
+static gint
+compare_shard_record_index_entries (gconstpointer lhs,
+                                    gconstpointer rhs)
+{
+  const ShardRecordIndexEntry *lhs_entry = lhs;
+  const ShardRecordIndexEntry *rhs_entry = rhs;
+  gint name_cmp = memcmp (lhs_entry->raw_name,
+                          rhs_entry->raw_name,
+                          SHARD_RAW_NAME_SIZE);
+
+  if (name_cmp != 0)
+    return name_cmp;
+
+  /* Shards earlier in the set take precedence */
+  if (lhs_entry->shard_index != rhs_entry->shard_index)
+    return lhs_entry->shard_index < rhs_entry->shard_index ? -1 : 1;
+
+  return 0;
+}
+
+static gint
+compare_raw_name_to_shard_record_index_entry (gconstpointer key,
+                                              gconstpointer element)
+{
+  const ShardRecordIndexEntry *entry = element;
+
+  return memcmp (key, entry->raw_name, SHARD_RAW_NAME_SIZE);
+}
+
+static void
+record_unref (gpointer record)
+{
+  eos_shard_record_unref (record);
+}
+
+static void
+object_unref_if_set (gpointer object)
+{
+  if (object != NULL)
+    g_object_unref (object);
+}
+
+static ShardRecordIndex *
+shard_record_index_new (GPtrArray *shard_files)
+{
+  ShardRecordIndex *record_index = g_new0 (ShardRecordIndex, 1);
+  g_autoptr(GArray) entries = g_array_new (FALSE, FALSE, sizeof (ShardRecordIndexEntry));
+  guint i = 0;
+  gsize n_unique = 0;
+
+  record_index->ref_count = 1;
+  record_index->shard_files = g_ptr_array_ref (shard_files);
+
+  for (i = 0; i < shard_files->len; ++i)
+    {
+      EosShardShardFile *shard_file = g_ptr_array_index (shard_files, i);
+      GSList *records = NULL;
+      GSList *iter = NULL;
+
+      /* Shards that failed to load have a NULL placeholder so that
+       * shard indices still line up with the shard set */
+      if (shard_file == NULL)
+        continue;
+
+      records = eos_shard_shard_file_list_records (shard_file);
+
+      for (iter = records; iter != NULL; iter = iter->next)
+        {
+          EosShardRecord *record = iter->data;
+          ShardRecordIndexEntry entry;
+
+          /* Probing would have skipped records without data too */
+          if (record->data == NULL)
+            continue;
+
+          memcpy (entry.raw_name, record->raw_name, SHARD_RAW_NAME_SIZE);
+          entry.shard_index = i;
+          g_array_append_val (entries, entry);
+        }
+
+      g_slist_free_full (records, record_unref);
+    }
+
+  g_array_sort (entries, compare_shard_record_index_entries);
+
+  /* Only keep the first entry for each name, which is the one from the
+   * earliest shard after sorting */
+  for (i = 0; i < entries->len; ++i)
+    {
+      ShardRecordIndexEntry *entry = &g_array_index (entries, ShardRecordIndexEntry, i);
+
+      if (n_unique > 0 &&
+          memcmp (g_array_index (entries, ShardRecordIndexEntry, n_unique - 1).raw_name,
+                  entry->raw_name,
+                  SHARD_RAW_NAME_SIZE) == 0)
+        continue;
+
+      if (n_unique != i)
+        g_array_index (entries, ShardRecordIndexEntry, n_unique) = *entry;
+
+      ++n_unique;
+    }
+
+  g_array_set_size (entries, n_unique);
+  record_index->n_entries = n_unique;
+  record_index->entries = (ShardRecordIndexEntry *) g_array_free (g_steal_pointer (&entries), FALSE);
+
+  return record_index;
+}
+
+ShardRecordIndex *
+shard_record_index_ref (ShardRecordIndex *record_index)
+{
+  g_atomic_int_inc (&record_index->ref_count);
+
+  return record_index;
+}
+
+void
+shard_record_index_unref (ShardRecordIndex *record_index)
+{
+  if (!g_atomic_int_dec_and_test (&record_index->ref_count))
+    return;
+
+  g_clear_pointer (&record_index->shard_files, g_ptr_array_unref);
+  g_clear_pointer (&record_index->entries, g_free);
+
+  g_free (record_index);
+}
+
+/*
+ * shard_record_index_find_data_stream:
+ * @record_index: A #ShardRecordIndex
+ * @hex_name: The hex name of the record to look up
+ *
+ * Find the record named by @hex_name in whichever shard owns it and
+ * return a stream for its data. This is a single binary search in the
+ * index followed by a single lookup in the owning shard, no matter how
+ * many shards are in the set.
+ *
+ * Returns: (transfer full) (nullable): A #GInputStream for the record's
+ *          data, or %NULL if no shard in the set has the record.
+ */
+GInputStream *
+shard_record_index_find_data_stream (ShardRecordIndex *record_index,
+                                     const gchar      *hex_name)
+{
+  guint8 raw_name[SHARD_RAW_NAME_SIZE];
+  const ShardRecordIndexEntry *entry = NULL;
+  EosShardShardFile *shard_file = NULL;
+  g_autoptr(EosShardRecord) record = NULL;
+
+  if (hex_name == NULL || !hex_name_to_raw_name (hex_name, raw_name))
+    return NULL;
+
+  entry = bsearch (raw_name,
+                   record_index->entries,
+                   record_index->n_entries,
+                   sizeof (ShardRecordIndexEntry),
+                   compare_raw_name_to_shard_record_index_entry);
+
+  if (entry == NULL)
+    return NULL;
+
+  shard_file = g_ptr_array_index (record_index->shard_files, entry->shard_index);
+  record = eos_shard_shard_file_find_record_by_hex_name (shard_file,
+                                                         (gchar *) hex_name);
+
+  if (record == NULL || record->data == NULL)
+    return NULL;
+
+  return eos_shard_blob_get_stream (record->data);
+}
+
+/* How many of the most recently used indices to keep around. Each one
+ * keeps its shards open and has an entry for every record in them, so
+ * this is kept to about the number of providers on a typical system,
+ * and the indices for apps that were uninstalled fall out eventually. */
+#define SHARD_RECORD_INDEX_CACHE_SIZE 16
+
+typedef struct _ShardRecordIndexCacheEntry
+{
+  gchar            *key;
+  ShardRecordIndex *record_index;
+} ShardRecordIndexCacheEntry;
+
+static void
+shard_record_index_cache_entry_free (ShardRecordIndexCacheEntry *cache_entry)
+{
+  g_clear_pointer (&cache_entry->key, g_free);
+  g_clear_pointer (&cache_entry->record_index, shard_record_index_unref);
+
+  g_free (cache_entry);
+}
+
+/* Protects shard_record_indices. This is a separate lock from the
+ * shard registry lock since building an index calls back into the
+ * shard registry. It is never held while an index is being built, so
+ * a large shard set does not hold up lookups in the others. */
+static GMutex shard_record_indices_lock;
+
+/* ShardRecordIndexCacheEntry, most recently used first */
+static GQueue shard_record_indices = G_QUEUE_INIT;
+
+static gboolean
+shard_record_index_has_shard_files (ShardRecordIndex *record_index,
+                                    GPtrArray        *shard_files)
+{
+  guint i = 0;
+
+  if (record_index->shard_files->len != shard_files->len)
+    return FALSE;
+
+  for (; i < shard_files->len; ++i)
+    if (g_ptr_array_index (record_index->shard_files, i) != g_ptr_array_index (shard_files, i))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Must be called with shard_record_indices_lock held. Moves the entry
+ * for @key to the front if it is up to date and drops it otherwise. */
+static ShardRecordIndex *
+lookup_cached_shard_record_index (const gchar *key,
+                                  GPtrArray   *shard_files)
+{
+  GList *link = shard_record_indices.head;
+
+  for (; link != NULL; link = link->next)
+    {
+      ShardRecordIndexCacheEntry *cache_entry = link->data;
+
+      if (g_strcmp0 (cache_entry->key, key) != 0)
+        continue;
+
+      g_queue_unlink (&shard_record_indices, link);
+
+      /* One of the shards was replaced or went away since the index
+       * was built */
+      if (!shard_record_index_has_shard_files (cache_entry->record_index, shard_files))
+        {
+          shard_record_index_cache_entry_free (cache_entry);
+          g_list_free_1 (link);
+          return NULL;
+        }
+
+      g_queue_push_head_link (&shard_record_indices, link);
+      return shard_record_index_ref (cache_entry->record_index);
+    }
+
+  return NULL;
+}
+
+/* Must be called with shard_record_indices_lock held */
+static void
+insert_cached_shard_record_index (const gchar      *key,
+                                  ShardRecordIndex *record_index)
+{
+  ShardRecordIndexCacheEntry *cache_entry = g_new0 (ShardRecordIndexCacheEntry, 1);
+
+  cache_entry->key = g_strdup (key);
+  cache_entry->record_index = shard_record_index_ref (record_index);
+  g_queue_push_head (&shard_record_indices, cache_entry);
+
+  while (shard_record_indices.length > SHARD_RECORD_INDEX_CACHE_SIZE)
+    shard_record_index_cache_entry_free (g_queue_pop_tail (&shard_record_indices));
+}
+
+/*
+ * shard_record_index_lookup:
+ * @shards: The paths to the shards in the set, in order of precedence
+ *
+ * Get a #ShardRecordIndex for @shards, building it if there is no
+ * up-to-date index for this set yet. Shards which cannot be loaded are
+ * logged and left out of the index. Only the indices for the most
+ * recently used sets are kept.
+ *
+ * Returns: (transfer full): A #ShardRecordIndex
+ */
+ShardRecordIndex *
+shard_record_index_lookup (const gchar * const *shards)
+{
+  g_autoptr(GMutexLocker) locker = NULL;
+  g_autoptr(GPtrArray) shard_files = g_ptr_array_new_with_free_func (object_unref_if_set);
+  g_autofree gchar *key = g_strjoinv ("\n", (GStrv) shards);
+  const gchar * const *iter = shards;
+  ShardRecordIndex *record_index = NULL;
+  ShardRecordIndex *other_record_index = NULL;
+
+  /* Going through the registry is only a stat per shard if nothing
+   * changed, and tells us whether any of the shards were replaced. */
+  for (; *iter != NULL; ++iter)
+    {
+      g_autoptr(GError) local_error = NULL;
+      EosShardShardFile *shard_file = shard_registry_lookup (*iter, &local_error);
+
+      if (shard_file == NULL)
+        g_message ("Failed to load shard file %s: %s. Skipping.",
+                   *iter,
+                   local_error->message);
+
+      g_ptr_array_add (shard_files, shard_file);
+    }
+
+  locker = g_mutex_locker_new (&shard_record_indices_lock);
+  record_index = lookup_cached_shard_record_index (key, shard_files);
+  g_clear_pointer (&locker, g_mutex_locker_free);
+
+  if (record_index != NULL)
+    return record_index;
+
+  record_index = shard_record_index_new (shard_files);
+
+  /* Someone else may have built an index for the same shards while we
+   * were building ours, in which case use theirs so that there is only
+   * one copy */
+  locker = g_mutex_locker_new (&shard_record_indices_lock);
+  other_record_index = lookup_cached_shard_record_index (key, shard_files);
+
+  if (other_record_index != NULL)
+    {
+      shard_record_index_unref (record_index);
+      return other_record_index;
+    }
+
+  insert_cached_shard_record_index (key, record_index);
+
+  return record_index;
+}
+
+struct _ShardSet
+{
+  volatile gint     ref_count;
+  GStrv             shards;
+
+  /* Protects record_index, which is NULL until the first lookup */
+  GMutex            lock;
+  ShardRecordIndex *record_index;
+};
+
+/*
+ * shard_set_new:
+ * @shards: The paths to the shards in the set, in order of precedence
+ *
+ * Create a new #ShardSet for @shards. This does not touch the shards
+ * on disk.
+ *
+ * Returns: (transfer full): A #ShardSet
+ */
+ShardSet *
+shard_set_new (const gchar * const *shards)
+{
+  ShardSet *shard_set = g_new0 (ShardSet, 1);
+
+  shard_set->ref_count = 1;
+  shard_set->shards = g_strdupv ((GStrv) shards);
+  g_mutex_init (&shard_set->lock);
+
+  return shard_set;
+}
+
+ShardSet *
+shard_set_ref (ShardSet *shard_set)
+{
+  g_atomic_int_inc (&shard_set->ref_count);
+
+  return shard_set;
+}
+
+void
+shard_set_unref (ShardSet *shard_set)
+{
+  if (!g_atomic_int_dec_and_test (&shard_set->ref_count))
+    return;
+
+  g_clear_pointer (&shard_set->record_index, shard_record_index_unref);
+  g_clear_pointer (&shard_set->shards, g_strfreev);
+  g_mutex_clear (&shard_set->lock);
+
+  g_free (shard_set);
+}
+
+/*
+ * shard_set_find_data_stream:
+ * @shard_set: A #ShardSet
+ * @hex_name: The hex name of the record to look up
+ *
+ * Find the record named by @hex_name in whichever shard in the set owns
+ * it, looking up the #ShardRecordIndex for the set first if this is the
+ * first lookup.
+ *
+ * Returns: (transfer full) (nullable): A #GInputStream for the record's
+ *          data, or %NULL if no shard in the set has the record.
+ */
+GInputStream *
+shard_set_find_data_stream (ShardSet    *shard_set,
+                            const gchar *hex_name)
+{
+  g_autoptr(ShardRecordIndex) record_index = NULL;
+
+  if (shard_set->shards == NULL || shard_set->shards[0] == NULL)
+    return NULL;
+
+  g_mutex_lock (&shard_set->lock);
+  if (shard_set->record_index == NULL)
+    shard_set->record_index = shard_record_index_lookup ((const gchar * const *) shard_set->shards);
+  record_index = shard_record_index_ref (shard_set->record_index);
+  g_mutex_unlock (&shard_set->lock);
+
+  return shard_record_index_find_data_stream (record_index, hex_name);
+}
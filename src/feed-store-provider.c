@@ -21,113 +21,483 @@
 
 #include <gio/gio.h>
 
-#include <eos-shard/eos-shard-blob.h>
-#include <eos-shard/eos-shard-shard-file.h>
-#include <eos-shard/eos-shard-record.h>
-
 #include <libsoup/soup.h>
 
+#include "feed-activation-gate-private.h"
 #include "feed-all-async-tasks-private.h"
 #include "feed-base-card-store.h"
 #include "feed-card-layout-direction.h"
+#include "feed-interface-registry-private.h"
 #include "feed-knowledge-app-artwork-card-store.h"
 #include "feed-knowledge-app-card-store.h"
-#include "feed-knowledge-app-news-card-store.h"
 #include "feed-knowledge-app-proxy.h"
 #include "feed-knowledge-app-video-card-store.h"
+#include "feed-model-ordering-private.h"
 #include "feed-orderable-model.h"
+#include "feed-orderable-model-private.h"
+#include "feed-provider-scoreboard-private.h"
 #include "feed-quote-card-store.h"
-#include "feed-sizes.h"
+#include "feed-shard-registry-private.h"
 #include "feed-store-provider.h"
+#include "feed-synopsis-cache-private.h"
 #include "feed-text-sanitization.h"
+#include "feed-thumbnail-fds-private.h"
 #include "feed-word-card-store.h"
 #include "feed-word-quote-card-store.h"
 
-typedef GSList * (*ModelsFromResultsAndShardsFunc) (const char * const *shards,
-                                                    GPtrArray          *model_props_variants,
-                                                    gpointer            user_data);
+/* @section is the interface that the models are for if they came from
+ * a bulk reply, or NULL otherwise. @thumbnail_fds is only set if the
+ * provider passed thumbnails as file descriptors. */
+typedef GSList * (*ModelsFromResultsAndShardsFunc) (ShardSet     *shard_set,
+                                                    ThumbnailFds *thumbnail_fds,
+                                                    const gchar  *section,
+                                                    GPtrArray    *model_props_variants,
+                                                    gpointer      user_data);
 typedef GObject * (*ModelFromResultFunc) (GVariant *model_variant,
                                           gpointer  user_data);
 
-static gboolean
-call_dbus_proxy_and_construct_from_models_and_shards (GDBusProxy                      *proxy,
-                                                      const gchar                     *method_name,
-                                                      ModelsFromResultsAndShardsFunc   marshal_func,
-                                                      gpointer                         marshal_data,
-                                                      GCancellable                    *cancellable,
-                                                      gpointer                        *out_result,
-                                                      GError                         **error)
+/* Building cards means sanitizing text and looking up thumbnails in
+ * the shards, which is always done on a worker thread. If the models
+ * are deferred, marshalling is only turning the reply into models, so
+ * replies smaller than this are marshalled straight away on the
+ * calling main context, which is cheaper than the round trip through
+ * the thread pool. */
+#define MARSHAL_ON_WORKER_THRESHOLD_BYTES (16 * 1024)
+
+static void
+object_slist_free (GSList *slist)
+{
+  g_slist_free_full (slist, g_object_unref);
+}
+
+/* The earliest time that the activation gate made any of the calls
+ * behind a task, passed on from task to task so that the scoreboard
+ * does not count time spent waiting for other providers to activate */
+#define DISPATCH_TIME_DATA_KEY "content-feed-dispatch-time"
+
+static void
+task_note_dispatch_time (GTask  *task,
+                         gint64  dispatch_time)
+{
+  gint64 *earliest_dispatch_time = g_object_get_data (G_OBJECT (task),
+                                                      DISPATCH_TIME_DATA_KEY);
+
+  if (dispatch_time == 0)
+    return;
+
+  if (earliest_dispatch_time == NULL)
+    {
+      earliest_dispatch_time = g_new (gint64, 1);
+      *earliest_dispatch_time = dispatch_time;
+      g_object_set_data_full (G_OBJECT (task),
+                              DISPATCH_TIME_DATA_KEY,
+                              earliest_dispatch_time,
+                              g_free);
+      return;
+    }
+
+  *earliest_dispatch_time = MIN (*earliest_dispatch_time, dispatch_time);
+}
+
+/* Returns 0 if none of the calls behind @result were made */
+static gint64
+task_get_dispatch_time (GAsyncResult *result)
+{
+  gint64 *dispatch_time = g_object_get_data (G_OBJECT (result),
+                                             DISPATCH_TIME_DATA_KEY);
+
+  return dispatch_time != NULL ? *dispatch_time : 0;
+}
+
+/* A method to call on a provider, and the parameters to call it with */
+typedef struct _MethodCall
+{
+  gchar    *method_name;
+  GVariant *parameters;
+} MethodCall;
+
+static MethodCall *
+method_call_new (const gchar *method_name,
+                 GVariant    *parameters)
+{
+  MethodCall *call = g_new0 (MethodCall, 1);
+
+  call->method_name = g_strdup (method_name);
+  call->parameters = parameters != NULL ? g_variant_ref_sink (parameters) : NULL;
+
+  return call;
+}
+
+static void
+method_call_free (MethodCall *call)
+{
+  g_clear_pointer (&call->method_name, g_free);
+  g_clear_pointer (&call->parameters, g_variant_unref);
+
+  g_free (call);
+}
+
+typedef struct _ConstructFromModelsAndShardsData
+{
+  ModelsFromResultsAndShardsFunc  marshal_func;
+  gpointer                        marshal_data;
+  GDestroyNotify                  marshal_data_destroy;
+
+  /* The calls to try in order, and the one that is in flight */
+  GPtrArray                      *calls;
+  guint                           current_call;
+  gint                            timeout_msec;
+
+  /* Whether @marshal_func does nothing but turn the reply into models */
+  gboolean                        marshal_is_cheap;
+
+  GVariant                       *reply;
+  GUnixFDList                    *reply_fd_list;
+} ConstructFromModelsAndShardsData;
+
+static ConstructFromModelsAndShardsData *
+construct_from_models_and_shards_data_new (ModelsFromResultsAndShardsFunc marshal_func,
+                                           gpointer                       marshal_data,
+                                           GDestroyNotify                 marshal_data_destroy,
+                                           GPtrArray                     *calls,
+                                           gint                           timeout_msec,
+                                           gboolean                       marshal_is_cheap)
+{
+  ConstructFromModelsAndShardsData *data = g_new0 (ConstructFromModelsAndShardsData, 1);
+
+  data->marshal_func = marshal_func;
+  data->marshal_data = marshal_data;
+  data->marshal_data_destroy = marshal_data_destroy;
+  data->calls = g_ptr_array_ref (calls);
+  data->timeout_msec = timeout_msec;
+  data->marshal_is_cheap = marshal_is_cheap;
+
+  return data;
+}
+
+static void
+construct_from_models_and_shards_data_free (ConstructFromModelsAndShardsData *data)
+{
+  if (data->marshal_data_destroy != NULL)
+    g_clear_pointer (&data->marshal_data, data->marshal_data_destroy);
+
+  g_clear_pointer (&data->calls, g_ptr_array_unref);
+  g_clear_pointer (&data->reply, g_variant_unref);
+  g_clear_object (&data->reply_fd_list);
+
+  g_free (data);
+}
+
+static GPtrArray *
+model_props_variants_new (GVariant *models_variant)
+{
+  GPtrArray *model_props_variants = g_ptr_array_new_full (g_variant_n_children (models_variant),
+                                                          (GDestroyNotify) g_variant_unref);
+  GVariantIter iter;
+  GVariant *model_variant = NULL;
+
+  /* Each item holds its own reference, since cards may need to be
+   * built after this function returns */
+  g_variant_iter_init (&iter, models_variant);
+  while (g_variant_iter_next (&iter, "@a{ss}", &model_variant))
+    g_ptr_array_add (model_props_variants,
+                     model_variant);
+
+  return model_props_variants;
+}
+
+static GSList *
+construct_from_models_and_shards (ConstructFromModelsAndShardsData *data)
 {
-  g_autoptr(GVariant) result = NULL;
-  g_autoptr(GVariant) shards_variant = NULL;
   g_autoptr(GVariant) models_variant = NULL;
   g_auto(GStrv) shards_strv = NULL;
+  g_autoptr(ShardSet) shard_set = NULL;
+  g_autoptr(ThumbnailFds) thumbnail_fds = NULL;
   g_autoptr(GPtrArray) model_props_variants = NULL;
+  GSList *models = NULL;
   GVariantIter iter;
-  GVariant *model_variant = NULL;
+  const gchar *section = NULL;
+
+  /* Bulk replies have a list of models for each interface, but only
+   * one list of shards for all of them */
+  if (g_variant_is_of_type (data->reply, G_VARIANT_TYPE ("(asa{saa{ss}})")))
+    {
+      g_autoptr(GVariant) sections_variant = NULL;
+      GVariant *section_models_variant = NULL;
 
-  g_return_val_if_fail (out_result != NULL, FALSE);
+      g_variant_get (data->reply, "(^as@a{saa{ss}})", &shards_strv, &sections_variant);
+      shard_set = shard_set_new ((const gchar * const *) shards_strv);
 
-  result = g_dbus_proxy_call_sync (proxy,
-                                   method_name,
-                                   NULL,
-                                   G_DBUS_CALL_FLAGS_NONE,
-                                   -1,
-                                   cancellable,
-                                   error);
+      g_variant_iter_init (&iter, sections_variant);
+      while (g_variant_iter_loop (&iter, "{&s@aa{ss}}", &section, &section_models_variant))
+        {
+          g_autoptr(GPtrArray) section_model_props_variants = model_props_variants_new (section_models_variant);
+
+          models = g_slist_concat (data->marshal_func (shard_set,
+                                                       NULL,
+                                                       section,
+                                                       section_model_props_variants,
+                                                       data->marshal_data),
+                                   models);
+        }
 
-  if (result == NULL)
-    return FALSE;
+      return models;
+    }
 
-  g_variant_get (result, "(^as@aa{ss})", &shards_strv, &models_variant);
+  /* Replies with thumbnail file descriptors have an extra a{sh} */
+  if (g_variant_is_of_type (data->reply, G_VARIANT_TYPE ("(asaa{ss}a{sh})")))
+    {
+      g_autoptr(GVariant) thumbnails_variant = NULL;
+
+      g_variant_get (data->reply,
+                     "(^as@aa{ss}@a{sh})",
+                     &shards_strv,
+                     &models_variant,
+                     &thumbnails_variant);
+      thumbnail_fds = thumbnail_fds_new (thumbnails_variant, data->reply_fd_list);
+    }
+  else
+    {
+      g_variant_get (data->reply, "(^as@aa{ss})", &shards_strv, &models_variant);
+    }
 
-  model_props_variants = g_ptr_array_new_full (g_variant_n_children (models_variant),
-                                               NULL);
+  model_props_variants = model_props_variants_new (models_variant);
 
-  g_variant_iter_init (&iter, models_variant);
-  while (g_variant_iter_loop (&iter, "@a{ss}", &model_variant))
-    g_ptr_array_add (model_props_variants,
-                     model_variant);
+  /* The shards are only indexed if a thumbnail is not in
+   * @thumbnail_fds, so that replies which pass every thumbnail as a
+   * descriptor never touch them */
+  shard_set = shard_set_new ((const gchar * const *) shards_strv);
 
   /* Now that we have the models and shards, we can marshal them into
    * a GSList containing the discovery-feed models */
-  *out_result = marshal_func ((const gchar * const *) shards_strv,
-                              model_props_variants,
-                              marshal_data);
-  return TRUE;
+  return data->marshal_func (shard_set,
+                             thumbnail_fds,
+                             NULL,
+                             model_props_variants,
+                             data->marshal_data);
+}
+
+static void
+construct_from_models_and_shards_thread (GTask        *task,
+                                         gpointer      source G_GNUC_UNUSED,
+                                         gpointer      task_data,
+                                         GCancellable *cancellable G_GNUC_UNUSED)
+{
+  g_task_return_pointer (task,
+                         construct_from_models_and_shards (task_data),
+                         (GDestroyNotify) object_slist_free);
 }
 
+/* Methods which a provider does not implement are remembered on the
+ * proxy, which is kept for as long as the provider keeps running */
+#define UNSUPPORTED_METHODS_DATA_KEY "content-feed-unsupported-methods"
+
 static gboolean
-call_dbus_proxy_and_construct_from_model (GDBusProxy           *proxy,
-                                          const gchar          *method_name,
-                                          ModelFromResultFunc   marshal_func,
-                                          gpointer              marshal_data,
-                                          GCancellable         *cancellable,
-                                          gpointer             *out_result,
-                                          GError              **error)
+proxy_supports_method (GDBusProxy  *proxy,
+                       const gchar *method_name)
 {
-  g_autoptr(GVariant) result = NULL;
-  g_autoptr(GVariant) model_variant = NULL;
+  GHashTable *unsupported_methods = g_object_get_data (G_OBJECT (proxy),
+                                                       UNSUPPORTED_METHODS_DATA_KEY);
+
+  return unsupported_methods == NULL ||
+         !g_hash_table_contains (unsupported_methods, method_name);
+}
+
+static void
+mark_proxy_method_unsupported (GDBusProxy  *proxy,
+                               const gchar *method_name)
+{
+  GHashTable *unsupported_methods = g_object_get_data (G_OBJECT (proxy),
+                                                       UNSUPPORTED_METHODS_DATA_KEY);
+
+  if (unsupported_methods == NULL)
+    {
+      unsupported_methods = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+      g_object_set_data_full (G_OBJECT (proxy),
+                              UNSUPPORTED_METHODS_DATA_KEY,
+                              unsupported_methods,
+                              (GDestroyNotify) g_hash_table_unref);
+    }
+
+  g_hash_table_add (unsupported_methods, g_strdup (method_name));
+}
+
+static void
+received_models_and_shards_reply (GObject      *source,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GUnixFDList) reply_fd_list = NULL;
+  g_autoptr(GVariant) reply = activation_gate_call_with_unix_fd_list_finish (G_DBUS_PROXY (source),
+                                                                             &reply_fd_list,
+                                                                             result,
+                                                                             &local_error);
+  ConstructFromModelsAndShardsData *data = g_task_get_task_data (task);
+
+  task_note_dispatch_time (task, activation_gate_call_get_dispatch_time (result));
+
+  /* Older providers do not know about the newer methods, so fall back
+   * to the next one down, and do not bother trying again */
+  if (reply == NULL &&
+      data->current_call + 1 < data->calls->len &&
+      (g_error_matches (local_error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD) ||
+       g_error_matches (local_error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS)))
+    {
+      MethodCall *failed_call = g_ptr_array_index (data->calls, data->current_call);
+      MethodCall *next_call = g_ptr_array_index (data->calls, ++data->current_call);
+
+      mark_proxy_method_unsupported (G_DBUS_PROXY (source), failed_call->method_name);
+
+      activation_gate_call (G_DBUS_PROXY (source),
+                            next_call->method_name,
+                            next_call->parameters,
+                            data->timeout_msec,
+                            g_task_get_cancellable (task),
+                            received_models_and_shards_reply,
+                            g_steal_pointer (&task));
+      return;
+    }
+
+  if (reply == NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&local_error));
+      return;
+    }
+
+  data->reply = g_steal_pointer (&reply);
+  data->reply_fd_list = g_steal_pointer (&reply_fd_list);
+
+  if (data->marshal_is_cheap &&
+      g_variant_get_size (data->reply) < MARSHAL_ON_WORKER_THRESHOLD_BYTES)
+    {
+      g_task_return_pointer (task,
+                             construct_from_models_and_shards (data),
+                             (GDestroyNotify) object_slist_free);
+      return;
+    }
+
+  g_task_set_return_on_cancel (task, TRUE);
+  g_task_run_in_thread (task, construct_from_models_and_shards_thread);
+}
+
+/* Make the first of @calls, a GPtrArray of #MethodCall, on @proxy
+ * without blocking and pass a #GTask returning a GSList of
+ * #ContentFeedOrderableModel made by @marshal_func to @callback. If
+ * the provider does not implement the method, the next call is tried.
+ * The call fails with %G_IO_ERROR_TIMED_OUT if there is no reply
+ * within @timeout_msec, or the default D-Bus timeout if -1. The call
+ * itself is kept in flight on the thread-default main context, and
+ * the reply is marshalled on a worker thread unless it is small and
+ * @marshal_is_cheap says that @marshal_func does no more than turn it
+ * into models. If the provider is not running yet, the call waits for
+ * its turn in the activation gate first. */
+static void
+call_dbus_proxy_and_construct_from_models_and_shards (GDBusProxy                      *proxy,
+                                                      GPtrArray                       *calls,
+                                                      gint                             timeout_msec,
+                                                      ModelsFromResultsAndShardsFunc   marshal_func,
+                                                      gpointer                         marshal_data,
+                                                      GDestroyNotify                   marshal_data_destroy,
+                                                      gboolean                         marshal_is_cheap,
+                                                      GCancellable                    *cancellable,
+                                                      GAsyncReadyCallback              callback,
+                                                      gpointer                         user_data)
+{
+  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
+  MethodCall *first_call = g_ptr_array_index (calls, 0);
+
+  g_task_set_task_data (task,
+                        construct_from_models_and_shards_data_new (marshal_func,
+                                                                   marshal_data,
+                                                                   marshal_data_destroy,
+                                                                   calls,
+                                                                   timeout_msec,
+                                                                   marshal_is_cheap),
+                        (GDestroyNotify) construct_from_models_and_shards_data_free);
+
+  activation_gate_call (proxy,
+                        first_call->method_name,
+                        first_call->parameters,
+                        timeout_msec,
+                        cancellable,
+                        received_models_and_shards_reply,
+                        g_steal_pointer (&task));
+}
+
+typedef struct _ConstructFromModelData
+{
+  ModelFromResultFunc  marshal_func;
+  gpointer             marshal_data;
+} ConstructFromModelData;
 
-  g_return_val_if_fail (out_result != NULL, FALSE);
+static ConstructFromModelData *
+construct_from_model_data_new (ModelFromResultFunc marshal_func,
+                               gpointer            marshal_data)
+{
+  ConstructFromModelData *data = g_new0 (ConstructFromModelData, 1);
+
+  data->marshal_func = marshal_func;
+  data->marshal_data = marshal_data;
+
+  return data;
+}
+
+static void
+received_model_reply (GObject      *source,
+                      GAsyncResult *result,
+                      gpointer      user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GVariant) reply = activation_gate_call_finish (G_DBUS_PROXY (source),
+                                                           result,
+                                                           &local_error);
+  g_autoptr(GVariant) model_variant = NULL;
+  ConstructFromModelData *data = g_task_get_task_data (task);
 
-  result = g_dbus_proxy_call_sync (proxy,
-                                   method_name,
-                                   NULL,
-                                   G_DBUS_CALL_FLAGS_NONE,
-                                   -1,
-                                   cancellable,
-                                   error);
+  task_note_dispatch_time (task, activation_gate_call_get_dispatch_time (result));
 
-  if (result == NULL)
-    return FALSE;
+  if (reply == NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&local_error));
+      return;
+    }
 
-  g_variant_get (result, "(@a{ss})", &model_variant);
+  g_variant_get (reply, "(@a{ss})", &model_variant);
 
   /* Now that we have the model, we can marshal it into a
-   * GObject */
-  *out_result = marshal_func (model_variant, marshal_data);
-  return TRUE;
+   * GObject. There is only ever one, so this is always done
+   * on the calling main context. */
+  g_task_return_pointer (task,
+                         data->marshal_func (model_variant, data->marshal_data),
+                         g_object_unref);
+}
+
+static void
+call_dbus_proxy_and_construct_from_model (GDBusProxy           *proxy,
+                                          const gchar          *method_name,
+                                          gint                  timeout_msec,
+                                          ModelFromResultFunc   marshal_func,
+                                          gpointer              marshal_data,
+                                          GCancellable         *cancellable,
+                                          GAsyncReadyCallback   callback,
+                                          gpointer              user_data)
+{
+  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
+
+  g_task_set_task_data (task,
+                        construct_from_model_data_new (marshal_func, marshal_data),
+                        g_free);
+
+  activation_gate_call (proxy,
+                        method_name,
+                        NULL,
+                        timeout_msec,
+                        cancellable,
+                        received_model_reply,
+                        g_steal_pointer (&task));
 }
 
 static gchar *
@@ -157,97 +527,111 @@ remove_uri_prefix (const gchar *uri)
   return strip_leading_slashes (path);
 }
 
+/* Prefer the descriptor that the provider passed for the thumbnail, if
+ * it passed one, over looking it up in the shards ourselves */
 static GInputStream *
-find_thumbnail_stream_in_shards (const gchar * const  *shards_strv,
-                                 const gchar          *thumbnail_uri)
-{
-  const gchar * const *iter = shards_strv;
-  g_autofree gchar *normalized = remove_uri_prefix (thumbnail_uri);
-
-  for (; *iter != NULL; ++iter) {
-    g_autoptr(EosShardShardFile) shard_file = NULL;
-    g_autoptr(EosShardRecord) record = NULL;
-    g_autoptr(GError) local_error = NULL;
-
-    /* XXX: This should probably be done asynchronously if possible */
-    shard_file = g_initable_new (EOS_SHARD_TYPE_SHARD_FILE,
-                                 NULL,
-                                 &local_error,
-                                 "path",
-                                 *iter,
-                                 NULL);
-
-    if (shard_file == NULL)
-      {
-        g_message ("Failed to load shard file %s: %s. Skipping.",
-                   *iter,
-                   local_error->message);
-        continue;
-      }
+find_thumbnail_stream (ShardSet     *shard_set,
+                       ThumbnailFds *thumbnail_fds,
+                       const gchar  *thumbnail_uri)
+{
+  g_autofree gchar *normalized = NULL;
 
-    record = eos_shard_shard_file_find_record_by_hex_name (shard_file,
-                                                           normalized);
+  if (thumbnail_fds != NULL)
+    {
+      GInputStream *stream = thumbnail_fds_take_stream (thumbnail_fds, thumbnail_uri);
 
-    if (record == NULL || record->data == NULL)
-      continue;
+      if (stream != NULL)
+        return stream;
+    }
 
-    return eos_shard_blob_get_stream (record->data);
-  }
+  normalized = remove_uri_prefix (thumbnail_uri);
 
-  return NULL;
+  return shard_set_find_data_stream (shard_set, normalized);
 }
 
-typedef ContentFeedKnowledgeAppCardStore * (*ContentFeedKnowledgeAppCardStoreFactoryFunc) (const gchar                    *title,
-                                                                                           const gchar                    *uri,
-                                                                                           const gchar                    *synopsis,
-                                                                                           GInputStream                   *thumbnail,
-                                                                                           const gchar                    *desktop_id,
-                                                                                           const gchar                    *bus_name,
-                                                                                           const gchar                    *knowledge_search_object_path,
-                                                                                           const gchar                    *knowledge_app_id,
-                                                                                           ContentFeedCardLayoutDirection  layout_direction,
-                                                                                           guint                           thumbnail_size,
-                                                                                           const gchar                    *thumbnail_uri,
-                                                                                           const gchar                    *content_type);
+typedef struct _CardsFromShardsAndItemsData CardsFromShardsAndItemsData;
+
+/* Build a single card from the a{ss} describing it, or return NULL if
+ * the item cannot be turned into a card. If the card has a synopsis,
+ * it has already been sanitized and is passed in @synopsis. */
+typedef ContentFeedBaseCardStore * (*CardFromShardsAndItemFunc) (ShardSet                    *shard_set,
+                                                                 ThumbnailFds                *thumbnail_fds,
+                                                                 GVariant                    *model_props,
+                                                                 const gchar                 *synopsis,
+                                                                 CardsFromShardsAndItemsData *data);
 
+/* A cheap check of whether an item would make a valid card, used
+ * when building the card itself is deferred */
+typedef gboolean (*CardItemIsValidFunc) (GVariant *model_props);
 
-typedef struct _ArticleCardsFromShardsAndItemsData
+struct _CardsFromShardsAndItemsData
 {
+  volatile gint                                ref_count;
   ContentFeedKnowledgeAppProxy                *ka_proxy;
   ContentFeedCardLayoutDirection               direction;
   ContentFeedCardStoreType                     type;
   guint                                        thumbnail_size;
   ContentFeedKnowledgeAppCardStoreFactoryFunc  factory;
-} ArticleCardsFromShardsAndItemsData;
-
-static ArticleCardsFromShardsAndItemsData *
-article_cards_from_shards_and_items_data_new (ContentFeedKnowledgeAppProxy                *ka_proxy,
-                                              ContentFeedCardLayoutDirection               direction,
-                                              ContentFeedCardStoreType                     type,
-                                              guint                                        thumbnail_size,
-                                              ContentFeedKnowledgeAppCardStoreFactoryFunc  factory)
+  gboolean                                     has_synopsis;
+  CardFromShardsAndItemFunc                    card_func;
+  CardItemIsValidFunc                          is_valid_func;
+  const gchar * const                         *fields;
+  gboolean                                     defer_models;
+};
+
+typedef struct _CardMarshallerFuncs
+{
+  CardFromShardsAndItemFunc  card_func;
+  CardItemIsValidFunc        is_valid_func;
+
+  /* The keys that card_func and is_valid_func look at in each item */
+  const gchar * const       *fields;
+} CardMarshallerFuncs;
+
+static CardsFromShardsAndItemsData *
+cards_from_shards_and_items_data_new (ContentFeedKnowledgeAppProxy *ka_proxy,
+                                      const InterfaceRegistryEntry *registry_entry,
+                                      const CardMarshallerFuncs    *marshaller_funcs,
+                                      gboolean                      defer_models)
 {
-  ArticleCardsFromShardsAndItemsData *data = g_new0 (ArticleCardsFromShardsAndItemsData, 1);
+  CardsFromShardsAndItemsData *data = g_new0 (CardsFromShardsAndItemsData, 1);
 
+  data->ref_count = 1;
   data->ka_proxy = g_object_ref (ka_proxy);
-  data->direction = direction;
-  data->type = type;
-  data->thumbnail_size = thumbnail_size;
-  data->factory = factory;
+  data->direction = registry_entry->direction;
+  data->type = registry_entry->card_type;
+  data->thumbnail_size = registry_entry->thumbnail_size;
+  data->factory = registry_entry->factory;
+  data->has_synopsis = registry_entry->has_synopsis;
+  data->card_func = marshaller_funcs->card_func;
+  data->is_valid_func = marshaller_funcs->is_valid_func;
+  data->fields = marshaller_funcs->fields;
+  data->defer_models = defer_models;
+
+  return data;
+}
+
+static CardsFromShardsAndItemsData *
+cards_from_shards_and_items_data_ref (CardsFromShardsAndItemsData *data)
+{
+  g_atomic_int_inc (&data->ref_count);
 
   return data;
 }
 
 static void
-article_cards_from_shards_and_items_data_free (ArticleCardsFromShardsAndItemsData *data)
+cards_from_shards_and_items_data_unref (CardsFromShardsAndItemsData *data)
 {
+  if (!g_atomic_int_dec_and_test (&data->ref_count))
+    return;
+
   g_clear_object (&data->ka_proxy);
 
   g_free (data);
 }
 
-G_DEFINE_AUTOPTR_CLEANUP_FUNC (ArticleCardsFromShardsAndItemsData,
-                               article_cards_from_shards_and_items_data_free)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (CardsFromShardsAndItemsData,
+                               cards_from_shards_and_items_data_unref)
 
 /* Given a variant of type a{ss}, look up a string for a corresponding key,
  * note that this is currently done with a linear scan and is transfer-none */
@@ -262,114 +646,35 @@ lookup_string_in_dict_variant (GVariant *variant, const gchar *key)
   return str;
 }
 
-static GSList *
-article_cards_from_shards_and_items (const char * const *shards_strv,
-                                     GPtrArray          *model_props_variants,
-                                     gpointer            user_data)
-{
-  ArticleCardsFromShardsAndItemsData *data = user_data;
-  GSList *orderable_stores = NULL;
-  guint i = 0;
-
-  for (; i < model_props_variants->len; ++i)
-    {
-      GVariant *model_props = g_ptr_array_index (model_props_variants, i);
-      const gchar *unsanitized_snopsis = lookup_string_in_dict_variant (model_props,
-                                                                        "synopsis");
-      const gchar *synopsis = content_feed_sanitize_synopsis (unsanitized_snopsis);
-      const gchar *title = lookup_string_in_dict_variant (model_props, "title");
-      const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
-      const gchar *thumbnail_uri = lookup_string_in_dict_variant (model_props,
-                                                                  "thumbnail_uri");
-      const gchar *content_type = lookup_string_in_dict_variant (model_props,
-                                                                 "content_type");
-      g_autoptr(GInputStream) thumbnail_stream =
-        find_thumbnail_stream_in_shards (shards_strv, thumbnail_uri);
-      GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (data->ka_proxy);
-
-      ContentFeedKnowledgeAppCardStore *store =
-        data->factory (title,
-                       ekn_id,
-                       synopsis,
-                       thumbnail_stream,
-                       content_feed_knowledge_app_proxy_get_desktop_id (data->ka_proxy),
-                       g_dbus_proxy_get_name (dbus_proxy),
-                       content_feed_knowledge_app_proxy_get_knowledge_search_object_path (data->ka_proxy),
-                       content_feed_knowledge_app_proxy_get_knowledge_app_id (data->ka_proxy),
-                       data->direction ? data->direction : CONTENT_FEED_CARD_LAYOUT_DIRECTION_IMAGE_FIRST,
-                       data->thumbnail_size,
-                       thumbnail_uri,
-                       content_type);
-      orderable_stores = g_slist_prepend (orderable_stores,
-                                          content_feed_orderable_model_new (CONTENT_FEED_BASE_CARD_STORE (store),
-                                                                            data->type,
-                                                                            content_feed_knowledge_app_proxy_get_desktop_id (data->ka_proxy)));
-    }
-
-    return g_steal_pointer (&orderable_stores);
-}
-
-typedef struct _AppendDiscoveryFeedContentFromProxyData
-{
-  gchar                                       *method;
-  ContentFeedCardStoreType                     type;
-  ContentFeedCardLayoutDirection               direction;
-  ContentFeedKnowledgeAppCardStoreFactoryFunc  factory;
-  guint                                        thumbnail_size;
-} AppendDiscoveryFeedContentFromProxyData;
-
-static AppendDiscoveryFeedContentFromProxyData *
-append_discovery_feed_content_from_proxy_data_new (const gchar                                *method,
-                                                   ContentFeedCardStoreType                    type,
-                                                   ContentFeedCardLayoutDirection              direction,
-                                                   ContentFeedKnowledgeAppCardStoreFactoryFunc factory,
-                                                   guint                                       thumbnail_size)
-
-{
-  AppendDiscoveryFeedContentFromProxyData *data = g_new0 (AppendDiscoveryFeedContentFromProxyData, 1);
-
-  data->method = g_strdup (method);
-  data->type = type;
-  data->direction = direction;
-  data->factory = factory;
-  data->thumbnail_size = thumbnail_size;
-
-  return data;
-}
-
-static void
-append_discovery_feed_content_from_proxy_data_free (AppendDiscoveryFeedContentFromProxyData *data)
+static ContentFeedBaseCardStore *
+article_card_from_shards_and_item (ShardSet                    *shard_set,
+                                   ThumbnailFds                *thumbnail_fds,
+                                   GVariant                    *model_props,
+                                   const gchar                 *synopsis,
+                                   CardsFromShardsAndItemsData *data)
 {
-  g_clear_pointer (&data->method, g_free);
-
-  g_free (data);
-}
-
-G_DEFINE_AUTOPTR_CLEANUP_FUNC (AppendDiscoveryFeedContentFromProxyData,
-                               append_discovery_feed_content_from_proxy_data_free)
-
-static gboolean
-append_discovery_feed_content_from_proxy (ContentFeedKnowledgeAppProxy  *ka_proxy,
-                                          gpointer                       proxy_data,
-                                          GCancellable                  *cancellable,
-                                          gpointer                      *out_result,
-                                          GError                       **error)
-{
-  g_autoptr(AppendDiscoveryFeedContentFromProxyData) data = proxy_data;
-  g_autoptr(ArticleCardsFromShardsAndItemsData) marshal_data = article_cards_from_shards_and_items_data_new (ka_proxy,
-                                                                                                             data->direction,
-                                                                                                             data->type,
-                                                                                                             data->thumbnail_size,
-                                                                                                             data->factory);
-  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
-
-  return call_dbus_proxy_and_construct_from_models_and_shards (dbus_proxy,
-                                                               data->method,
-                                                               article_cards_from_shards_and_items,
-                                                               marshal_data,
-                                                               cancellable,
-                                                               out_result,
-                                                               error);
+  const gchar *title = lookup_string_in_dict_variant (model_props, "title");
+  const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
+  const gchar *thumbnail_uri = lookup_string_in_dict_variant (model_props,
+                                                              "thumbnail_uri");
+  const gchar *content_type = lookup_string_in_dict_variant (model_props,
+                                                             "content_type");
+  g_autoptr(GInputStream) thumbnail_stream =
+    find_thumbnail_stream (shard_set, thumbnail_fds, thumbnail_uri);
+  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (data->ka_proxy);
+
+  return CONTENT_FEED_BASE_CARD_STORE (data->factory (title,
+                                                      ekn_id,
+                                                      synopsis,
+                                                      thumbnail_stream,
+                                                      content_feed_knowledge_app_proxy_get_desktop_id (data->ka_proxy),
+                                                      g_dbus_proxy_get_name (dbus_proxy),
+                                                      content_feed_knowledge_app_proxy_get_knowledge_search_object_path (data->ka_proxy),
+                                                      content_feed_knowledge_app_proxy_get_knowledge_app_id (data->ka_proxy),
+                                                      data->direction ? data->direction : CONTENT_FEED_CARD_LAYOUT_DIRECTION_IMAGE_FIRST,
+                                                      data->thumbnail_size,
+                                                      thumbnail_uri,
+                                                      content_type));
 }
 
 static gboolean
@@ -442,232 +747,582 @@ parse_duration (const gchar  *duration,
   return g_strdup_printf ("%li:%02li", minutes, seconds);
 }
 
-static GSList *
-video_cards_from_shards_and_items (const char * const *shards_strv,
-                                   GPtrArray          *model_props_variants,
-                                   gpointer            user_data)
+static gchar *
+parse_duration_from_item (GVariant *model_props)
 {
-  ContentFeedKnowledgeAppProxy *ka_proxy = user_data;
-  GSList *orderable_stores = NULL;
-  guint i = 0;
+  g_autoptr(GError) local_error = NULL;
+  const gchar *in_duration = lookup_string_in_dict_variant (model_props,
+                                                            "duration");
+  g_autofree gchar *duration = parse_duration (in_duration, &local_error);
 
-  for (; i < model_props_variants->len; ++i)
+  if (duration == NULL)
     {
-      GVariant *model_props = g_ptr_array_index (model_props_variants, i);
-      g_autoptr(GError) local_error = NULL;
-      const gchar *in_duration = lookup_string_in_dict_variant (model_props,
-                                                                "duration");
-      const gchar *thumbnail_uri = lookup_string_in_dict_variant (model_props,
-                                                                  "thumbnail_uri");
-      const gchar *title = lookup_string_in_dict_variant (model_props, "title");
-      const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
-      const gchar *content_type = lookup_string_in_dict_variant (model_props,
-                                                                 "content_type");
-      g_autofree gchar *duration = parse_duration (in_duration, &local_error);
-      g_autoptr(GInputStream) thumbnail_stream = NULL;
-      ContentFeedKnowledgeAppVideoCardStore *store = NULL;
-      GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
-
-      if (duration == NULL)
-        {
-          g_message ("Failed to parse duration %s: %s",
-                     in_duration,
-                     local_error->message);
-          continue;
-        }
-
-      thumbnail_stream = find_thumbnail_stream_in_shards (shards_strv, thumbnail_uri);
-
-      store = content_feed_knowledge_app_video_card_store_new (title,
-                                                               ekn_id,
-                                                               duration,
-                                                               thumbnail_stream,
-                                                               content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy),
-                                                               g_dbus_proxy_get_name (dbus_proxy),
-                                                               content_feed_knowledge_app_proxy_get_knowledge_search_object_path (ka_proxy),
-                                                               content_feed_knowledge_app_proxy_get_knowledge_app_id (ka_proxy),
-                                                               thumbnail_uri,
-                                                               content_type);
-      orderable_stores = g_slist_prepend (orderable_stores,
-                                          content_feed_orderable_model_new (CONTENT_FEED_BASE_CARD_STORE (store),
-                                                                            CONTENT_FEED_CARD_STORE_TYPE_VIDEO_CARD,
-                                                                            content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy)));
+      g_message ("Failed to parse duration %s: %s",
+                 in_duration,
+                 local_error->message);
+      return NULL;
     }
 
-    return g_steal_pointer (&orderable_stores);
+  return g_steal_pointer (&duration);
 }
 
 static gboolean
-append_discovery_feed_video_from_proxy (ContentFeedKnowledgeAppProxy  *ka_proxy,
-                                        gpointer                       proxy_data G_GNUC_UNUSED,
-                                        GCancellable                  *cancellable,
-                                        gpointer                      *out_result,
-                                        GError                       **error)
+video_item_is_valid (GVariant *model_props)
 {
-  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
+  g_autofree gchar *duration = parse_duration_from_item (model_props);
 
-  return call_dbus_proxy_and_construct_from_models_and_shards (dbus_proxy,
-                                                               "GetVideos",
-                                                               video_cards_from_shards_and_items,
-                                                               ka_proxy,
-                                                               cancellable,
-                                                               out_result,
-                                                               error);
+  return duration != NULL;
 }
 
-static GSList *
-artwork_cards_from_shards_and_items (const char * const *shards_strv,
-                                     GPtrArray          *model_props_variants,
-                                     gpointer            user_data)
+static ContentFeedBaseCardStore *
+video_card_from_shards_and_item (ShardSet                    *shard_set,
+                                 ThumbnailFds                *thumbnail_fds,
+                                 GVariant                    *model_props,
+                                 const gchar                 *synopsis G_GNUC_UNUSED,
+                                 CardsFromShardsAndItemsData *data)
 {
-  ContentFeedKnowledgeAppProxy *ka_proxy = user_data;
-  GSList *orderable_stores = NULL;
-  guint i = 0;
-
-  for (; i < model_props_variants->len; ++i)
-    {
-      GVariant *model_props = g_ptr_array_index (model_props_variants, i);
-      const gchar *first_date = lookup_string_in_dict_variant (model_props, "first_date");
-      const gchar *thumbnail_uri = lookup_string_in_dict_variant (model_props, "thumbnail_uri");
-      const gchar *title = lookup_string_in_dict_variant (model_props, "title");
-      const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
-      const gchar *author = lookup_string_in_dict_variant (model_props, "author");
-      const gchar *content_type = lookup_string_in_dict_variant (model_props, "content_type");
-      g_autoptr(GInputStream) thumbnail_stream =
-        find_thumbnail_stream_in_shards (shards_strv, thumbnail_uri);
-      GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
-
-      ContentFeedKnowledgeAppArtworkCardStore *store =
-        content_feed_knowledge_app_artwork_card_store_new (title,
-                                                           ekn_id,
-                                                           author,
-                                                           first_date != NULL ? first_date : "",
-                                                           thumbnail_stream,
-                                                           content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy),
-                                                           g_dbus_proxy_get_name (dbus_proxy),
-                                                           content_feed_knowledge_app_proxy_get_knowledge_search_object_path (ka_proxy),
-                                                           content_feed_knowledge_app_proxy_get_knowledge_app_id (ka_proxy),
-                                                           CONTENT_FEED_CARD_LAYOUT_DIRECTION_IMAGE_FIRST,
-                                                           CONTENT_FEED_THUMBNAIL_SIZE_ARTWORK,
-                                                           thumbnail_uri,
-                                                           content_type);
-      orderable_stores = g_slist_prepend (orderable_stores,
-                                          content_feed_orderable_model_new (CONTENT_FEED_BASE_CARD_STORE (store),
-                                                                            CONTENT_FEED_CARD_STORE_TYPE_ARTWORK_CARD,
-                                                                            content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy)));
-    }
+  const gchar *thumbnail_uri = lookup_string_in_dict_variant (model_props,
+                                                              "thumbnail_uri");
+  const gchar *title = lookup_string_in_dict_variant (model_props, "title");
+  const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
+  const gchar *content_type = lookup_string_in_dict_variant (model_props,
+                                                             "content_type");
+  g_autofree gchar *duration = parse_duration_from_item (model_props);
+  g_autoptr(GInputStream) thumbnail_stream = NULL;
+  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (data->ka_proxy);
+
+  if (duration == NULL)
+    return NULL;
 
-    return g_steal_pointer (&orderable_stores);
+  thumbnail_stream = find_thumbnail_stream (shard_set, thumbnail_fds, thumbnail_uri);
+
+  return CONTENT_FEED_BASE_CARD_STORE (content_feed_knowledge_app_video_card_store_new (title,
+                                                                                       ekn_id,
+                                                                                       duration,
+                                                                                       thumbnail_stream,
+                                                                                       content_feed_knowledge_app_proxy_get_desktop_id (data->ka_proxy),
+                                                                                       g_dbus_proxy_get_name (dbus_proxy),
+                                                                                       content_feed_knowledge_app_proxy_get_knowledge_search_object_path (data->ka_proxy),
+                                                                                       content_feed_knowledge_app_proxy_get_knowledge_app_id (data->ka_proxy),
+                                                                                       thumbnail_uri,
+                                                                                       content_type));
 }
 
-static gboolean
-append_discovery_feed_artwork_from_proxy (ContentFeedKnowledgeAppProxy  *ka_proxy,
-                                          gpointer                       proxy_data G_GNUC_UNUSED,
-                                          GCancellable                  *cancellable,
-                                          gpointer                      *out_result,
-                                          GError                       **error)
+static ContentFeedBaseCardStore *
+artwork_card_from_shards_and_item (ShardSet                    *shard_set,
+                                   ThumbnailFds                *thumbnail_fds,
+                                   GVariant                    *model_props,
+                                   const gchar                 *synopsis G_GNUC_UNUSED,
+                                   CardsFromShardsAndItemsData *data)
 {
-  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
-
-  return call_dbus_proxy_and_construct_from_models_and_shards (dbus_proxy,
-                                                               "ArtworkCardDescriptions",
-                                                               artwork_cards_from_shards_and_items,
-                                                               ka_proxy,
-                                                               cancellable,
-                                                               out_result,
-                                                               error);
+  const gchar *first_date = lookup_string_in_dict_variant (model_props, "first_date");
+  const gchar *thumbnail_uri = lookup_string_in_dict_variant (model_props, "thumbnail_uri");
+  const gchar *title = lookup_string_in_dict_variant (model_props, "title");
+  const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
+  const gchar *author = lookup_string_in_dict_variant (model_props, "author");
+  const gchar *content_type = lookup_string_in_dict_variant (model_props, "content_type");
+  g_autoptr(GInputStream) thumbnail_stream =
+    find_thumbnail_stream (shard_set, thumbnail_fds, thumbnail_uri);
+  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (data->ka_proxy);
+
+  return CONTENT_FEED_BASE_CARD_STORE (content_feed_knowledge_app_artwork_card_store_new (title,
+                                                                                         ekn_id,
+                                                                                         author,
+                                                                                         first_date != NULL ? first_date : "",
+                                                                                         thumbnail_stream,
+                                                                                         content_feed_knowledge_app_proxy_get_desktop_id (data->ka_proxy),
+                                                                                         g_dbus_proxy_get_name (dbus_proxy),
+                                                                                         content_feed_knowledge_app_proxy_get_knowledge_search_object_path (data->ka_proxy),
+                                                                                         content_feed_knowledge_app_proxy_get_knowledge_app_id (data->ka_proxy),
+                                                                                         data->direction,
+                                                                                         data->thumbnail_size,
+                                                                                         thumbnail_uri,
+                                                                                         content_type));
 }
 
-typedef gboolean (*AppendStoresFromProxyFunc) (ContentFeedKnowledgeAppProxy  *ka_proxy,
-                                               gpointer                       proxy_data,
-                                               GCancellable                  *cancellable,
-                                               gpointer                      *out_result,
-                                               GError                       **error);
-
-typedef struct _AppendStoresTaskData
+/* The keys that each kind of card is built from */
+static const gchar * const article_fields[] = {
+  "title", "ekn_id", "thumbnail_uri", "content_type", "synopsis", NULL
+};
+static const gchar * const video_fields[] = {
+  "title", "ekn_id", "thumbnail_uri", "content_type", "duration", NULL
+};
+static const gchar * const artwork_fields[] = {
+  "title", "ekn_id", "thumbnail_uri", "content_type", "author", "first_date", NULL
+};
+
+/* The functions for each marshaller in the interface registry that
+ * builds cards from a list of items and shards */
+static const CardMarshallerFuncs card_marshaller_funcs[INTERFACE_MARSHALLER_N_MARSHALLERS] = {
+  [INTERFACE_MARSHALLER_ARTICLE] = { article_card_from_shards_and_item, NULL, article_fields },
+  [INTERFACE_MARSHALLER_VIDEO] = { video_card_from_shards_and_item, video_item_is_valid, video_fields },
+  [INTERFACE_MARSHALLER_ARTWORK] = { artwork_card_from_shards_and_item, NULL, artwork_fields }
+};
+
+typedef struct _DeferredCardData
 {
-  ContentFeedKnowledgeAppProxy *ka_proxy;
-  AppendStoresFromProxyFunc     proxy_func;
-  GDestroyNotify                proxy_return_destroy;
-  gpointer                      proxy_data;
-} AppendStoresTaskData;
-
-static AppendStoresTaskData *
-append_stores_task_data_new (ContentFeedKnowledgeAppProxy *ka_proxy,
-                             AppendStoresFromProxyFunc     proxy_func,
-                             GDestroyNotify                proxy_return_destroy,
-                             gpointer                      proxy_data)
+  CardsFromShardsAndItemsData *cards_data;
+  ShardSet                    *shard_set;
+  ThumbnailFds                *thumbnail_fds;
+  GVariant                    *model_props;
+} DeferredCardData;
+
+static DeferredCardData *
+deferred_card_data_new (CardsFromShardsAndItemsData *cards_data,
+                        ShardSet                    *shard_set,
+                        ThumbnailFds                *thumbnail_fds,
+                        GVariant                    *model_props)
 {
-  AppendStoresTaskData *data = g_new0 (AppendStoresTaskData, 1);
+  DeferredCardData *data = g_new0 (DeferredCardData, 1);
 
-  data->ka_proxy = g_object_ref (ka_proxy);
-  data->proxy_func = proxy_func;
-  data->proxy_return_destroy = proxy_return_destroy;
-  data->proxy_data = proxy_data;
+  data->cards_data = cards_from_shards_and_items_data_ref (cards_data);
+  data->shard_set = shard_set_ref (shard_set);
+  data->thumbnail_fds = thumbnail_fds != NULL ? thumbnail_fds_ref (thumbnail_fds) : NULL;
+  data->model_props = g_variant_ref (model_props);
 
   return data;
 }
 
 static void
-append_stores_task_data_free (AppendStoresTaskData *data)
+deferred_card_data_free (DeferredCardData *data)
 {
-  g_clear_object (&data->ka_proxy);
+  g_clear_pointer (&data->cards_data, cards_from_shards_and_items_data_unref);
+  g_clear_pointer (&data->shard_set, shard_set_unref);
+  g_clear_pointer (&data->thumbnail_fds, thumbnail_fds_unref);
+  g_clear_pointer (&data->model_props, g_variant_unref);
 
   g_free (data);
 }
 
-G_DEFINE_AUTOPTR_CLEANUP_FUNC (AppendStoresTaskData,
-                               append_stores_task_data_free)
+/* The synopsis of an item, or an empty one if it has none */
+static const gchar *
+lookup_synopsis (GVariant *model_props)
+{
+  const gchar *synopsis = lookup_string_in_dict_variant (model_props, "synopsis");
+
+  return synopsis != NULL ? synopsis : "";
+}
+
+/* Sanitize the synopsis of an item, unless it was already sanitized on
+ * an earlier refresh */
+static gchar *
+sanitize_synopsis_for_item (GVariant *model_props)
+{
+  const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
+  const gchar *synopsis = lookup_synopsis (model_props);
+  g_autofree gchar *sanitized = NULL;
+
+  if (ekn_id == NULL)
+    return content_feed_sanitize_synopsis (synopsis);
+
+  sanitized = synopsis_cache_lookup (ekn_id, synopsis);
+
+  if (sanitized != NULL)
+    return g_steal_pointer (&sanitized);
+
+  sanitized = content_feed_sanitize_synopsis (synopsis);
+  synopsis_cache_insert (ekn_id, synopsis, sanitized);
+
+  return g_steal_pointer (&sanitized);
+}
+
+/* Like sanitize_synopsis_for_item(), for all of @model_props_variants
+ * at once. Whatever is not in the cache is sanitized in one batch,
+ * which spreads the work out over the available processors for large
+ * replies. */
+static GPtrArray *
+sanitize_synopses_for_items (GPtrArray *model_props_variants)
+{
+  g_autoptr(GPtrArray) sanitized = g_ptr_array_new_full (model_props_variants->len, g_free);
+  g_autoptr(GArray) uncached_indices = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_autoptr(GPtrArray) uncached_synopses = g_ptr_array_new ();
+  g_autofree gchar **uncached_sanitized = NULL;
+  guint i = 0;
+
+  g_ptr_array_set_size (sanitized, model_props_variants->len);
+
+  for (i = 0; i < model_props_variants->len; ++i)
+    {
+      GVariant *model_props = g_ptr_array_index (model_props_variants, i);
+      const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
+      const gchar *synopsis = lookup_synopsis (model_props);
+
+      if (ekn_id != NULL)
+        g_ptr_array_index (sanitized, i) = synopsis_cache_lookup (ekn_id, synopsis);
+
+      if (g_ptr_array_index (sanitized, i) != NULL)
+        continue;
+
+      g_array_append_val (uncached_indices, i);
+      g_ptr_array_add (uncached_synopses, (gpointer) synopsis);
+    }
+
+  if (uncached_indices->len == 0)
+    return g_steal_pointer (&sanitized);
+
+  g_ptr_array_add (uncached_synopses, NULL);
+  uncached_sanitized = content_feed_sanitize_synopses ((const gchar * const *) uncached_synopses->pdata);
+
+  for (i = 0; i < uncached_indices->len; ++i)
+    {
+      guint item_index = g_array_index (uncached_indices, guint, i);
+      GVariant *model_props = g_ptr_array_index (model_props_variants, item_index);
+      const gchar *ekn_id = lookup_string_in_dict_variant (model_props, "ekn_id");
+
+      g_ptr_array_index (sanitized, item_index) = g_strdup (uncached_sanitized[i]);
+
+      if (ekn_id != NULL)
+        synopsis_cache_insert (ekn_id,
+                               g_ptr_array_index (uncached_synopses, i),
+                               uncached_sanitized[i]);
+    }
+
+  return g_steal_pointer (&sanitized);
+}
+
+static ContentFeedBaseCardStore *
+resolve_deferred_card (gpointer user_data)
+{
+  DeferredCardData *data = user_data;
+  g_autofree gchar *synopsis = NULL;
+
+  if (data->cards_data->has_synopsis)
+    synopsis = sanitize_synopsis_for_item (data->model_props);
+
+  return data->cards_data->card_func (data->shard_set,
+                                      data->thumbnail_fds,
+                                      data->model_props,
+                                      synopsis,
+                                      data->cards_data);
+}
+
+static GSList *
+cards_from_shards_and_items (ShardSet     *shard_set,
+                             ThumbnailFds *thumbnail_fds,
+                             const gchar  *section G_GNUC_UNUSED,
+                             GPtrArray    *model_props_variants,
+                             gpointer      user_data)
+{
+  CardsFromShardsAndItemsData *data = user_data;
+  const gchar *desktop_id = content_feed_knowledge_app_proxy_get_desktop_id (data->ka_proxy);
+  GSList *orderable_stores = NULL;
+  g_autoptr(GPtrArray) synopses = NULL;
+  guint i = 0;
+
+  if (data->has_synopsis && !data->defer_models)
+    synopses = sanitize_synopses_for_items (model_props_variants);
+
+  for (i = 0; i < model_props_variants->len; ++i)
+    {
+      GVariant *model_props = g_ptr_array_index (model_props_variants, i);
+      g_autoptr(ContentFeedBaseCardStore) store = NULL;
+
+      /* When deferring, only hang on to what we need to build the card
+       * later. Thumbnails and synopses are only loaded for the cards
+       * that survive ordering. */
+      if (data->defer_models)
+        {
+          if (data->is_valid_func != NULL && !data->is_valid_func (model_props))
+            continue;
+
+          orderable_stores = g_slist_prepend (orderable_stores,
+                                              orderable_model_new_deferred (data->type,
+                                                                            desktop_id,
+                                                                            resolve_deferred_card,
+                                                                            deferred_card_data_new (data,
+                                                                                                    shard_set,
+                                                                                                    thumbnail_fds,
+                                                                                                    model_props),
+                                                                            (GDestroyNotify) deferred_card_data_free));
+          continue;
+        }
+
+      store = data->card_func (shard_set,
+                               thumbnail_fds,
+                               model_props,
+                               synopses != NULL ? g_ptr_array_index (synopses, i) : NULL,
+                               data);
+
+      if (store == NULL)
+        continue;
+
+      orderable_stores = g_slist_prepend (orderable_stores,
+                                          content_feed_orderable_model_new (store,
+                                                                            data->type,
+                                                                            desktop_id));
+    }
+
+  /* Ordering takes cards from the front of the list, which has to be
+   * the front of the reply too for max-results to mean anything */
+  return g_slist_reverse (g_steal_pointer (&orderable_stores));
+}
+
+/* Tell the provider how many items ordering can possibly use and
+ * which keys we will look at, so that it does not send anything
+ * we will just throw away */
+static GVariant *
+card_query_options_new (CardsFromShardsAndItemsData *cards_data)
+{
+  GVariantBuilder builder;
+  guint max_results = model_ordering_max_cards_per_source (cards_data->type);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+  if (max_results > 0)
+    g_variant_builder_add (&builder, "{sv}", "max-results", g_variant_new_uint32 (max_results));
+
+  if (cards_data->fields != NULL)
+    g_variant_builder_add (&builder, "{sv}", "fields", g_variant_new_strv (cards_data->fields, -1));
+
+  return g_variant_new ("(a{sv})", &builder);
+}
+
+static void
+append_discovery_feed_content_from_proxy (ContentFeedKnowledgeAppProxy *ka_proxy,
+                                          gint                          timeout_msec,
+                                          CardsFromShardsAndItemsData  *cards_data,
+                                          GCancellable                 *cancellable,
+                                          GAsyncReadyCallback           callback,
+                                          gpointer                      user_data)
+{
+  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
+  const InterfaceRegistryEntry *registry_entry = interface_registry_lookup_for_proxy (dbus_proxy);
+  g_autoptr(GPtrArray) calls = g_ptr_array_new_with_free_func ((GDestroyNotify) method_call_free);
+  g_autoptr(GVariant) options = g_variant_ref_sink (card_query_options_new (cards_data));
+
+  /* Newest first, down to the plain method which every provider has */
+  if (registry_entry->thumbnail_fds_method_name != NULL &&
+      proxy_supports_method (dbus_proxy, registry_entry->thumbnail_fds_method_name))
+    g_ptr_array_add (calls, method_call_new (registry_entry->thumbnail_fds_method_name, options));
+
+  if (registry_entry->options_method_name != NULL &&
+      proxy_supports_method (dbus_proxy, registry_entry->options_method_name))
+    g_ptr_array_add (calls, method_call_new (registry_entry->options_method_name, options));
+
+  g_ptr_array_add (calls, method_call_new (registry_entry->method_name, NULL));
+
+  call_dbus_proxy_and_construct_from_models_and_shards (dbus_proxy,
+                                                        calls,
+                                                        timeout_msec,
+                                                        cards_from_shards_and_items,
+                                                        cards_data,
+                                                        (GDestroyNotify) cards_from_shards_and_items_data_unref,
+                                                        cards_data->defer_models,
+                                                        cancellable,
+                                                        callback,
+                                                        user_data);
+}
+
+/* Build cards for each interface in a bulk reply from @user_data, a
+ * table of the CardsFromShardsAndItemsData for each interface. Items
+ * for any other interface are ignored, since either we do not know
+ * what to make of them or the provider did not say that it has them. */
+static GSList *
+cards_from_shards_and_bulk_items (ShardSet     *shard_set,
+                                  ThumbnailFds *thumbnail_fds,
+                                  const gchar  *section,
+                                  GPtrArray    *model_props_variants,
+                                  gpointer      user_data)
+{
+  GHashTable *cards_data_by_interface = user_data;
+  CardsFromShardsAndItemsData *cards_data = g_hash_table_lookup (cards_data_by_interface,
+                                                                 section);
+
+  if (cards_data == NULL)
+    return NULL;
+
+  return cards_from_shards_and_items (shard_set,
+                                      thumbnail_fds,
+                                      section,
+                                      model_props_variants,
+                                      cards_data);
+}
 
 static void
-append_stores_task_from_proxy_thread (GTask        *task,
-                                      gpointer      source G_GNUC_UNUSED,
-                                      gpointer      task_data,
-                                      GCancellable *cancellable)
+received_all_fallback_content (GObject      *source G_GNUC_UNUSED,
+                               GAsyncResult *result,
+                               gpointer      user_data)
 {
-  AppendStoresTaskData *data = task_data;
+  g_autoptr(GTask) task = user_data;
   g_autoptr(GError) local_error = NULL;
-  gpointer results = NULL;
+  g_autoptr(GPtrArray) results = g_task_propagate_pointer (G_TASK (result),
+                                                           &local_error);
+  g_autoptr(GError) first_error = NULL;
+  GSList *models = NULL;
+  gboolean any_succeeded = FALSE;
+  guint i = 0;
 
-  if (!data->proxy_func (data->ka_proxy,
-                         data->proxy_data,
-                         cancellable,
-                         &results,
-                         &local_error))
+  if (results == NULL)
     {
       g_task_return_error (task, g_steal_pointer (&local_error));
       return;
     }
 
-  g_task_return_pointer (task, g_steal_pointer (&results), data->proxy_return_destroy);
+  for (i = 0; i < results->len; ++i)
+    {
+      GSList *result_list = NULL;
+
+      task_note_dispatch_time (task, task_get_dispatch_time (g_ptr_array_index (results, i)));
+      result_list = g_task_propagate_pointer (g_ptr_array_index (results, i),
+                                              &local_error);
+
+      if (local_error != NULL)
+        {
+          g_message ("Query failed: %s", local_error->message);
+
+          if (first_error == NULL)
+            first_error = g_steal_pointer (&local_error);
+
+          g_clear_error (&local_error);
+          continue;
+        }
+
+      any_succeeded = TRUE;
+      models = g_slist_concat (models, result_list);
+    }
+
+  /* Only fail if nothing worked, so that the caller can tell if the
+   * provider was late */
+  if (!any_succeeded && first_error != NULL)
+    {
+      g_task_return_error (task, g_steal_pointer (&first_error));
+      return;
+    }
+
+  g_task_return_pointer (task, models, (GDestroyNotify) object_slist_free);
+}
+
+typedef struct _BulkContentData
+{
+  GHashTable *cards_data_by_interface;
+  gint        timeout_msec;
+} BulkContentData;
+
+static BulkContentData *
+bulk_content_data_new (GHashTable *cards_data_by_interface,
+                       gint        timeout_msec)
+{
+  BulkContentData *data = g_new0 (BulkContentData, 1);
+
+  data->cards_data_by_interface = g_hash_table_ref (cards_data_by_interface);
+  data->timeout_msec = timeout_msec;
+
+  return data;
 }
 
 static void
-append_stores_task_from_proxy (ContentFeedKnowledgeAppProxy *ka_proxy,
-                               AppendStoresFromProxyFunc     proxy_func,
-                               GDestroyNotify                proxy_return_destroy,
-                               gpointer                      proxy_func_data,
-                               GCancellable                 *cancellable,
-                               GAsyncReadyCallback           callback,
-                               gpointer                      user_data)
+bulk_content_data_free (BulkContentData *data)
 {
-  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
-  g_autoptr(AppendStoresTaskData) data = append_stores_task_data_new (ka_proxy,
-                                                                      proxy_func,
-                                                                      proxy_return_destroy,
-                                                                      proxy_func_data);
+  g_clear_pointer (&data->cards_data_by_interface, g_hash_table_unref);
 
-  g_task_set_return_on_cancel (task, TRUE);
-  g_task_set_task_data (task,
-                        g_steal_pointer (&data),
-                        (GDestroyNotify) append_stores_task_data_free);
-  g_task_run_in_thread (task, append_stores_task_from_proxy_thread);
+  g_free (data);
 }
 
 static void
-object_slist_free (GSList *slist)
+received_bulk_content (GObject      *source G_GNUC_UNUSED,
+                       GAsyncResult *result,
+                       gpointer      user_data)
 {
-  g_slist_free_full (slist, g_object_unref);
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GError) local_error = NULL;
+  GSList *models = g_task_propagate_pointer (G_TASK (result), &local_error);
+  BulkContentData *data = g_task_get_task_data (task);
+  GCancellable *cancellable = g_task_get_cancellable (task);
+  AllTasksResultsClosure *all_tasks_closure = NULL;
+  GHashTableIter iter;
+  CardsFromShardsAndItemsData *cards_data = NULL;
+
+  task_note_dispatch_time (task, task_get_dispatch_time (result));
+
+  if (local_error == NULL)
+    {
+      g_task_return_pointer (task, models, (GDestroyNotify) object_slist_free);
+      return;
+    }
+
+  if (!g_error_matches (local_error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD) &&
+      !g_error_matches (local_error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_INTERFACE))
+    {
+      g_task_return_error (task, g_steal_pointer (&local_error));
+      return;
+    }
+
+  /* The provider said that it implements the bulk interface, but it
+   * does not, so ask for each kind of card separately instead */
+  g_message ("Bulk query failed, querying each interface instead: %s",
+             local_error->message);
+
+  all_tasks_closure = all_tasks_results_closure_new (g_object_unref,
+                                                     received_all_fallback_content,
+                                                     g_object_ref (task));
+
+  g_hash_table_iter_init (&iter, data->cards_data_by_interface);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &cards_data))
+    {
+      append_discovery_feed_content_from_proxy (cards_data->ka_proxy,
+                                                data->timeout_msec,
+                                                cards_from_shards_and_items_data_ref (cards_data),
+                                                cancellable,
+                                                individual_task_result_completed,
+                                                individual_task_result_closure_new (all_tasks_closure));
+    }
+
+  if (!all_tasks_results_has_tasks_remaining (all_tasks_closure))
+    all_tasks_results_return_now (all_tasks_closure);
+}
+
+static gboolean
+all_cards_data_defer_models (GHashTable *cards_data_by_interface)
+{
+  GHashTableIter iter;
+  gpointer value = NULL;
+
+  g_hash_table_iter_init (&iter, cards_data_by_interface);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      CardsFromShardsAndItemsData *cards_data = value;
+
+      if (!cards_data->defer_models)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Get the cards for all of the interfaces in @cards_data_by_interface
+ * from one call to the bulk interface on @bulk_ka_proxy, falling back
+ * to calling each interface if the provider turns out not to implement
+ * it after all */
+static void
+append_discovery_feed_bulk_content_from_proxy (ContentFeedKnowledgeAppProxy *bulk_ka_proxy,
+                                               GHashTable                   *cards_data_by_interface,
+                                               gint                          timeout_msec,
+                                               GCancellable                 *cancellable,
+                                               GAsyncReadyCallback           callback,
+                                               gpointer                      user_data)
+{
+  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
+  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (bulk_ka_proxy);
+  g_autoptr(GPtrArray) calls = g_ptr_array_new_with_free_func ((GDestroyNotify) method_call_free);
+
+  g_task_set_task_data (task,
+                        bulk_content_data_new (cards_data_by_interface, timeout_msec),
+                        (GDestroyNotify) bulk_content_data_free);
+
+  g_ptr_array_add (calls,
+                   method_call_new (interface_registry_lookup_for_proxy (dbus_proxy)->method_name,
+                                    NULL));
+
+  call_dbus_proxy_and_construct_from_models_and_shards (dbus_proxy,
+                                                        calls,
+                                                        timeout_msec,
+                                                        cards_from_shards_and_bulk_items,
+                                                        g_hash_table_ref (cards_data_by_interface),
+                                                        (GDestroyNotify) g_hash_table_unref,
+                                                        all_cards_data_defer_models (cards_data_by_interface),
+                                                        cancellable,
+                                                        received_bulk_content,
+                                                        g_steal_pointer (&task));
 }
 
 static void
@@ -700,6 +1355,9 @@ marshal_word_quote_into_store (GObject      *source G_GNUC_UNUSED,
       return;
     }
 
+  task_note_dispatch_time (task, task_get_dispatch_time (g_ptr_array_index (word_quote_results, 0)));
+  task_note_dispatch_time (task, task_get_dispatch_time (g_ptr_array_index (word_quote_results, 1)));
+
   word_store = g_task_propagate_pointer (G_TASK (g_ptr_array_index (word_quote_results, 0)),
                                          &local_error);
 
@@ -745,23 +1403,6 @@ word_card_from_item (GVariant *model_props,
                                                      definition));
 }
 
-static gboolean
-append_discovery_feed_word_from_proxy (ContentFeedKnowledgeAppProxy  *ka_proxy,
-                                       gpointer                       proxy_data G_GNUC_UNUSED,
-                                       GCancellable                  *cancellable,
-                                       gpointer                      *out_result,
-                                       GError                       **error)
-{
-  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
-  return call_dbus_proxy_and_construct_from_model (dbus_proxy,
-                                                   "GetWordOfTheDay",
-                                                   word_card_from_item,
-                                                   NULL,
-                                                   cancellable,
-                                                   out_result,
-                                                   error);
-}
-
 static GObject *
 quote_card_from_item (GVariant *model_props,
                       gpointer  user_data G_GNUC_UNUSED)
@@ -772,27 +1413,10 @@ quote_card_from_item (GVariant *model_props,
   return G_OBJECT (content_feed_quote_card_store_new (title, author));
 }
 
-static gboolean
-append_discovery_feed_quote_from_proxy (ContentFeedKnowledgeAppProxy  *ka_proxy,
-                                        gpointer                       proxy_data G_GNUC_UNUSED,
-                                        GCancellable                  *cancellable,
-                                        gpointer                      *out_result,
-                                        GError                       **error)
-{
-  GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
-
-  return call_dbus_proxy_and_construct_from_model (dbus_proxy,
-                                                   "GetQuoteOfTheDay",
-                                                   quote_card_from_item,
-                                                   NULL,
-                                                   cancellable,
-                                                   out_result,
-                                                   error);
-}
-
 static void
 append_discovery_feed_word_quote_from_proxies (ContentFeedKnowledgeAppProxy *word_ka_proxy,
                                                ContentFeedKnowledgeAppProxy *quote_ka_proxy,
+                                               gint                          timeout_msec,
                                                GCancellable                 *cancellable,
                                                GAsyncReadyCallback           callback,
                                                gpointer                      user_data)
@@ -801,105 +1425,299 @@ append_discovery_feed_word_quote_from_proxies (ContentFeedKnowledgeAppProxy *wor
   AllTasksResultsClosure *all_tasks_closure = all_tasks_results_closure_new (g_object_unref,
                                                                              marshal_word_quote_into_store,
                                                                              g_steal_pointer (&task));
+  GDBusProxy *word_dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (word_ka_proxy);
+  GDBusProxy *quote_dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (quote_ka_proxy);
 
   /* Ignoring the return values here, recall that the task's lifecycle owns
    * the task */
-  append_stores_task_from_proxy (word_ka_proxy,
-                                 append_discovery_feed_word_from_proxy,
-                                 g_object_unref,
-                                 NULL,
-                                 cancellable,
-                                 individual_task_result_completed,
-                                 individual_task_result_closure_new (all_tasks_closure));
-
-  append_stores_task_from_proxy (quote_ka_proxy,
-                                 append_discovery_feed_quote_from_proxy,
-                                 g_object_unref,
-                                 NULL,
-                                 cancellable,
-                                 individual_task_result_completed,
-                                 individual_task_result_closure_new (all_tasks_closure));
+  call_dbus_proxy_and_construct_from_model (word_dbus_proxy,
+                                            interface_registry_lookup_for_proxy (word_dbus_proxy)->method_name,
+                                            timeout_msec,
+                                            word_card_from_item,
+                                            NULL,
+                                            cancellable,
+                                            individual_task_result_completed,
+                                            individual_task_result_closure_new (all_tasks_closure));
+
+  call_dbus_proxy_and_construct_from_model (quote_dbus_proxy,
+                                            interface_registry_lookup_for_proxy (quote_dbus_proxy)->method_name,
+                                            timeout_msec,
+                                            quote_card_from_item,
+                                            NULL,
+                                            cancellable,
+                                            individual_task_result_completed,
+                                            individual_task_result_closure_new (all_tasks_closure));
 
   if (!all_tasks_results_has_tasks_remaining (all_tasks_closure))
     all_tasks_results_return_now (all_tasks_closure);
 }
 
+typedef struct _UnorderedResultsData
+{
+  GPtrArray                            *slot_sources;
+  GPtrArray                            *late_providers;
+  guint                                 n_failed_slots;
+  ContentFeedUnorderedResultsBatchFunc  batch_func;
+  gpointer                              batch_data;
+  GDestroyNotify                        batch_data_destroy;
+  gboolean                              completed;
+
+  /* All of the calls for the query are made with this, so that the
+   * ones still waiting in the activation gate can be dropped once we
+   * have returned. It is cancelled along with the caller's
+   * cancellable. */
+  GCancellable                         *query_cancellable;
+  GCancellable                         *cancellable;
+  gulong                                cancelled_id;
+} UnorderedResultsData;
+
 static void
-unordered_card_arrays_from_queries (GPtrArray           *ka_proxies,
-                                    GCancellable        *cancellable,
-                                    GAsyncReadyCallback  callback,
-                                    gpointer             user_data)
+on_unordered_results_cancelled (GCancellable *cancellable G_GNUC_UNUSED,
+                                gpointer      user_data)
 {
-  AllTasksResultsClosure *all_tasks_closure = all_tasks_results_closure_new (g_object_unref,
-                                                                             callback,
-                                                                             user_data);
-  guint i = 0;
-  g_autoptr(GPtrArray) word_proxies = g_ptr_array_new ();
-  g_autoptr(GPtrArray) quote_proxies = g_ptr_array_new ();
+  g_cancellable_cancel (G_CANCELLABLE (user_data));
+}
 
-  for (i = 0; i < ka_proxies->len; ++i)
+static UnorderedResultsData *
+unordered_results_data_new (ContentFeedUnorderedResultsBatchFunc batch_func,
+                            gpointer                             batch_data,
+                            GDestroyNotify                       batch_data_destroy,
+                            GCancellable                        *cancellable)
+{
+  UnorderedResultsData *data = g_new0 (UnorderedResultsData, 1);
+
+  data->slot_sources = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+  data->late_providers = g_ptr_array_new_with_free_func (g_free);
+  data->batch_func = batch_func;
+  data->batch_data = batch_data;
+  data->batch_data_destroy = batch_data_destroy;
+  data->query_cancellable = g_cancellable_new ();
+
+  if (cancellable != NULL)
     {
-      ContentFeedKnowledgeAppProxy *ka_proxy = g_ptr_array_index (ka_proxies, i);
-      GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
-      const gchar *interface_name = g_dbus_proxy_get_interface_name (dbus_proxy);
-
-      if (g_strcmp0 (interface_name, "com.endlessm.DiscoveryFeedContent") == 0)
-        append_stores_task_from_proxy (ka_proxy,
-                                       append_discovery_feed_content_from_proxy,
-                                       (GDestroyNotify) object_slist_free,
-                                       append_discovery_feed_content_from_proxy_data_new ("ArticleCardDescriptions",
-                                                                                          CONTENT_FEED_CARD_STORE_TYPE_ARTICLE_CARD,
-                                                                                          CONTENT_FEED_CARD_LAYOUT_DIRECTION_IMAGE_FIRST,
-                                                                                          content_feed_knowledge_app_card_store_new,
-                                                                                          CONTENT_FEED_THUMBNAIL_SIZE_ARTICLE),
-                                       cancellable,
-                                       individual_task_result_completed,
-                                       individual_task_result_closure_new (all_tasks_closure));
-      else if (g_strcmp0 (interface_name, "com.endlessm.DiscoveryFeedNews") == 0)
-        append_stores_task_from_proxy (ka_proxy,
-                                       append_discovery_feed_content_from_proxy,
-                                       (GDestroyNotify) object_slist_free,
-                                       append_discovery_feed_content_from_proxy_data_new ("GetRecentNews",
-                                                                                          CONTENT_FEED_CARD_STORE_TYPE_ARTICLE_CARD,
-                                                                                          CONTENT_FEED_CARD_LAYOUT_DIRECTION_IMAGE_LAST,
-                                                                                          (ContentFeedKnowledgeAppCardStoreFactoryFunc) content_feed_knowledge_app_news_card_store_new,
-                                                                                          CONTENT_FEED_THUMBNAIL_SIZE_NEWS),
-                                       cancellable,
-                                       individual_task_result_completed,
-                                       individual_task_result_closure_new (all_tasks_closure));
-      else if (g_strcmp0 (interface_name, "com.endlessm.DiscoveryFeedVideo") == 0)
-        append_stores_task_from_proxy (ka_proxy,
-                                       append_discovery_feed_video_from_proxy,
-                                       (GDestroyNotify) object_slist_free,
-                                       NULL,
-                                       cancellable,
-                                       individual_task_result_completed,
-                                       individual_task_result_closure_new (all_tasks_closure));
-      else if (g_strcmp0 (interface_name, "com.endlessm.DiscoveryFeedArtwork") == 0)
-        append_stores_task_from_proxy (ka_proxy,
-                                       append_discovery_feed_artwork_from_proxy,
-                                       (GDestroyNotify) object_slist_free,
-                                       NULL,
-                                       cancellable,
-                                       individual_task_result_completed,
-                                       individual_task_result_closure_new (all_tasks_closure));
-      else if (g_strcmp0 (interface_name, "com.endlessm.DiscoveryFeedWord") == 0)
-        g_ptr_array_add (word_proxies, ka_proxy);
-      else if (g_strcmp0 (interface_name, "com.endlessm.DiscoveryFeedQuote") == 0)
-        g_ptr_array_add (quote_proxies, ka_proxy);
+      data->cancellable = g_object_ref (cancellable);
+      data->cancelled_id = g_cancellable_connect (cancellable,
+                                                  G_CALLBACK (on_unordered_results_cancelled),
+                                                  g_object_ref (data->query_cancellable),
+                                                  g_object_unref);
     }
 
-  for (i = 0; i < MIN (word_proxies->len, quote_proxies->len); ++i)
+  return data;
+}
+
+static void
+unordered_results_data_free (UnorderedResultsData *data)
+{
+  g_clear_pointer (&data->slot_sources, g_ptr_array_unref);
+  g_clear_pointer (&data->late_providers, g_ptr_array_unref);
+
+  if (data->cancellable != NULL)
+    g_cancellable_disconnect (data->cancellable, data->cancelled_id);
+  g_clear_object (&data->cancellable);
+  g_clear_object (&data->query_cancellable);
+
+  if (data->batch_data_destroy != NULL)
+    g_clear_pointer (&data->batch_data, data->batch_data_destroy);
+
+  g_free (data);
+}
+
+typedef struct _ReceivedBatchClosure
+{
+  GTask                       *task;
+  IndividualTaskResultClosure *individual_closure;
+} ReceivedBatchClosure;
+
+static ReceivedBatchClosure *
+received_batch_closure_new (GTask                       *task,
+                            IndividualTaskResultClosure *individual_closure)
+{
+  ReceivedBatchClosure *closure = g_new0 (ReceivedBatchClosure, 1);
+
+  closure->task = g_object_ref (task);
+  closure->individual_closure = individual_closure;
+
+  return closure;
+}
+
+static void
+received_batch_closure_free (ReceivedBatchClosure *closure)
+{
+  g_clear_object (&closure->task);
+
+  g_free (closure);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ReceivedBatchClosure,
+                               received_batch_closure_free)
+
+/* Pass each provider's models to the batch callback as soon as they
+ * arrive, then hand them on to the AllTasksResultsClosure as usual.
+ * The GTask can only be propagated once, so the result is forwarded
+ * on a new GTask. */
+static void
+received_batch (GObject      *source G_GNUC_UNUSED,
+                GAsyncResult *result,
+                gpointer      user_data)
+{
+  g_autoptr(ReceivedBatchClosure) closure = user_data;
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GTask) forwarded_task = g_task_new (NULL, NULL, NULL, NULL);
+  GSList *models = g_task_propagate_pointer (G_TASK (result), &local_error);
+  UnorderedResultsData *data = g_task_get_task_data (closure->task);
+  GCancellable *cancellable = g_task_get_cancellable (closure->task);
+
+  if (local_error != NULL)
     {
-      append_discovery_feed_word_quote_from_proxies (g_ptr_array_index (word_proxies, i),
-                                                     g_ptr_array_index (quote_proxies, i),
-                                                     cancellable,
-                                                     individual_task_result_completed,
-                                                     individual_task_result_closure_new (all_tasks_closure));
+      g_task_return_error (forwarded_task, g_steal_pointer (&local_error));
+    }
+  else
+    {
+      /* Nothing more is reported once we have completed, either
+       * because everything arrived or the deadline passed */
+      if (models != NULL &&
+          !data->completed &&
+          !g_cancellable_is_cancelled (cancellable))
+        data->batch_func (models, data->batch_data);
+
+      g_task_return_pointer (forwarded_task,
+                             models,
+                             (GDestroyNotify) object_slist_free);
     }
 
-  if (!all_tasks_results_has_tasks_remaining (all_tasks_closure))
-    all_tasks_results_return_now (all_tasks_closure);
+  individual_task_result_completed (NULL,
+                                    G_ASYNC_RESULT (forwarded_task),
+                                    g_steal_pointer (&closure->individual_closure));
+}
+
+/* Record which providers the result in the next slot of the
+ * AllTasksResultsClosure came from, so that we can say which ones
+ * were late */
+static void
+add_slot_sources (GPtrArray                    *slot_sources,
+                  ContentFeedKnowledgeAppProxy *ka_proxy,
+                  ContentFeedKnowledgeAppProxy *other_ka_proxy)
+{
+  GPtrArray *desktop_ids = g_ptr_array_new ();
+
+  g_ptr_array_add (desktop_ids,
+                   g_strdup (content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy)));
+
+  if (other_ka_proxy != NULL)
+    g_ptr_array_add (desktop_ids,
+                     g_strdup (content_feed_knowledge_app_proxy_get_desktop_id (other_ka_proxy)));
+
+  g_ptr_array_add (desktop_ids, NULL);
+  g_ptr_array_add (slot_sources, g_ptr_array_free (desktop_ids, FALSE));
+}
+
+typedef struct _ScoredResultClosure
+{
+  GStrv                desktop_ids;
+  gint64               start_time;
+  GAsyncReadyCallback  callback;
+  gpointer             user_data;
+} ScoredResultClosure;
+
+static ScoredResultClosure *
+scored_result_closure_new (GStrv               desktop_ids,
+                           GAsyncReadyCallback callback,
+                           gpointer            user_data)
+{
+  ScoredResultClosure *closure = g_new0 (ScoredResultClosure, 1);
+
+  closure->desktop_ids = g_strdupv (desktop_ids);
+  closure->start_time = g_get_monotonic_time ();
+  closure->callback = callback;
+  closure->user_data = user_data;
+
+  return closure;
+}
+
+static void
+scored_result_closure_free (ScoredResultClosure *closure)
+{
+  g_clear_pointer (&closure->desktop_ids, g_strfreev);
+
+  g_free (closure);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ScoredResultClosure,
+                               scored_result_closure_free)
+
+/* Record how long each provider's result took and whether it failed on
+ * the scoreboard, then forward it on a new GTask. This sees the result
+ * even if it comes in after the deadline, so that the real latency of
+ * slow providers is recorded. */
+static void
+received_scored_result (GObject      *source G_GNUC_UNUSED,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  g_autoptr(ScoredResultClosure) closure = user_data;
+  g_autoptr(GError) local_error = NULL;
+  g_autoptr(GTask) forwarded_task = g_task_new (NULL, NULL, NULL, NULL);
+  GSList *models = g_task_propagate_pointer (G_TASK (result), &local_error);
+  gint64 dispatch_time = task_get_dispatch_time (result);
+  gint64 latency_usec = 0;
+  gchar **iter = closure->desktop_ids;
+
+  /* Only count from when the provider was actually called, so that
+   * time spent queued behind other activations does not count against
+   * it. Calls that never left the queue fall back to when the query
+   * started. */
+  latency_usec = g_get_monotonic_time () - (dispatch_time != 0 ? dispatch_time : closure->start_time);
+
+  /* Being cancelled says nothing about the provider */
+  if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    for (; *iter != NULL; ++iter)
+      provider_scoreboard_record (*iter, latency_usec, local_error == NULL);
+
+  if (local_error != NULL)
+    g_task_return_error (forwarded_task, g_steal_pointer (&local_error));
+  else
+    g_task_return_pointer (forwarded_task,
+                           models,
+                           (GDestroyNotify) object_slist_free);
+
+  closure->callback (NULL, G_ASYNC_RESULT (forwarded_task), closure->user_data);
+}
+
+/* Where the result from @ka_proxy, and @other_ka_proxy if it shares
+ * the slot, should go. Normally straight to the AllTasksResultsClosure,
+ * but through received_batch() first if the caller asked for batches.
+ * Either way, it is scored on the way. */
+static void
+result_callback_for_next_slot (AllTasksResultsClosure        *all_tasks_closure,
+                               GTask                         *task,
+                               ContentFeedKnowledgeAppProxy  *ka_proxy,
+                               ContentFeedKnowledgeAppProxy  *other_ka_proxy,
+                               GAsyncReadyCallback           *out_callback,
+                               gpointer                      *out_user_data)
+{
+  UnorderedResultsData *data = g_task_get_task_data (task);
+  IndividualTaskResultClosure *individual_closure = individual_task_result_closure_new (all_tasks_closure);
+  GAsyncReadyCallback callback = NULL;
+  gpointer user_data = NULL;
+
+  add_slot_sources (data->slot_sources, ka_proxy, other_ka_proxy);
+
+  if (data->batch_func == NULL)
+    {
+      callback = individual_task_result_completed;
+      user_data = individual_closure;
+    }
+  else
+    {
+      callback = received_batch;
+      user_data = received_batch_closure_new (task, individual_closure);
+    }
+
+  *out_callback = received_scored_result;
+  *out_user_data = scored_result_closure_new (g_ptr_array_index (data->slot_sources,
+                                                                 data->slot_sources->len - 1),
+                                              callback,
+                                              user_data);
 }
 
 static void
@@ -912,8 +1730,18 @@ received_all_unordered_card_array_results_from_queries (GObject      *source G_G
                                                            &local_error);
   GSList *all_unordered_elements = NULL;
   g_autoptr(GTask) task = user_data;
+  UnorderedResultsData *data = g_task_get_task_data (task);
   guint i = 0;
 
+  /* No more batches after this point, even if late results arrive */
+  data->completed = TRUE;
+
+  /* If the deadline passed, do not activate the providers that were
+   * still waiting for their turn just to throw their results away.
+   * The calls which were already made are left to complete, so that
+   * their latency is still recorded. */
+  activation_gate_drop_queued_calls (data->query_cancellable);
+
   /* This basically shouldn't happen, but handle it anyway */
   if (results == NULL)
     {
@@ -934,6 +1762,19 @@ received_all_unordered_card_array_results_from_queries (GObject      *source G_G
       if (local_error != NULL)
         {
           g_message ("Query failed: %s", local_error->message);
+          ++data->n_failed_slots;
+
+          /* Either the call itself timed out or we gave up waiting
+           * for it at the deadline */
+          if (g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+            {
+              GStrv desktop_ids = g_ptr_array_index (data->slot_sources, i);
+              gchar **iter = desktop_ids;
+
+              for (; *iter != NULL; ++iter)
+                g_ptr_array_add (data->late_providers, g_strdup (*iter));
+            }
+
           g_clear_error (&local_error);
           continue;
         }
@@ -946,6 +1787,204 @@ received_all_unordered_card_array_results_from_queries (GObject      *source G_G
                          (GDestroyNotify) object_slist_free);
 }
 
+/* The proxies for each of the interfaces of a provider all share its
+ * bus name and object path */
+static gchar *
+provider_object_key (GDBusProxy *dbus_proxy)
+{
+  const gchar *bus_name = g_dbus_proxy_get_name (dbus_proxy);
+
+  return g_strconcat (bus_name != NULL ? bus_name : "",
+                      " ",
+                      g_dbus_proxy_get_object_path (dbus_proxy),
+                      NULL);
+}
+
+static void
+unordered_card_arrays_from_queries (GPtrArray                        *ka_proxies,
+                                    ContentFeedUnorderedResultsFlags  flags,
+                                    gint                              call_timeout_msec,
+                                    gint                              deadline_msec,
+                                    GTask                            *task)
+{
+  UnorderedResultsData *data = g_task_get_task_data (task);
+  GCancellable *cancellable = data->query_cancellable;
+  AllTasksResultsClosure *all_tasks_closure = all_tasks_results_closure_new (g_object_unref,
+                                                                             received_all_unordered_card_array_results_from_queries,
+                                                                             g_object_ref (task));
+  gboolean defer_models = (flags & CONTENT_FEED_UNORDERED_RESULTS_FLAGS_DEFER_MODELS) != 0;
+  guint i = 0;
+  g_autoptr(GPtrArray) word_proxies = g_ptr_array_new ();
+  g_autoptr(GPtrArray) quote_proxies = g_ptr_array_new ();
+  g_autoptr(GHashTable) bulk_proxies = g_hash_table_new_full (g_str_hash,
+                                                              g_str_equal,
+                                                              g_free,
+                                                              NULL);
+  g_autoptr(GHashTable) bulk_cards_data = g_hash_table_new_full (g_str_hash,
+                                                                 g_str_equal,
+                                                                 g_free,
+                                                                 (GDestroyNotify) g_hash_table_unref);
+  GAsyncReadyCallback slot_callback = NULL;
+  gpointer slot_user_data = NULL;
+  g_autoptr(GHashTable) skipped_providers = g_hash_table_new (g_str_hash, g_str_equal);
+  g_autoptr(GHashTable) admitted_providers = g_hash_table_new (g_str_hash, g_str_equal);
+  GHashTableIter iter;
+  gpointer object_key = NULL;
+  gpointer cards_data_by_interface = NULL;
+
+  /* Ask the scoreboard about each provider once, so that all of its
+   * interfaces are either skipped or queried together */
+  for (i = 0; i < ka_proxies->len; ++i)
+    {
+      ContentFeedKnowledgeAppProxy *ka_proxy = g_ptr_array_index (ka_proxies, i);
+      const gchar *desktop_id = content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy);
+
+      if (g_hash_table_contains (skipped_providers, desktop_id) ||
+          g_hash_table_contains (admitted_providers, desktop_id))
+        continue;
+
+      if (provider_scoreboard_admit (desktop_id))
+        g_hash_table_add (admitted_providers, (gpointer) desktop_id);
+      else
+        g_hash_table_add (skipped_providers, (gpointer) desktop_id);
+    }
+
+  /* Providers that implement the bulk interface get the cards for all
+   * their other interfaces from one call, so find those first */
+  for (i = 0; i < ka_proxies->len; ++i)
+    {
+      ContentFeedKnowledgeAppProxy *ka_proxy = g_ptr_array_index (ka_proxies, i);
+      GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
+      const InterfaceRegistryEntry *registry_entry = interface_registry_lookup_for_proxy (dbus_proxy);
+
+      if (g_hash_table_contains (skipped_providers,
+                                 content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy)))
+        continue;
+
+      if (registry_entry != NULL && registry_entry->marshaller == INTERFACE_MARSHALLER_BULK)
+        g_hash_table_replace (bulk_proxies, provider_object_key (dbus_proxy), ka_proxy);
+    }
+
+  for (i = 0; i < ka_proxies->len; ++i)
+    {
+      ContentFeedKnowledgeAppProxy *ka_proxy = g_ptr_array_index (ka_proxies, i);
+      GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
+      const InterfaceRegistryEntry *registry_entry = interface_registry_lookup_for_proxy (dbus_proxy);
+      g_autoptr(CardsFromShardsAndItemsData) cards_data = NULL;
+
+      if (registry_entry == NULL)
+        continue;
+
+      if (g_hash_table_contains (skipped_providers,
+                                 content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy)))
+        continue;
+
+      switch (registry_entry->marshaller)
+        {
+        case INTERFACE_MARSHALLER_ARTICLE:
+        case INTERFACE_MARSHALLER_VIDEO:
+        case INTERFACE_MARSHALLER_ARTWORK:
+          cards_data = cards_from_shards_and_items_data_new (ka_proxy,
+                                                             registry_entry,
+                                                             &card_marshaller_funcs[registry_entry->marshaller],
+                                                             defer_models);
+          break;
+        case INTERFACE_MARSHALLER_WORD:
+          g_ptr_array_add (word_proxies, ka_proxy);
+          continue;
+        case INTERFACE_MARSHALLER_QUOTE:
+          g_ptr_array_add (quote_proxies, ka_proxy);
+          continue;
+        default:
+          continue;
+        }
+
+      if (g_hash_table_size (bulk_proxies) > 0)
+        {
+          g_autofree gchar *provider_key = provider_object_key (dbus_proxy);
+
+          if (g_hash_table_contains (bulk_proxies, provider_key))
+            {
+              GHashTable *provider_cards_data = g_hash_table_lookup (bulk_cards_data, provider_key);
+
+              if (provider_cards_data == NULL)
+                {
+                  provider_cards_data = g_hash_table_new_full (g_str_hash,
+                                                               g_str_equal,
+                                                               NULL,
+                                                               (GDestroyNotify) cards_from_shards_and_items_data_unref);
+                  g_hash_table_insert (bulk_cards_data,
+                                       g_steal_pointer (&provider_key),
+                                       provider_cards_data);
+                }
+
+              /* Interface names in the registry are static */
+              g_hash_table_replace (provider_cards_data,
+                                    (gpointer) registry_entry->interface_name,
+                                    g_steal_pointer (&cards_data));
+              continue;
+            }
+        }
+
+      result_callback_for_next_slot (all_tasks_closure,
+                                     task,
+                                     ka_proxy,
+                                     NULL,
+                                     &slot_callback,
+                                     &slot_user_data);
+      append_discovery_feed_content_from_proxy (ka_proxy,
+                                                call_timeout_msec,
+                                                g_steal_pointer (&cards_data),
+                                                cancellable,
+                                                slot_callback,
+                                                slot_user_data);
+    }
+
+  for (i = 0; i < MIN (word_proxies->len, quote_proxies->len); ++i)
+    {
+      result_callback_for_next_slot (all_tasks_closure,
+                                     task,
+                                     g_ptr_array_index (word_proxies, i),
+                                     g_ptr_array_index (quote_proxies, i),
+                                     &slot_callback,
+                                     &slot_user_data);
+      append_discovery_feed_word_quote_from_proxies (g_ptr_array_index (word_proxies, i),
+                                                     g_ptr_array_index (quote_proxies, i),
+                                                     call_timeout_msec,
+                                                     cancellable,
+                                                     slot_callback,
+                                                     slot_user_data);
+    }
+
+  g_hash_table_iter_init (&iter, bulk_cards_data);
+  while (g_hash_table_iter_next (&iter, &object_key, &cards_data_by_interface))
+    {
+      ContentFeedKnowledgeAppProxy *bulk_ka_proxy = g_hash_table_lookup (bulk_proxies, object_key);
+
+      result_callback_for_next_slot (all_tasks_closure,
+                                     task,
+                                     bulk_ka_proxy,
+                                     NULL,
+                                     &slot_callback,
+                                     &slot_user_data);
+      append_discovery_feed_bulk_content_from_proxy (bulk_ka_proxy,
+                                                     cards_data_by_interface,
+                                                     call_timeout_msec,
+                                                     cancellable,
+                                                     slot_callback,
+                                                     slot_user_data);
+    }
+
+  if (!all_tasks_results_has_tasks_remaining (all_tasks_closure))
+    {
+      all_tasks_results_return_now (all_tasks_closure);
+      return;
+    }
+
+  if (deadline_msec >= 0)
+    all_tasks_results_closure_set_deadline (all_tasks_closure, deadline_msec);
+}
+
 /**
  * content_feed_unordered_results_from_queries_finish:
  * @result: A #GAsyncResult
@@ -988,12 +2027,723 @@ content_feed_unordered_results_from_queries (GPtrArray           *ka_proxies,
                                              GAsyncReadyCallback  callback,
                                              gpointer             user_data)
 {
-  GTask *task = g_task_new (NULL, cancellable, callback, user_data);
+  content_feed_unordered_results_from_queries_full (ka_proxies,
+                                                    0,
+                                                    -1,
+                                                    -1,
+                                                    cancellable,
+                                                    callback,
+                                                    user_data);
+}
+
+/**
+ * content_feed_unordered_results_from_queries_full_finish:
+ * @result: A #GAsyncResult
+ * @out_late_providers: (out) (optional) (array zero-terminated=1) (transfer full):
+ *                      Return location for the desktop IDs of the providers
+ *                      which did not reply in time.
+ * @error: A #GError
+ *
+ * Complete a call to content_feed_unordered_results_from_queries_full().
+ * Apart from @out_late_providers, this is the same as
+ * content_feed_unordered_results_from_queries_finish().
+ *
+ * Returns: (transfer container) (element-type ContentFeedBaseCardStore):
+ *          A #GSList of #ContentFeedBaseCardStore, as returned by
+ *          content_feed_unordered_results_from_queries_finish().
+ */
+GSList *
+content_feed_unordered_results_from_queries_full_finish (GAsyncResult   *result,
+                                                         gchar        ***out_late_providers,
+                                                         GError        **error)
+{
+  g_autoptr(GError) local_error = NULL;
+  GSList *results = g_task_propagate_pointer (G_TASK (result), &local_error);
+  UnorderedResultsData *data = g_task_get_task_data (G_TASK (result));
+
+  if (local_error != NULL)
+    {
+      g_propagate_error (error, g_steal_pointer (&local_error));
+      return NULL;
+    }
+
+  if (out_late_providers != NULL)
+    {
+      GPtrArray *late_providers = g_ptr_array_new ();
+      guint i = 0;
+
+      for (; i < data->late_providers->len; ++i)
+        g_ptr_array_add (late_providers,
+                         g_strdup (g_ptr_array_index (data->late_providers, i)));
+
+      g_ptr_array_add (late_providers, NULL);
+      *out_late_providers = (gchar **) g_ptr_array_free (late_providers, FALSE);
+    }
+
+  return results;
+}
+
+static void
+unordered_results_from_queries (GPtrArray                            *ka_proxies,
+                                ContentFeedUnorderedResultsFlags      flags,
+                                gint                                  call_timeout_msec,
+                                gint                                  deadline_msec,
+                                ContentFeedUnorderedResultsBatchFunc  batch_func,
+                                gpointer                              batch_data,
+                                GDestroyNotify                        batch_data_destroy,
+                                GCancellable                         *cancellable,
+                                GAsyncReadyCallback                   callback,
+                                gpointer                              user_data)
+{
+  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
 
   g_task_set_return_on_cancel (task, TRUE);
+  g_task_set_task_data (task,
+                        unordered_results_data_new (batch_func,
+                                                    batch_data,
+                                                    batch_data_destroy,
+                                                    cancellable),
+                        (GDestroyNotify) unordered_results_data_free);
   unordered_card_arrays_from_queries (ka_proxies,
-                                      cancellable,
-                                      received_all_unordered_card_array_results_from_queries,
+                                      flags,
+                                      call_timeout_msec,
+                                      deadline_msec,
                                       task);
 }
 
+/**
+ * content_feed_unordered_results_from_queries_full:
+ * @ka_proxies: (element-type ContentFeedKnowledgeAppProxy): An array of #ContentFeedKnowledgeAppProxy
+ * @flags: #ContentFeedUnorderedResultsFlags controlling how the results are built
+ * @call_timeout_msec: Timeout for each provider's D-Bus call in milliseconds,
+ *                     or -1 for the default D-Bus timeout
+ * @deadline_msec: Time to wait for all providers in milliseconds, or -1
+ *                 to wait for all of them however long they take
+ * @cancellable: A #GCancellable
+ * @callback: Callback function
+ * @user_data: Closure for @callback
+ *
+ * Like content_feed_unordered_results_from_queries(), but with @flags
+ * and timeouts.
+ *
+ * If some providers have not replied once @deadline_msec has passed,
+ * @callback is invoked with the results from the providers which did.
+ * The desktop IDs of the providers which timed out or missed the
+ * deadline can be retrieved with
+ * content_feed_unordered_results_from_queries_full_finish().
+ *
+ * If %CONTENT_FEED_UNORDERED_RESULTS_FLAGS_DEFER_MODELS is set, the
+ * #ContentFeedOrderableModel results for cards backed by shards will not
+ * have a #ContentFeedBaseCardStore yet. They can be passed to
+ * content_feed_arrange_orderable_models() as normal, and then only the
+ * models which survive ordering should be passed to
+ * content_feed_resolve_orderable_models() to load their thumbnails and
+ * sanitize their text.
+ *
+ * Use content_feed_unordered_results_from_queries_full_finish() or
+ * content_feed_unordered_results_from_queries_finish() to complete
+ * the call.
+ */
+void
+content_feed_unordered_results_from_queries_full (GPtrArray                        *ka_proxies,
+                                                  ContentFeedUnorderedResultsFlags  flags,
+                                                  gint                              call_timeout_msec,
+                                                  gint                              deadline_msec,
+                                                  GCancellable                     *cancellable,
+                                                  GAsyncReadyCallback               callback,
+                                                  gpointer                          user_data)
+{
+  unordered_results_from_queries (ka_proxies,
+                                  flags,
+                                  call_timeout_msec,
+                                  deadline_msec,
+                                  NULL,
+                                  NULL,
+                                  NULL,
+                                  cancellable,
+                                  callback,
+                                  user_data);
+}
+
+/**
+ * content_feed_unordered_results_from_queries_streamed:
+ * @ka_proxies: (element-type ContentFeedKnowledgeAppProxy): An array of #ContentFeedKnowledgeAppProxy
+ * @flags: #ContentFeedUnorderedResultsFlags controlling how the results are built
+ * @call_timeout_msec: Timeout for each provider's D-Bus call in milliseconds,
+ *                     or -1 for the default D-Bus timeout
+ * @deadline_msec: Time to wait for all providers in milliseconds, or -1
+ *                 to wait for all of them however long they take
+ * @batch_func: (scope notified) (closure batch_data) (destroy batch_data_destroy):
+ *              Function to call with each provider's models as they arrive
+ * @batch_data: Closure for @batch_func
+ * @batch_data_destroy: (nullable): Function to free @batch_data
+ * @cancellable: A #GCancellable
+ * @callback: Callback function
+ * @user_data: Closure for @callback
+ *
+ * Like content_feed_unordered_results_from_queries_full(), but also pass
+ * the models from each provider to @batch_func as soon as that provider
+ * replies, so that the first cards can be shown without waiting for the
+ * slowest provider.
+ *
+ * @batch_func is called on the thread-default main context of the caller
+ * and is never called with an empty batch. It is not called again once
+ * the query has been cancelled or @callback has been invoked, so results
+ * from providers which missed the deadline are never seen. @callback is
+ * invoked with all of the models which were passed to @batch_func, once
+ * every provider has replied or the deadline has passed. Use
+ * content_feed_unordered_results_from_queries_full_finish() to complete
+ * the call.
+ */
+void
+content_feed_unordered_results_from_queries_streamed (GPtrArray                            *ka_proxies,
+                                                      ContentFeedUnorderedResultsFlags      flags,
+                                                      gint                                  call_timeout_msec,
+                                                      gint                                  deadline_msec,
+                                                      ContentFeedUnorderedResultsBatchFunc  batch_func,
+                                                      gpointer                              batch_data,
+                                                      GDestroyNotify                        batch_data_destroy,
+                                                      GCancellable                         *cancellable,
+                                                      GAsyncReadyCallback                   callback,
+                                                      gpointer                              user_data)
+{
+  g_return_if_fail (batch_func != NULL);
+
+  unordered_results_from_queries (ka_proxies,
+                                  flags,
+                                  call_timeout_msec,
+                                  deadline_msec,
+                                  batch_func,
+                                  batch_data,
+                                  batch_data_destroy,
+                                  cancellable,
+                                  callback,
+                                  user_data);
+}
+
+typedef struct _ContentChangesWatch ContentChangesWatch;
+
+/* The proxies for the card interfaces of one provider, and our
+ * subscriptions to their ContentChanged signals */
+typedef struct _WatchedProvider
+{
+  volatile gint        ref_count;
+
+  /* NULL once the watch has been removed */
+  ContentChangesWatch *watch;
+
+  gchar               *desktop_id;
+  GPtrArray           *ka_proxies;
+  GPtrArray           *connections;
+  GArray              *subscription_ids;
+
+  /* Signals are coalesced before querying again, and only the results
+   * of the latest query are passed on */
+  GSource             *requery_source;
+  guint                generation;
+} WatchedProvider;
+
+struct _ContentChangesWatch
+{
+  ContentFeedUnorderedResultsFlags  flags;
+  gint                              call_timeout_msec;
+  ContentFeedContentChangedFunc     func;
+  gpointer                          user_data;
+  GDestroyNotify                    user_data_destroy;
+  GCancellable                     *cancellable;
+
+  /* The thread-default main context of the caller, where the signals
+   * arrive and the coalescing timeouts run */
+  GMainContext                     *context;
+
+  /* desktop ID to WatchedProvider */
+  GHashTable                       *providers;
+};
+
+/* Providers often change several of their interfaces at once */
+#define CONTENT_CHANGED_COALESCE_MSEC 1000
+
+static WatchedProvider *
+watched_provider_new (ContentChangesWatch *watch,
+                      const gchar         *desktop_id)
+{
+  WatchedProvider *provider = g_new0 (WatchedProvider, 1);
+
+  provider->ref_count = 1;
+  provider->watch = watch;
+  provider->desktop_id = g_strdup (desktop_id);
+  provider->ka_proxies = g_ptr_array_new_with_free_func (g_object_unref);
+  provider->connections = g_ptr_array_new_with_free_func (g_object_unref);
+  provider->subscription_ids = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  return provider;
+}
+
+static WatchedProvider *
+watched_provider_ref (WatchedProvider *provider)
+{
+  g_atomic_int_inc (&provider->ref_count);
+
+  return provider;
+}
+
+static void
+watched_provider_unref (WatchedProvider *provider)
+{
+  if (!g_atomic_int_dec_and_test (&provider->ref_count))
+    return;
+
+  g_clear_pointer (&provider->desktop_id, g_free);
+  g_clear_pointer (&provider->ka_proxies, g_ptr_array_unref);
+  g_clear_pointer (&provider->connections, g_ptr_array_unref);
+  g_clear_pointer (&provider->subscription_ids, g_array_unref);
+
+  g_free (provider);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (WatchedProvider, watched_provider_unref)
+
+/* Stop listening to the provider. Queries for it that are still in
+ * flight are dropped when they complete. */
+static void
+watched_provider_detach (WatchedProvider *provider)
+{
+  guint i = 0;
+
+  provider->watch = NULL;
+
+  for (i = 0; i < provider->subscription_ids->len; ++i)
+    g_dbus_connection_signal_unsubscribe (g_ptr_array_index (provider->connections, i),
+                                          g_array_index (provider->subscription_ids, guint, i));
+
+  g_array_set_size (provider->subscription_ids, 0);
+  g_ptr_array_set_size (provider->connections, 0);
+
+  if (provider->requery_source != NULL)
+    {
+      g_source_destroy (provider->requery_source);
+      g_clear_pointer (&provider->requery_source, g_source_unref);
+    }
+
+  watched_provider_unref (provider);
+}
+
+static void
+content_changes_watch_free (ContentChangesWatch *watch)
+{
+  g_cancellable_cancel (watch->cancellable);
+  g_clear_object (&watch->cancellable);
+  g_clear_pointer (&watch->providers, g_hash_table_unref);
+  g_clear_pointer (&watch->context, g_main_context_unref);
+
+  if (watch->user_data_destroy != NULL)
+    g_clear_pointer (&watch->user_data, watch->user_data_destroy);
+
+  g_free (watch);
+}
+
+/* Watch ID to ContentChangesWatch, only used on the main context that
+ * the watches were added on */
+static GHashTable *content_changes_watches = NULL;
+static guint next_content_changes_watch_id = 1;
+
+typedef struct _RequeryClosure
+{
+  WatchedProvider *provider;
+  guint            generation;
+} RequeryClosure;
+
+static RequeryClosure *
+requery_closure_new (WatchedProvider *provider)
+{
+  RequeryClosure *closure = g_new0 (RequeryClosure, 1);
+
+  closure->provider = watched_provider_ref (provider);
+  closure->generation = provider->generation;
+
+  return closure;
+}
+
+static void
+requery_closure_free (RequeryClosure *closure)
+{
+  g_clear_pointer (&closure->provider, watched_provider_unref);
+
+  g_free (closure);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (RequeryClosure, requery_closure_free)
+
+static void
+received_changed_provider_results (GObject      *source G_GNUC_UNUSED,
+                                   GAsyncResult *result,
+                                   gpointer      user_data)
+{
+  g_autoptr(RequeryClosure) closure = user_data;
+  WatchedProvider *provider = closure->provider;
+  UnorderedResultsData *data = g_task_get_task_data (G_TASK (result));
+  g_autoptr(GError) local_error = NULL;
+  GSList *models = g_task_propagate_pointer (G_TASK (result), &local_error);
+
+  if (local_error != NULL)
+    {
+      if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_message ("Could not query %s again after it changed: %s",
+                   provider->desktop_id,
+                   local_error->message);
+      return;
+    }
+
+  /* Either the watch went away, or the provider changed again and a
+   * newer query is on its way */
+  if (provider->watch == NULL || closure->generation != provider->generation)
+    {
+      object_slist_free (models);
+      return;
+    }
+
+  /* Passing on a partial or empty result would make the caller drop
+   * cards that the provider still has, so keep the old ones */
+  if (data->slot_sources->len == 0 || data->n_failed_slots > 0)
+    {
+      g_message ("Not updating the cards for %s, it could not be queried",
+                 provider->desktop_id);
+      object_slist_free (models);
+      return;
+    }
+
+  provider->watch->func (provider->desktop_id, models, provider->watch->user_data);
+  object_slist_free (models);
+}
+
+static gboolean
+requery_changed_provider (gpointer user_data)
+{
+  WatchedProvider *provider = user_data;
+  ContentChangesWatch *watch = provider->watch;
+
+  g_clear_pointer (&provider->requery_source, g_source_unref);
+  ++provider->generation;
+
+  unordered_results_from_queries (provider->ka_proxies,
+                                  watch->flags,
+                                  watch->call_timeout_msec,
+                                  -1,
+                                  NULL,
+                                  NULL,
+                                  NULL,
+                                  watch->cancellable,
+                                  received_changed_provider_results,
+                                  requery_closure_new (provider));
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+is_content_changes_interface (const InterfaceRegistryEntry *registry_entry)
+{
+  switch (registry_entry->marshaller)
+    {
+    case INTERFACE_MARSHALLER_ARTICLE:
+    case INTERFACE_MARSHALLER_VIDEO:
+    case INTERFACE_MARSHALLER_ARTWORK:
+    case INTERFACE_MARSHALLER_BULK:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static void
+on_provider_content_changed (GDBusConnection *connection G_GNUC_UNUSED,
+                             const gchar     *sender_name G_GNUC_UNUSED,
+                             const gchar     *object_path G_GNUC_UNUSED,
+                             const gchar     *interface_name,
+                             const gchar     *signal_name G_GNUC_UNUSED,
+                             GVariant        *parameters G_GNUC_UNUSED,
+                             gpointer         user_data)
+{
+  WatchedProvider *provider = user_data;
+  const InterfaceRegistryEntry *registry_entry = interface_registry_lookup (interface_name);
+
+  if (provider->watch == NULL ||
+      registry_entry == NULL ||
+      !is_content_changes_interface (registry_entry))
+    return;
+
+  if (provider->requery_source != NULL)
+    return;
+
+  provider->requery_source = g_timeout_source_new (CONTENT_CHANGED_COALESCE_MSEC);
+  g_source_set_callback (provider->requery_source,
+                         requery_changed_provider,
+                         provider,
+                         NULL);
+  g_source_attach (provider->requery_source, provider->watch->context);
+}
+
+/**
+ * content_feed_watch_content_changes:
+ * @ka_proxies: (element-type ContentFeedKnowledgeAppProxy): An array of #ContentFeedKnowledgeAppProxy
+ * @flags: #ContentFeedUnorderedResultsFlags controlling how the results are built
+ * @call_timeout_msec: Timeout for each provider's D-Bus call in milliseconds,
+ *                     or -1 for the default D-Bus timeout
+ * @func: (scope notified) (closure user_data) (destroy user_data_destroy):
+ *        Function to call with the new models of a provider
+ * @user_data: Closure for @func
+ * @user_data_destroy: (nullable): Function to free @user_data
+ *
+ * Listen for the ContentChanged signal from each of the providers in
+ * @ka_proxies. When a provider emits it, only the card interfaces of
+ * that provider are queried again, and its new models are passed to
+ * @func, so that they can be merged into the existing results with
+ * content_feed_merge_orderable_models(). Signals that arrive close
+ * together are coalesced into a single query.
+ *
+ * If the provider cannot be queried, @func is not called, so its
+ * existing cards are kept. Word and quote cards are paired from
+ * different providers, so they are only updated by a full refresh.
+ *
+ * @func is called on the thread-default main context of the caller,
+ * which must also be where the watch is removed.
+ *
+ * Returns: An ID to pass to content_feed_unwatch_content_changes()
+ */
+guint
+content_feed_watch_content_changes (GPtrArray                        *ka_proxies,
+                                    ContentFeedUnorderedResultsFlags  flags,
+                                    gint                              call_timeout_msec,
+                                    ContentFeedContentChangedFunc     func,
+                                    gpointer                          user_data,
+                                    GDestroyNotify                    user_data_destroy)
+{
+  ContentChangesWatch *watch = NULL;
+  g_autoptr(GHashTable) subscribed_objects = g_hash_table_new_full (g_str_hash,
+                                                                    g_str_equal,
+                                                                    g_free,
+                                                                    NULL);
+  guint watch_id = 0;
+  guint i = 0;
+
+  g_return_val_if_fail (func != NULL, 0);
+
+  watch = g_new0 (ContentChangesWatch, 1);
+  watch->flags = flags;
+  watch->call_timeout_msec = call_timeout_msec;
+  watch->func = func;
+  watch->user_data = user_data;
+  watch->user_data_destroy = user_data_destroy;
+  watch->cancellable = g_cancellable_new ();
+  watch->context = g_main_context_ref_thread_default ();
+  watch->providers = g_hash_table_new_full (g_str_hash,
+                                            g_str_equal,
+                                            NULL,
+                                            (GDestroyNotify) watched_provider_detach);
+
+  for (i = 0; i < ka_proxies->len; ++i)
+    {
+      ContentFeedKnowledgeAppProxy *ka_proxy = g_ptr_array_index (ka_proxies, i);
+      GDBusProxy *dbus_proxy = content_feed_knowledge_app_proxy_get_dbus_proxy (ka_proxy);
+      const InterfaceRegistryEntry *registry_entry = interface_registry_lookup_for_proxy (dbus_proxy);
+      const gchar *desktop_id = content_feed_knowledge_app_proxy_get_desktop_id (ka_proxy);
+      g_autofree gchar *object_key = NULL;
+      WatchedProvider *provider = NULL;
+      GDBusConnection *connection = NULL;
+      guint subscription_id = 0;
+
+      if (registry_entry == NULL || !is_content_changes_interface (registry_entry))
+        continue;
+
+      provider = g_hash_table_lookup (watch->providers, desktop_id);
+
+      if (provider == NULL)
+        {
+          provider = watched_provider_new (watch, desktop_id);
+          g_hash_table_insert (watch->providers, provider->desktop_id, provider);
+        }
+
+      g_ptr_array_add (provider->ka_proxies, g_object_ref (ka_proxy));
+
+      /* All of the interfaces of a provider share its object, so one
+       * subscription covers them all */
+      object_key = provider_object_key (dbus_proxy);
+
+      if (g_hash_table_contains (subscribed_objects, object_key))
+        continue;
+
+      connection = g_dbus_proxy_get_connection (dbus_proxy);
+      subscription_id = g_dbus_connection_signal_subscribe (connection,
+                                                            g_dbus_proxy_get_name (dbus_proxy),
+                                                            NULL,
+                                                            "ContentChanged",
+                                                            g_dbus_proxy_get_object_path (dbus_proxy),
+                                                            NULL,
+                                                            G_DBUS_SIGNAL_FLAGS_NONE,
+                                                            on_provider_content_changed,
+                                                            watched_provider_ref (provider),
+                                                            (GDestroyNotify) watched_provider_unref);
+
+      g_ptr_array_add (provider->connections, g_object_ref (connection));
+      g_array_append_val (provider->subscription_ids, subscription_id);
+      g_hash_table_add (subscribed_objects, g_steal_pointer (&object_key));
+    }
+
+  if (content_changes_watches == NULL)
+    content_changes_watches = g_hash_table_new_full (g_direct_hash,
+                                                     g_direct_equal,
+                                                     NULL,
+                                                     (GDestroyNotify) content_changes_watch_free);
+
+  watch_id = next_content_changes_watch_id++;
+  g_hash_table_insert (content_changes_watches, GUINT_TO_POINTER (watch_id), watch);
+
+  return watch_id;
+}
+
+/**
+ * content_feed_unwatch_content_changes:
+ * @watch_id: An ID returned by content_feed_watch_content_changes()
+ *
+ * Stop listening for content changes. Queries that are still in flight
+ * are cancelled, and the function passed to
+ * content_feed_watch_content_changes() is not called again.
+ */
+void
+content_feed_unwatch_content_changes (guint watch_id)
+{
+  g_return_if_fail (watch_id != 0);
+
+  if (content_changes_watches == NULL ||
+      !g_hash_table_remove (content_changes_watches, GUINT_TO_POINTER (watch_id)))
+    g_warning ("No content changes watch with ID %u", watch_id);
+}
+
+/**
+ * content_feed_merge_orderable_models:
+ * @orderable_models: (element-type ContentFeedOrderableModel) (transfer none):
+ *                    The existing models
+ * @desktop_id: The desktop ID of the provider whose content changed
+ * @updated_models: (element-type ContentFeedOrderableModel) (transfer none):
+ *                  The new models from that provider
+ *
+ * Replace the models from @desktop_id in @orderable_models with
+ * @updated_models, as passed to a #ContentFeedContentChangedFunc. Word
+ * and quote cards are kept, since they are not updated on content
+ * changes. The result should be passed to
+ * content_feed_arrange_orderable_models() again.
+ *
+ * Returns: (transfer full) (element-type ContentFeedOrderableModel):
+ *          A new #GSList with the merged models
+ */
+GSList *
+content_feed_merge_orderable_models (GSList      *orderable_models,
+                                     const gchar *desktop_id,
+                                     GSList      *updated_models)
+{
+  GSList *merged = NULL;
+  GSList *iter = NULL;
+
+  g_return_val_if_fail (desktop_id != NULL, NULL);
+
+  for (iter = orderable_models; iter != NULL; iter = iter->next)
+    {
+      ContentFeedOrderableModel *model = iter->data;
+
+      if (g_strcmp0 (content_feed_orderable_model_get_source (model), desktop_id) == 0 &&
+          content_feed_orderable_model_get_card_store_type (model) != CONTENT_FEED_CARD_STORE_TYPE_WORD_QUOTE_CARD)
+        continue;
+
+      merged = g_slist_prepend (merged, g_object_ref (model));
+    }
+
+  for (iter = updated_models; iter != NULL; iter = iter->next)
+    merged = g_slist_prepend (merged, g_object_ref (iter->data));
+
+  return g_slist_reverse (merged);
+}
+
+static void
+resolve_orderable_models_thread (GTask        *task,
+                                 gpointer      source G_GNUC_UNUSED,
+                                 gpointer      task_data,
+                                 GCancellable *cancellable)
+{
+  GPtrArray *orderable_models = task_data;
+  g_autoptr(GPtrArray) resolved_models = g_ptr_array_new_full (orderable_models->len,
+                                                               g_object_unref);
+  guint i = 0;
+
+  for (; i < orderable_models->len; ++i)
+    {
+      ContentFeedOrderableModel *orderable_model = g_ptr_array_index (orderable_models, i);
+
+      if (g_task_return_error_if_cancelled (task))
+        return;
+
+      if (!orderable_model_resolve (orderable_model))
+        {
+          g_message ("Could not build card from %s (ignoring)",
+                     content_feed_orderable_model_get_source (orderable_model));
+          continue;
+        }
+
+      g_ptr_array_add (resolved_models, g_object_ref (orderable_model));
+    }
+
+  g_task_return_pointer (task,
+                         g_steal_pointer (&resolved_models),
+                         (GDestroyNotify) g_ptr_array_unref);
+}
+
+/**
+ * content_feed_resolve_orderable_models_finish:
+ * @result: A #GAsyncResult
+ * @error: A #GError
+ *
+ * Complete a call to content_feed_resolve_orderable_models().
+ *
+ * Returns: (transfer container) (element-type ContentFeedOrderableModel): The
+ *          models which could be resolved, in the same order that they were
+ *          passed in, or %NULL with @error set.
+ */
+GPtrArray *
+content_feed_resolve_orderable_models_finish (GAsyncResult  *result,
+                                              GError       **error)
+{
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * content_feed_resolve_orderable_models:
+ * @orderable_models: (element-type ContentFeedOrderableModel): The models to resolve
+ * @cancellable: A #GCancellable
+ * @callback: Callback function
+ * @user_data: Closure for @callback
+ *
+ * Build the #ContentFeedBaseCardStore for each model in @orderable_models
+ * which was returned by content_feed_unordered_results_from_queries_full()
+ * with %CONTENT_FEED_UNORDERED_RESULTS_FLAGS_DEFER_MODELS. Models which
+ * already have a #ContentFeedBaseCardStore are passed through unchanged.
+ *
+ * This loads thumbnails and sanitizes text, so it runs on a worker thread.
+ * The models must not be used until @callback has been called, even if
+ * @cancellable is cancelled. Models
+ * which could not be built are logged and left out of the result. Use
+ * content_feed_resolve_orderable_models_finish() to complete the call.
+ */
+void
+content_feed_resolve_orderable_models (GPtrArray           *orderable_models,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, user_data);
+
+  /* Not returning on cancel, since the worker is still writing to the
+   * models until it returns. It checks for cancellation between
+   * models, so it is not held up for long. */
+  g_task_set_task_data (task,
+                        g_ptr_array_ref (orderable_models),
+                        (GDestroyNotify) g_ptr_array_unref);
+  g_task_run_in_thread (task, resolve_orderable_models_thread);
+}
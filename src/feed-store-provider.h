@@ -21,6 +21,37 @@
 
 G_BEGIN_DECLS
 
+typedef enum _ContentFeedUnorderedResultsFlags {
+  CONTENT_FEED_UNORDERED_RESULTS_FLAGS_DEFER_MODELS = (1 << 0)
+} ContentFeedUnorderedResultsFlags;
+
+/**
+ * ContentFeedUnorderedResultsBatchFunc:
+ * @orderable_models: (element-type ContentFeedOrderableModel) (transfer none):
+ *                    The models from a single provider
+ * @user_data: The data passed with this function
+ *
+ * Called by content_feed_unordered_results_from_queries_streamed() each
+ * time a provider replies.
+ */
+typedef void (*ContentFeedUnorderedResultsBatchFunc) (GSList   *orderable_models,
+                                                      gpointer  user_data);
+
+/**
+ * ContentFeedContentChangedFunc:
+ * @desktop_id: The desktop ID of the provider whose content changed
+ * @orderable_models: (element-type ContentFeedOrderableModel) (transfer none):
+ *                    The new models from that provider
+ * @user_data: The data passed with this function
+ *
+ * Called by a watch added with content_feed_watch_content_changes()
+ * each time a provider has been queried again after its content
+ * changed.
+ */
+typedef void (*ContentFeedContentChangedFunc) (const gchar *desktop_id,
+                                               GSList      *orderable_models,
+                                               gpointer     user_data);
+
 GSList * content_feed_unordered_results_from_queries_finish (GAsyncResult  *result,
                                                              GError       **error);
 
@@ -30,4 +61,48 @@ void content_feed_unordered_results_from_queries (GPtrArray           *ka_proxie
                                                   GAsyncReadyCallback  callback,
                                                   gpointer             user_data);
 
+GSList * content_feed_unordered_results_from_queries_full_finish (GAsyncResult   *result,
+                                                                  gchar        ***out_late_providers,
+                                                                  GError        **error);
+
+void content_feed_unordered_results_from_queries_full (GPtrArray                        *ka_proxies,
+                                                       ContentFeedUnorderedResultsFlags  flags,
+                                                       gint                              call_timeout_msec,
+                                                       gint                              deadline_msec,
+                                                       GCancellable                     *cancellable,
+                                                       GAsyncReadyCallback               callback,
+                                                       gpointer                          user_data);
+
+void content_feed_unordered_results_from_queries_streamed (GPtrArray                            *ka_proxies,
+                                                           ContentFeedUnorderedResultsFlags      flags,
+                                                           gint                                  call_timeout_msec,
+                                                           gint                                  deadline_msec,
+                                                           ContentFeedUnorderedResultsBatchFunc  batch_func,
+                                                           gpointer                              batch_data,
+                                                           GDestroyNotify                        batch_data_destroy,
+                                                           GCancellable                         *cancellable,
+                                                           GAsyncReadyCallback                   callback,
+                                                           gpointer                              user_data);
+
+guint content_feed_watch_content_changes (GPtrArray                        *ka_proxies,
+                                          ContentFeedUnorderedResultsFlags  flags,
+                                          gint                              call_timeout_msec,
+                                          ContentFeedContentChangedFunc     func,
+                                          gpointer                          user_data,
+                                          GDestroyNotify                    user_data_destroy);
+
+void content_feed_unwatch_content_changes (guint watch_id);
+
+GSList * content_feed_merge_orderable_models (GSList      *orderable_models,
+                                             const gchar *desktop_id,
+                                             GSList      *updated_models);
+
+GPtrArray * content_feed_resolve_orderable_models_finish (GAsyncResult  *result,
+                                                          GError       **error);
+
+void content_feed_resolve_orderable_models (GPtrArray           *orderable_models,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data);
+
 G_END_DECLS
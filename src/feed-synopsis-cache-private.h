@@ -0,0 +1,48 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:synopsis-cache
+ * @title: Synopsis Cache
+ * @short_description: Persistent cache of sanitized synopses
+ *
+ * The same articles come back from providers refresh after refresh, so
+ * sanitized synopses are kept in a cache file, keyed by the ekn_id of
+ * the article. Each entry also records a hash of the synopsis that was
+ * sanitized, so that an article whose synopsis changed is sanitized
+ * again rather than served stale.
+ *
+ * The cache holds a bounded number of entries. When it is full, the
+ * ones that were least recently used are dropped. Changes are written
+ * back a few seconds after the last one, on a worker thread.
+ *
+ * The cache is safe to use from multiple threads.
+ */
+gchar * synopsis_cache_lookup (const gchar *ekn_id,
+                               const gchar *synopsis);
+
+void synopsis_cache_insert (const gchar *ekn_id,
+                            const gchar *synopsis,
+                            const gchar *sanitized);
+
+G_END_DECLS
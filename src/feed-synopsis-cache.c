@@ -0,0 +1,324 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gio/gio.h>
+
+#include "feed-cache-file-private.h"
+#include "feed-synopsis-cache-private.h"
+
+/* Bump the version if sanitization changes, so that synopses which
+ * were sanitized the old way are not used */
+#define SYNOPSIS_CACHE_NAME "synopses-v1.gvariant"
+
+/* (ekn_id, synopsis hash, last used, sanitized synopsis), sorted by
+ * ekn_id so that it can be binary-searched straight from the file */
+#define SYNOPSIS_CACHE_TYPE "a(stts)"
+
+#define SYNOPSIS_CACHE_MAX_ENTRIES 4096
+
+/* Entries are only marked as used again after this long, so that
+ * refreshing the same content does not rewrite the cache every time */
+#define SYNOPSIS_CACHE_TOUCH_INTERVAL_SECONDS (60 * 60)
+
+#define SYNOPSIS_CACHE_SAVE_DELAY_SECONDS 5
+
+typedef struct _SynopsisCacheEntry
+{
+  gchar   *ekn_id;
+  guint64  hash;
+  guint64  last_used;
+  gchar   *sanitized;
+} SynopsisCacheEntry;
+
+static SynopsisCacheEntry *
+synopsis_cache_entry_new (const gchar *ekn_id,
+                          guint64      hash,
+                          guint64      last_used,
+                          const gchar *sanitized)
+{
+  SynopsisCacheEntry *entry = g_new0 (SynopsisCacheEntry, 1);
+
+  entry->ekn_id = g_strdup (ekn_id);
+  entry->hash = hash;
+  entry->last_used = last_used;
+  entry->sanitized = g_strdup (sanitized);
+
+  return entry;
+}
+
+static void
+synopsis_cache_entry_free (SynopsisCacheEntry *entry)
+{
+  g_clear_pointer (&entry->ekn_id, g_free);
+  g_clear_pointer (&entry->sanitized, g_free);
+
+  g_free (entry);
+}
+
+/* Protects everything below */
+static GMutex synopsis_cache_lock;
+static gboolean synopsis_cache_loaded = FALSE;
+
+/* What was last loaded or saved */
+static GVariant *synopsis_cache_saved = NULL;
+
+/* Entries added or used since then, by ekn_id. These take precedence
+ * over synopsis_cache_saved. */
+static GHashTable *synopsis_cache_changes = NULL;
+
+/* 64-bit FNV-1a */
+static guint64
+hash_synopsis (const gchar *synopsis)
+{
+  guint64 hash = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+  const guchar *p = (const guchar *) synopsis;
+
+  for (; *p != '\0'; ++p)
+    {
+      hash ^= *p;
+      hash *= G_GUINT64_CONSTANT (0x100000001b3);
+    }
+
+  return hash;
+}
+
+static guint64
+now_seconds (void)
+{
+  return g_get_real_time () / G_USEC_PER_SEC;
+}
+
+static void
+ensure_synopsis_cache_loaded (void)
+{
+  if (synopsis_cache_loaded)
+    return;
+
+  synopsis_cache_loaded = TRUE;
+  synopsis_cache_saved = cache_file_load_variant (SYNOPSIS_CACHE_NAME,
+                                                  G_VARIANT_TYPE (SYNOPSIS_CACHE_TYPE));
+  synopsis_cache_changes = g_hash_table_new_full (g_str_hash,
+                                                  g_str_equal,
+                                                  NULL,
+                                                  (GDestroyNotify) synopsis_cache_entry_free);
+}
+
+/* Returns the (stts) child of synopsis_cache_saved for @ekn_id, if any */
+static GVariant *
+find_saved_entry (const gchar *ekn_id)
+{
+  gsize low = 0;
+  gsize high = 0;
+
+  if (synopsis_cache_saved == NULL)
+    return NULL;
+
+  high = g_variant_n_children (synopsis_cache_saved);
+
+  while (low < high)
+    {
+      gsize mid = low + (high - low) / 2;
+      g_autoptr(GVariant) child = g_variant_get_child_value (synopsis_cache_saved, mid);
+      const gchar *child_ekn_id = NULL;
+      gint cmp = 0;
+
+      g_variant_get_child (child, 0, "&s", &child_ekn_id);
+      cmp = strcmp (ekn_id, child_ekn_id);
+
+      if (cmp == 0)
+        return g_steal_pointer (&child);
+      else if (cmp < 0)
+        high = mid;
+      else
+        low = mid + 1;
+    }
+
+  return NULL;
+}
+
+static gint
+compare_entries_by_last_used_descending (gconstpointer a,
+                                         gconstpointer b)
+{
+  const SynopsisCacheEntry *entry_a = *(const SynopsisCacheEntry **) a;
+  const SynopsisCacheEntry *entry_b = *(const SynopsisCacheEntry **) b;
+
+  if (entry_a->last_used == entry_b->last_used)
+    return 0;
+
+  return entry_a->last_used > entry_b->last_used ? -1 : 1;
+}
+
+static gint
+compare_entries_by_ekn_id (gconstpointer a,
+                           gconstpointer b)
+{
+  const SynopsisCacheEntry *entry_a = *(const SynopsisCacheEntry **) a;
+  const SynopsisCacheEntry *entry_b = *(const SynopsisCacheEntry **) b;
+
+  return strcmp (entry_a->ekn_id, entry_b->ekn_id);
+}
+
+/* Merge the changes into what was saved, dropping the least recently
+ * used entries if there are too many, and make that the saved state.
+ * Must be called with synopsis_cache_lock held. */
+static GVariant *
+synopsis_cache_merge_changes (void)
+{
+  g_autoptr(GPtrArray) entries = g_ptr_array_new_with_free_func ((GDestroyNotify) synopsis_cache_entry_free);
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer value = NULL;
+  guint i = 0;
+
+  if (synopsis_cache_saved != NULL)
+    {
+      GVariantIter saved_iter;
+      const gchar *ekn_id = NULL;
+      guint64 hash = 0;
+      guint64 last_used = 0;
+      const gchar *sanitized = NULL;
+
+      g_variant_iter_init (&saved_iter, synopsis_cache_saved);
+      while (g_variant_iter_next (&saved_iter, "(&stt&s)", &ekn_id, &hash, &last_used, &sanitized))
+        {
+          if (g_hash_table_contains (synopsis_cache_changes, ekn_id))
+            continue;
+
+          g_ptr_array_add (entries,
+                           synopsis_cache_entry_new (ekn_id, hash, last_used, sanitized));
+        }
+    }
+
+  g_hash_table_iter_init (&iter, synopsis_cache_changes);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      g_hash_table_iter_steal (&iter);
+      g_ptr_array_add (entries, value);
+    }
+
+  if (entries->len > SYNOPSIS_CACHE_MAX_ENTRIES)
+    {
+      g_ptr_array_sort (entries, compare_entries_by_last_used_descending);
+      g_ptr_array_set_size (entries, SYNOPSIS_CACHE_MAX_ENTRIES);
+    }
+
+  g_ptr_array_sort (entries, compare_entries_by_ekn_id);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (SYNOPSIS_CACHE_TYPE));
+
+  for (i = 0; i < entries->len; ++i)
+    {
+      SynopsisCacheEntry *entry = g_ptr_array_index (entries, i);
+
+      /* The ekn_ids are keys, the last one wins if the file had any
+       * duplicates in it */
+      if (i + 1 < entries->len &&
+          strcmp (entry->ekn_id,
+                  ((SynopsisCacheEntry *) g_ptr_array_index (entries, i + 1))->ekn_id) == 0)
+        continue;
+
+      g_variant_builder_add (&builder,
+                             "(stts)",
+                             entry->ekn_id,
+                             entry->hash,
+                             entry->last_used,
+                             entry->sanitized);
+    }
+
+  g_clear_pointer (&synopsis_cache_saved, g_variant_unref);
+  synopsis_cache_saved = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+  return g_variant_ref (synopsis_cache_saved);
+}
+
+static GVariant *
+snapshot_synopsis_cache (void)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&synopsis_cache_lock);
+
+  return synopsis_cache_merge_changes ();
+}
+
+static CacheFileSaver synopsis_cache_saver = CACHE_FILE_SAVER_INIT (SYNOPSIS_CACHE_NAME,
+                                                                    snapshot_synopsis_cache,
+                                                                    SYNOPSIS_CACHE_SAVE_DELAY_SECONDS);
+
+gchar *
+synopsis_cache_lookup (const gchar *ekn_id,
+                       const gchar *synopsis)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&synopsis_cache_lock);
+  guint64 hash = hash_synopsis (synopsis);
+  guint64 now = now_seconds ();
+  SynopsisCacheEntry *entry = NULL;
+  g_autoptr(GVariant) saved_entry = NULL;
+  guint64 saved_hash = 0;
+  guint64 saved_last_used = 0;
+  const gchar *saved_sanitized = NULL;
+
+  ensure_synopsis_cache_loaded ();
+
+  entry = g_hash_table_lookup (synopsis_cache_changes, ekn_id);
+
+  if (entry != NULL)
+    return entry->hash == hash ? g_strdup (entry->sanitized) : NULL;
+
+  saved_entry = find_saved_entry (ekn_id);
+
+  if (saved_entry == NULL)
+    return NULL;
+
+  g_variant_get (saved_entry,
+                 "(&stt&s)",
+                 NULL,
+                 &saved_hash,
+                 &saved_last_used,
+                 &saved_sanitized);
+
+  if (saved_hash != hash)
+    return NULL;
+
+  if (now - saved_last_used > SYNOPSIS_CACHE_TOUCH_INTERVAL_SECONDS)
+    {
+      entry = synopsis_cache_entry_new (ekn_id, hash, now, saved_sanitized);
+      g_hash_table_replace (synopsis_cache_changes, entry->ekn_id, entry);
+      cache_file_saver_schedule (&synopsis_cache_saver);
+    }
+
+  return g_strdup (saved_sanitized);
+}
+
+void
+synopsis_cache_insert (const gchar *ekn_id,
+                       const gchar *synopsis,
+                       const gchar *sanitized)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&synopsis_cache_lock);
+  SynopsisCacheEntry *entry = synopsis_cache_entry_new (ekn_id,
+                                                        hash_synopsis (synopsis),
+                                                        now_seconds (),
+                                                        sanitized);
+
+  ensure_synopsis_cache_loaded ();
+
+  g_hash_table_replace (synopsis_cache_changes, entry->ekn_id, entry);
+  cache_file_saver_schedule (&synopsis_cache_saver);
+}
@@ -28,122 +28,503 @@
  * sentence, see below. */
 #define CHARACTER_COUNT_THRESHOLD 160
 
-static gchar *
-regex_replace (const gchar *exp, const gchar *str, const gchar *replacement)
+/* Starting a thread costs about as much as sanitizing a few dozen
+ * synopses, so don't split a batch up any finer than this */
+#define MIN_SYNOPSES_PER_WORKER 32
+
+/* The sanitizer used to be a pipeline of GRegex replacements:
+ *
+ *  1. Strip leading and trailing ASCII whitespace.
+ *  2. Remove citations, matching \[\d+\].
+ *  3. Remove parenthesized text, matching \(.*?\).
+ *  4. Split into sentences on '.' and keep the first ones under
+ *     CHARACTER_COUNT_THRESHOLD.
+ *  5. Replace whitespace, matching \s+, with a single space.
+ *  6. Add a period at the end.
+ *
+ * That is now done in a single pass over the input into a single output
+ * buffer, but the output must stay exactly the same. Since at most
+ * CHARACTER_COUNT_THRESHOLD characters are kept, the scan stops as soon
+ * as the sentence it is in can no longer be taken, so long synopses
+ * cost no more than short ones. The helpers below
+ * reproduce the meaning that \d, \s and . had in those expressions.
+ * GRegex compiles with Unicode properties, and treats any of the
+ * Unicode line endings as a newline. */
+
+/* What \d matches: any decimal digit */
+static gboolean
+is_regex_digit (gunichar c)
 {
-  g_autoptr(GError) error = NULL;
-  g_autoptr(GRegex) regex = g_regex_new (exp, 0, 0, &error);
-  g_autofree gchar *replaced = NULL;
+  return g_unichar_isdigit (c);
+}
+
+/* What \s matches: separators, plus horizontal and vertical space */
+static gboolean
+is_regex_space (gunichar c)
+{
+  if ((c >= 0x09 && c <= 0x0d) || c == 0x85 || c == 0x180e)
+    return TRUE;
 
-  if (regex == NULL)
+  switch (g_unichar_type (c))
     {
-      g_error ("Fatal error in compiling regular expression: %s", error->message);
-      return NULL;
+    case G_UNICODE_SPACE_SEPARATOR:
+    case G_UNICODE_LINE_SEPARATOR:
+    case G_UNICODE_PARAGRAPH_SEPARATOR:
+      return TRUE;
+    default:
+      return FALSE;
     }
+}
 
-  replaced = g_regex_replace (regex, str, -1, 0, replacement, 0, &error);
+/* What . does not match */
+static gboolean
+is_regex_newline (gunichar c)
+{
+  return (c >= 0x0a && c <= 0x0d) || c == 0x85 || c == 0x2028 || c == 0x2029;
+}
+
+/* Decode the character at @p and point @out_next after it. Bytes that
+ * are not valid UTF-8 are passed through one at a time as a character
+ * which none of the above match. */
+static gunichar
+next_char (const gchar  *p,
+           const gchar **out_next)
+{
+  gunichar c;
 
-  if (replaced == NULL)
+  if ((guchar) *p < 0x80)
     {
-      g_error ("Fatal error in performing string replacement: %s", error->message);
-      return NULL;
+      *out_next = p + 1;
+      return (guchar) *p;
     }
 
-  return g_steal_pointer (&replaced);
-}
+  c = g_utf8_get_char_validated (p, -1);
 
-static gchar *
-remove_square_brackets (const gchar *str)
-{
-  return regex_replace ("\\[\\d+\\]", str, "");
+  if (c == (gunichar) -1 || c == (gunichar) -2)
+    {
+      *out_next = p + 1;
+      return 0xfffd;
+    }
+
+  *out_next = g_utf8_next_char (p);
+  return c;
 }
 
-static gchar *
-remove_parens (const gchar *str)
+/* If there is a match for \[\d+\] at @p, return the end of it */
+static const gchar *
+match_square_brackets (const gchar *p)
 {
-  return regex_replace ("\\(.*?\\)", str, "");
+  const gchar *iter = p + 1;
+  const gchar *next = NULL;
+  gboolean have_digits = FALSE;
+
+  while (*iter != '\0' && is_regex_digit (next_char (iter, &next)))
+    {
+      have_digits = TRUE;
+      iter = next;
+    }
+
+  if (have_digits && *iter == ']')
+    return iter + 1;
+
+  return NULL;
 }
 
-static gchar *
-trim_to_first_n_sentences_under_threshold (const gchar *str,
-                                           guint        character_threshold)
+/* If there is a match for \(.*?\) at @p, return the end of it.
+ *
+ * Otherwise, return %NULL and point @out_unmatched_until at the newline
+ * or end of input that stopped the search. Any other ( before that
+ * point would be stopped by the same thing, so there is no need to
+ * search again from there. */
+static const gchar *
+match_parens (const gchar  *p,
+              const gchar **out_unmatched_until)
 {
-  g_autoptr(GPtrArray) sentences = g_ptr_array_new ();
-  g_auto(GStrv) all_sentences = g_strsplit (str, ".", -1);
-  GStrv iter = all_sentences;
-  guint character_count = 0;
+  const gchar *iter = p + 1;
+  const gchar *next = NULL;
 
-  for (; *iter != NULL; ++iter)
+  while (*iter != '\0')
     {
-      gsize sentence_length = strlen (*iter);
-      gsize sentence_length_with_period = sentence_length + 1;
+      if (*iter == ')')
+        return iter + 1;
 
-      if (sentence_length == 0)
-        continue;
-
-      /* Even if the sentence would be longer than the character threshold
-       * we should always take it. We'll ellipsize it later at a word boundary. */
-      if ((character_count + sentence_length_with_period) > character_threshold &&
-          sentences->len > 0)
+      if (is_regex_newline (next_char (iter, &next)))
         break;
 
-      g_ptr_array_add (sentences, *iter);
-      character_count += sentence_length_with_period;
+      iter = next;
     }
 
-  /* Null-terminate */
-  g_ptr_array_add (sentences, NULL);
-  return g_strjoinv (".", (GStrv) sentences->pdata);
+  *out_unmatched_until = iter;
+  return NULL;
 }
 
-static gchar *
-normalize_whitespace (const gchar *str)
+typedef struct _SynopsisWriter
 {
-  return regex_replace ("\\s+", str, " ");
+  GString  *out;
+  gsize     out_start;
+  guint     character_threshold;
+
+  /* Length of the sentences taken so far, including their periods */
+  gsize     character_count;
+  guint     n_sentences;
+
+  /* Length of the current sentence before whitespace is normalized,
+   * which is what the threshold applies to */
+  gsize     sentence_length;
+  gsize     sentence_start;
+  gboolean  in_space_run;
+} SynopsisWriter;
+
+/* Appends to @out, which may already hold other synopses */
+static void
+synopsis_writer_init (SynopsisWriter *writer,
+                      GString        *out,
+                      guint           character_threshold)
+{
+  writer->out = out;
+  writer->out_start = out->len;
+  writer->character_threshold = character_threshold;
+  writer->character_count = 0;
+  writer->n_sentences = 0;
+  writer->sentence_length = 0;
+  writer->sentence_start = 0;
+  writer->in_space_run = FALSE;
 }
 
-static gchar *
-strip (const gchar *str)
+/* Returns %FALSE if the current sentence has become too long to take,
+ * in which case it is dropped and nothing more should be appended */
+static gboolean
+synopsis_writer_append (SynopsisWriter *writer,
+                        const gchar    *str,
+                        gsize           len,
+                        gboolean        is_space)
 {
-  gchar *copy = g_strdup (str);
-  g_strstrip (copy);
-  return copy;
+  /* Sentences are joined with a period, but empty ones are skipped,
+   * so only write the period once we know this one is not empty */
+  if (writer->sentence_length == 0)
+    {
+      writer->sentence_start = writer->out->len;
+      writer->in_space_run = FALSE;
+
+      if (writer->n_sentences > 0)
+        g_string_append_c (writer->out, '.');
+    }
+
+  writer->sentence_length += len;
+
+  /* Even if the sentence would be longer than the character threshold
+   * we should always take it. We'll ellipsize it later at a word boundary. */
+  if ((writer->character_count + writer->sentence_length + 1) > writer->character_threshold &&
+      writer->n_sentences > 0)
+    {
+      g_string_truncate (writer->out, writer->sentence_start);
+      return FALSE;
+    }
+
+  if (!is_space)
+    {
+      g_string_append_len (writer->out, str, len);
+      writer->in_space_run = FALSE;
+    }
+  else if (!writer->in_space_run)
+    {
+      g_string_append_c (writer->out, ' ');
+      writer->in_space_run = TRUE;
+    }
+
+  return TRUE;
 }
 
-static gchar *
-add_ending_period (const gchar *str)
+static void
+synopsis_writer_end_sentence (SynopsisWriter *writer)
 {
-  guint len = strlen (str);
+  if (writer->sentence_length == 0)
+    return;
 
+  writer->character_count += writer->sentence_length + 1;
+  writer->sentence_length = 0;
+  ++writer->n_sentences;
+}
+
+static void
+synopsis_writer_finish (SynopsisWriter *writer)
+{
   /* Don't add ending period if the string had no length.
    *
    * This might be the case if the model had no synopsis, like those
    * having hook titles. */
-  if (len > 0)
+  if (writer->out->len > writer->out_start)
+    g_string_append_c (writer->out, '.');
+}
+
+static void
+sanitize_synopsis_into (const gchar *synopsis,
+                        GString     *out)
+{
+  const gchar *p = synopsis;
+  const gchar *pending_space = NULL;
+  const gchar *parens_unmatched_until = synopsis;
+  SynopsisWriter writer;
+
+  while (g_ascii_isspace (*p))
+    ++p;
+
+  synopsis_writer_init (&writer, out, CHARACTER_COUNT_THRESHOLD);
+
+  while (*p != '\0')
     {
-      g_autofree gchar *ending_period = g_new0 (gchar, len + 2);
+      const gchar *next = NULL;
+      gunichar c;
+
+      /* Hold on to ASCII whitespace until we see what follows it, since
+       * it would have been stripped if it was at the end of the input */
+      if (g_ascii_isspace (*p))
+        {
+          if (pending_space == NULL)
+            pending_space = p;
+
+          ++p;
+          continue;
+        }
+
+      if (pending_space != NULL)
+        {
+          if (!synopsis_writer_append (&writer, pending_space, p - pending_space, TRUE))
+            break;
 
-      strcpy (ending_period, str);
-      ending_period[len] = '.';
-      ending_period[len + 1] = '\0';
+          pending_space = NULL;
+        }
 
-      return g_steal_pointer (&ending_period);
+      if (*p == '.')
+        {
+          synopsis_writer_end_sentence (&writer);
+          ++p;
+          continue;
+        }
+
+      if (*p == '[' && (next = match_square_brackets (p)) != NULL)
+        {
+          p = next;
+          continue;
+        }
+
+      /* Parenthesized text is removed even if it straddles the point
+       * where the sentence goes over the threshold, so that has to be
+       * checked before the sentence is cut off */
+      if (*p == '(' &&
+          p >= parens_unmatched_until &&
+          (next = match_parens (p, &parens_unmatched_until)) != NULL)
+        {
+          p = next;
+          continue;
+        }
+
+      c = next_char (p, &next);
+
+      if (!synopsis_writer_append (&writer, p, next - p, is_regex_space (c)))
+        break;
+
+      p = next;
     }
 
-  return g_strdup (str);
+  /* The last sentence doesn't necessarily end with a period */
+  if (*p == '\0')
+    synopsis_writer_end_sentence (&writer);
+
+  synopsis_writer_finish (&writer);
 }
 
+/**
+ * content_feed_sanitize_synopsis:
+ * @synopsis: A synopsis from a content provider
+ *
+ * Remove citations and parenthesized text from @synopsis, trim it to
+ * the first few sentences and normalize its whitespace.
+ *
+ * Returns: (transfer full): The sanitized synopsis.
+ */
 gchar *
 content_feed_sanitize_synopsis (const gchar *synopsis)
 {
-  g_autofree gchar *stripped = strip (synopsis);
-  g_autofree gchar *square_brackets_removed = remove_square_brackets (stripped);
-  g_autofree gchar *parens_removed = remove_parens (square_brackets_removed);
-  g_autofree gchar *first_two_sentences =
-    trim_to_first_n_sentences_under_threshold (parens_removed,
-                                               CHARACTER_COUNT_THRESHOLD);
-  g_autofree gchar *normalized_whitespace = normalize_whitespace (first_two_sentences);
-  g_autofree gchar *with_ending_period = add_ending_period (normalized_whitespace);
+  GString *out = NULL;
+
+  g_return_val_if_fail (synopsis != NULL, NULL);
+
+  out = g_string_sized_new (CHARACTER_COUNT_THRESHOLD + 2);
+  sanitize_synopsis_into (synopsis, out);
+
+  return g_string_free (out, FALSE);
+}
+
+/* Counts down the workers of one call to content_feed_sanitize_synopses()
+ * that are still running */
+typedef struct _SanitizeSynopsesBatch
+{
+  GMutex lock;
+  GCond  cond;
+  guint  n_workers_running;
+} SanitizeSynopsesBatch;
+
+typedef struct _SanitizeSynopsesWorker
+{
+  SanitizeSynopsesBatch *batch;
+
+  const gchar * const *synopses;
+  gsize                n_synopses;
+
+  /* Each result is nul-terminated and starts at the corresponding
+   * offset in out */
+  GString             *out;
+  gsize               *offsets;
+} SanitizeSynopsesWorker;
+
+static gpointer
+sanitize_synopses_worker_run (gpointer user_data)
+{
+  SanitizeSynopsesWorker *worker = user_data;
+  gsize i = 0;
+
+  worker->out = g_string_sized_new (worker->n_synopses * (CHARACTER_COUNT_THRESHOLD + 2));
+  worker->offsets = g_new (gsize, worker->n_synopses);
+
+  for (; i < worker->n_synopses; ++i)
+    {
+      worker->offsets[i] = worker->out->len;
+      sanitize_synopsis_into (worker->synopses[i], worker->out);
+      g_string_append_c (worker->out, '\0');
+    }
+
+  return NULL;
+}
+
+static void
+sanitize_synopses_pool_func (gpointer data,
+                             gpointer user_data G_GNUC_UNUSED)
+{
+  SanitizeSynopsesWorker *worker = data;
+  SanitizeSynopsesBatch *batch = worker->batch;
+
+  sanitize_synopses_worker_run (worker);
+
+  g_mutex_lock (&batch->lock);
+  if (--batch->n_workers_running == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->lock);
+}
+
+/* The batches are usually sanitized from several worker threads at
+ * once, one for each provider reply, so they all share one pool of
+ * threads rather than each starting their own. The pool threads never
+ * wait on anything, so a caller waiting for its share of the pool
+ * always gets it eventually. */
+static GThreadPool *
+sanitize_synopses_pool (void)
+{
+  static gsize initialized = 0;
+  static GThreadPool *pool = NULL;
+
+  if (g_once_init_enter (&initialized))
+    {
+      pool = g_thread_pool_new (sanitize_synopses_pool_func,
+                                NULL,
+                                (gint) g_get_num_processors (),
+                                FALSE,
+                                NULL);
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return pool;
+}
+
+/**
+ * content_feed_sanitize_synopses:
+ * @synopses: (array zero-terminated=1): Synopses from a content provider
+ *
+ * Sanitize each of @synopses as content_feed_sanitize_synopsis() would.
+ * Large batches are split up across the available processors, using a
+ * thread pool shared by all callers.
+ *
+ * The array and the strings in it are allocated together as one block,
+ * so the whole result is freed with a single call to g_free(). Do not
+ * free the individual strings.
+ *
+ * Returns: (transfer container) (array zero-terminated=1): The sanitized
+ *          synopses, in the same order as @synopses.
+ */
+gchar **
+content_feed_sanitize_synopses (const gchar * const *synopses)
+{
+  gsize n_synopses = 0;
+  guint n_workers = 0;
+  g_autofree SanitizeSynopsesWorker *workers = NULL;
+  SanitizeSynopsesBatch batch;
+  gsize total_length = 0;
+  gchar **results = NULL;
+  gchar *results_strings = NULL;
+  gsize result_index = 0;
+  guint i = 0;
+
+  g_return_val_if_fail (synopses != NULL, NULL);
+
+  n_synopses = g_strv_length ((gchar **) synopses);
+  n_workers = CLAMP (n_synopses / MIN_SYNOPSES_PER_WORKER,
+                     1,
+                     (guint) g_get_num_processors ());
+  workers = g_new0 (SanitizeSynopsesWorker, n_workers);
+
+  g_mutex_init (&batch.lock);
+  g_cond_init (&batch.cond);
+  batch.n_workers_running = n_workers - 1;
+
+  for (i = 0; i < n_workers; ++i)
+    {
+      gsize start = n_synopses * i / n_workers;
+      gsize end = n_synopses * (i + 1) / n_workers;
+
+      workers[i].batch = &batch;
+      workers[i].synopses = synopses + start;
+      workers[i].n_synopses = end - start;
+    }
+
+  /* The calling thread takes the first share of the work rather than
+   * sitting idle */
+  for (i = 1; i < n_workers; ++i)
+    g_thread_pool_push (sanitize_synopses_pool (), &workers[i], NULL);
+
+  sanitize_synopses_worker_run (&workers[0]);
+
+  g_mutex_lock (&batch.lock);
+  while (batch.n_workers_running > 0)
+    g_cond_wait (&batch.cond, &batch.lock);
+  g_mutex_unlock (&batch.lock);
+
+  g_cond_clear (&batch.cond);
+  g_mutex_clear (&batch.lock);
+
+  for (i = 0; i < n_workers; ++i)
+    total_length += workers[i].out->len;
+
+  /* Pack the array and all the strings it points to together */
+  results = g_malloc ((n_synopses + 1) * sizeof (gchar *) + total_length);
+  results_strings = (gchar *) (results + n_synopses + 1);
+
+  for (i = 0; i < n_workers; ++i)
+    {
+      SanitizeSynopsesWorker *worker = &workers[i];
+      gsize j = 0;
+
+      memcpy (results_strings, worker->out->str, worker->out->len);
+
+      for (; j < worker->n_synopses; ++j)
+        results[result_index++] = results_strings + worker->offsets[j];
+
+      results_strings += worker->out->len;
+
+      g_string_free (worker->out, TRUE);
+      g_free (worker->offsets);
+    }
+
+  results[n_synopses] = NULL;
 
-  return g_steal_pointer (&with_ending_period);
+  return results;
 }
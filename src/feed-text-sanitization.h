@@ -23,4 +23,6 @@ G_BEGIN_DECLS
 
 gchar * content_feed_sanitize_synopsis (const gchar *synopsis);
 
+gchar ** content_feed_sanitize_synopses (const gchar * const *synopses);
+
 G_END_DECLS
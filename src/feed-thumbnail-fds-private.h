@@ -0,0 +1,57 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <gio/gunixfdlist.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:thumbnail-fds
+ * @title: Thumbnail File Descriptors
+ * @short_description: Thumbnails passed by providers as file descriptors
+ *
+ * Providers which implement the WithThumbnailFds variant of their
+ * method pass the thumbnail for each item as a file descriptor with
+ * the reply, and an a{sh} mapping each thumbnail URI to the index of
+ * its descriptor. A #ThumbnailFds takes ownership of the
+ * descriptors and hands each one out as a #GUnixInputStream, so the
+ * thumbnail is read straight from whatever the provider opened without
+ * any copies or shard parsing on our side.
+ *
+ * Each descriptor can only be read once, so it is handed out at most
+ * once, and closed when the stream is. Any that are never asked for are
+ * closed when the #ThumbnailFds is freed.
+ *
+ * A #ThumbnailFds is safe to use from multiple threads.
+ */
+typedef struct _ThumbnailFds ThumbnailFds;
+
+ThumbnailFds * thumbnail_fds_new (GVariant    *thumbnails,
+                                  GUnixFDList *fd_list);
+
+ThumbnailFds * thumbnail_fds_ref (ThumbnailFds *thumbnail_fds);
+void thumbnail_fds_unref (ThumbnailFds *thumbnail_fds);
+
+GInputStream * thumbnail_fds_take_stream (ThumbnailFds *thumbnail_fds,
+                                          const gchar  *thumbnail_uri);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ThumbnailFds, thumbnail_fds_unref)
+
+G_END_DECLS
@@ -0,0 +1,150 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <gio/gio.h>
+#include <gio/gunixinputstream.h>
+#include <glib/gstdio.h>
+
+#include "feed-thumbnail-fds-private.h"
+
+struct _ThumbnailFds
+{
+  volatile gint  ref_count;
+
+  /* Protects fds */
+  GMutex         lock;
+
+  /* Owned descriptors, set to -1 once handed out */
+  gint          *fds;
+  gint           n_fds;
+
+  /* Thumbnail URI to index into fds */
+  GHashTable    *handles;
+};
+
+/*
+ * thumbnail_fds_new:
+ * @thumbnails: An a{sh} #GVariant from the reply of a provider
+ * @fd_list: (nullable): The #GUnixFDList that came with the reply
+ *
+ * Create a new #ThumbnailFds, taking all of the descriptors out of
+ * @fd_list. Handles in @thumbnails which are not in @fd_list are
+ * logged and ignored.
+ *
+ * Returns: (transfer full): A new #ThumbnailFds
+ */
+ThumbnailFds *
+thumbnail_fds_new (GVariant    *thumbnails,
+                   GUnixFDList *fd_list)
+{
+  ThumbnailFds *thumbnail_fds = g_new0 (ThumbnailFds, 1);
+  GVariantIter iter;
+  const gchar *thumbnail_uri = NULL;
+  gint32 handle = 0;
+
+  thumbnail_fds->ref_count = 1;
+  g_mutex_init (&thumbnail_fds->lock);
+  thumbnail_fds->handles = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  if (fd_list != NULL)
+    thumbnail_fds->fds = g_unix_fd_list_steal_fds (fd_list, &thumbnail_fds->n_fds);
+
+  g_variant_iter_init (&iter, thumbnails);
+  while (g_variant_iter_next (&iter, "{&sh}", &thumbnail_uri, &handle))
+    {
+      if (handle < 0 || handle >= thumbnail_fds->n_fds)
+        {
+          g_message ("Thumbnail %s has handle %d, but only %d file descriptors were passed, ignoring",
+                     thumbnail_uri,
+                     handle,
+                     thumbnail_fds->n_fds);
+          continue;
+        }
+
+      g_hash_table_replace (thumbnail_fds->handles,
+                            g_strdup (thumbnail_uri),
+                            GINT_TO_POINTER (handle));
+    }
+
+  return thumbnail_fds;
+}
+
+ThumbnailFds *
+thumbnail_fds_ref (ThumbnailFds *thumbnail_fds)
+{
+  g_atomic_int_inc (&thumbnail_fds->ref_count);
+
+  return thumbnail_fds;
+}
+
+void
+thumbnail_fds_unref (ThumbnailFds *thumbnail_fds)
+{
+  gint i = 0;
+
+  if (!g_atomic_int_dec_and_test (&thumbnail_fds->ref_count))
+    return;
+
+  for (i = 0; i < thumbnail_fds->n_fds; ++i)
+    if (thumbnail_fds->fds[i] >= 0)
+      g_close (thumbnail_fds->fds[i], NULL);
+
+  g_clear_pointer (&thumbnail_fds->fds, g_free);
+  g_clear_pointer (&thumbnail_fds->handles, g_hash_table_unref);
+  g_mutex_clear (&thumbnail_fds->lock);
+
+  g_free (thumbnail_fds);
+}
+
+/*
+ * thumbnail_fds_take_stream:
+ * @thumbnail_fds: A #ThumbnailFds
+ * @thumbnail_uri: The thumbnail URI of an item
+ *
+ * Get a stream for the descriptor that was passed for @thumbnail_uri.
+ * The stream owns the descriptor, so later calls for the same
+ * descriptor return %NULL.
+ *
+ * Returns: (transfer full) (nullable): A #GInputStream for the
+ *          thumbnail, or %NULL if the provider did not pass one.
+ */
+GInputStream *
+thumbnail_fds_take_stream (ThumbnailFds *thumbnail_fds,
+                           const gchar  *thumbnail_uri)
+{
+  g_autoptr(GMutexLocker) locker = NULL;
+  gpointer handle = NULL;
+  gint fd = -1;
+
+  if (thumbnail_uri == NULL)
+    return NULL;
+
+  if (!g_hash_table_lookup_extended (thumbnail_fds->handles,
+                                     thumbnail_uri,
+                                     NULL,
+                                     &handle))
+    return NULL;
+
+  locker = g_mutex_locker_new (&thumbnail_fds->lock);
+  fd = thumbnail_fds->fds[GPOINTER_TO_INT (handle)];
+  thumbnail_fds->fds[GPOINTER_TO_INT (handle)] = -1;
+
+  if (fd < 0)
+    return NULL;
+
+  return g_unix_input_stream_new (fd, TRUE);
+}
@@ -31,6 +31,7 @@
 #include "feed-model-ordering.h"
 #include "feed-provider-info.h"
 #include "feed-provider-lookup.h"
+#include "feed-provider-registry.h"
 #include "feed-proxy-factory.h"
 #include "feed-quote-card-store.h"
 #include "feed-sizes.h"
@@ -0,0 +1,273 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "feed-provider-key-file-private.h"
+
+/* Each of these is loaded with both provider_key_file_load() and
+ * g_key_file_load_from_file(), and every provider key is read back
+ * from both, so that the purpose-built reader is held to exactly what
+ * GKeyFile would have done with the same file. The files are chosen to
+ * cover each of the rules that the reader has to reproduce. */
+static const gchar *provider_key_file_test_cases[] = {
+  /* Well-formed files */
+  "",
+  "[Discovery Feed Content Provider]\n"
+  "DesktopId=com.endlessm.animals.desktop\n"
+  "ObjectPath=/com/endlessm/animals/DiscoveryFeed\n"
+  "BusName=com.endlessm.animals\n"
+  "SupportedInterfaces=com.endlessm.DiscoveryFeedContent;com.endlessm.DiscoveryFeedNews;\n"
+  "AppID=com.endlessm.animals\n"
+  "\n"
+  "[Load Item Provider]\n"
+  "ObjectPath=/com/endlessm/animals/LoadItem\n",
+  "# A comment before the first group\n"
+  "\n"
+  "   [Discovery Feed Content Provider]   \n"
+  "  # An indented comment\n"
+  "\tBusName = com.endlessm.animals\n"
+  "ObjectPath\t=\t/com/endlessm/animals  \n",
+  "[Discovery Feed Content Provider]\r\n"
+  "BusName=com.endlessm.animals\r\n"
+  "ObjectPath=/com/endlessm/animals\r",
+  "[Discovery Feed Content Provider]\n"
+  "BusName=",
+  "[Load Item Provider]\n"
+  "ObjectPath=/com/endlessm/animals/LoadItem\n",
+
+  /* Keys which are set more than once, or in other groups */
+  "[Discovery Feed Content Provider]\n"
+  "BusName=com.endlessm.first\n"
+  "BusName=com.endlessm.second\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName=com.endlessm.first\n"
+  "[Other Group]\n"
+  "BusName=com.endlessm.other\n"
+  "[Discovery Feed Content Provider]\n"
+  "ObjectPath=/com/endlessm/second\n",
+  "[Load Item Provider]\n"
+  "BusName=com.endlessm.animals\n"
+  "[Discovery Feed Content Provider]\n"
+  "ObjectPath=/com/endlessm/animals\n",
+  "[Discovery Feed Content Provider]\n"
+  "ObjectPath[de]=/com/endlessm/tiere\n"
+  "BusName[en_US.UTF-8@euro]=com.endlessm.animals\n"
+  "AppID=com.endlessm.animals\n",
+  "[Discovery Feed Content Provider]\n"
+  "busname=com.endlessm.animals\n"
+  "Bus Name=com.endlessm.animals\n",
+
+  /* Escapes and lists */
+  "[Discovery Feed Content Provider]\n"
+  "BusName=a\\sb\\nc\\td\\re\\\\f\n"
+  "SupportedInterfaces=a;b;;c\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName=a\\;b\n"
+  "SupportedInterfaces=a\\;b;c\\sd;\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName=\\q\n"
+  "SupportedInterfaces=a;\\q\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName=trailing\\\n"
+  "SupportedInterfaces=trailing\\\n",
+  "[Discovery Feed Content Provider]\n"
+  "SupportedInterfaces=;\n"
+  "AppID=;;\n",
+  "[Discovery Feed Content Provider]\n"
+  "SupportedInterfaces=\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName=\xc3\xa9l\xc3\xa9phant\n"
+  "AppID=\xff\xfe\n",
+
+  /* Encodings */
+  "[Discovery Feed Content Provider]\n"
+  "Encoding=UTF-8\n"
+  "BusName=com.endlessm.animals\n",
+  "[Discovery Feed Content Provider]\n"
+  "Encoding=utf-8\n",
+  "[Discovery Feed Content Provider]\n"
+  "Encoding=ISO-8859-1\n",
+  "[Discovery Feed Content Provider]\n"
+  "Encoding=UTF-8 \n",
+  "[Discovery Feed Content Provider]\n"
+  "Encoding[de]=ISO-8859-1\n",
+  "[Other Group]\n"
+  "Encoding=UTF-8\n"
+  "[Discovery Feed Content Provider]\n"
+  "Encoding=ISO-8859-1\n",
+  "[Discovery Feed Content Provider]\n"
+  "[Other Group]\n"
+  "[Discovery Feed Content Provider]\n"
+  "Encoding=ISO-8859-1\n",
+
+  /* Malformed files */
+  "BusName=com.endlessm.animals\n"
+  "[Discovery Feed Content Provider]\n",
+  "# Only a comment\n"
+  "BusName=com.endlessm.animals\n",
+  "[Discovery Feed Content Provider]\n"
+  "Not a key value pair\n",
+  "[Discovery Feed Content Provider]\n"
+  "=com.endlessm.animals\n",
+  "[Discovery Feed Content Provider]\n"
+  " = com.endlessm.animals\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName[=com.endlessm.animals\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName]=com.endlessm.animals\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName[de/DE]=com.endlessm.animals\n",
+  "[Discovery Feed Content Provider]\n"
+  "BusName[de]x=com.endlessm.animals\n",
+  "[]\n",
+  "[Discovery [Feed]\n",
+  "[Discovery Feed Content Provider\n"
+  "BusName=com.endlessm.animals\n",
+  "[Discovery Feed Content Provider] trailing\n",
+  "[Discovery\tFeed]\n",
+};
+
+static void
+assert_errors_match (GError *error,
+                     GError *expected_error)
+{
+  if (expected_error == NULL)
+    {
+      g_assert_no_error (error);
+      return;
+    }
+
+  g_assert_error (error, expected_error->domain, expected_error->code);
+}
+
+static void
+assert_strvs_match (GStrv strv,
+                    GStrv expected_strv)
+{
+  guint i = 0;
+
+  if (expected_strv == NULL)
+    {
+      g_assert_null (strv);
+      return;
+    }
+
+  g_assert_nonnull (strv);
+  g_assert_cmpuint (g_strv_length (strv), ==, g_strv_length (expected_strv));
+
+  for (; expected_strv[i] != NULL; ++i)
+    g_assert_cmpstr (strv[i], ==, expected_strv[i]);
+}
+
+static void
+assert_key_matches_key_file (ProviderKeyFile *provider_key_file,
+                             GKeyFile        *key_file,
+                             ProviderKey      key)
+{
+  const gchar *section = provider_key_get_section (key);
+  const gchar *name = provider_key_get_name (key);
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GError) expected_error = NULL;
+  g_autofree gchar *string = NULL;
+  g_autofree gchar *expected_string = NULL;
+  g_auto(GStrv) strv = NULL;
+  g_auto(GStrv) expected_strv = NULL;
+
+  g_assert_cmpint (provider_key_file_has_key (provider_key_file, key),
+                   ==,
+                   g_key_file_has_key (key_file, section, name, NULL));
+
+  string = provider_key_file_get_string (provider_key_file, key, &error);
+  expected_string = g_key_file_get_string (key_file, section, name, &expected_error);
+
+  /* GKeyFile returns whatever it managed to unescape along with the
+   * error, which callers never look at */
+  assert_errors_match (error, expected_error);
+  if (expected_error == NULL)
+    g_assert_cmpstr (string, ==, expected_string);
+
+  g_clear_error (&error);
+  g_clear_error (&expected_error);
+
+  strv = provider_key_file_get_string_list (provider_key_file, key, &error);
+  expected_strv = g_key_file_get_string_list (key_file, section, name, NULL, &expected_error);
+
+  assert_errors_match (error, expected_error);
+  if (expected_error == NULL)
+    assert_strvs_match (strv, expected_strv);
+}
+
+static void
+test_provider_key_file_matches_key_file (void)
+{
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *path = NULL;
+  gint fd = g_file_open_tmp ("test-provider-key-file-XXXXXX", &path, &error);
+  gsize i = 0;
+
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+
+  for (; i < G_N_ELEMENTS (provider_key_file_test_cases); ++i)
+    {
+      g_auto(ProviderKeyFile) provider_key_file = PROVIDER_KEY_FILE_INIT;
+      g_autoptr(GKeyFile) key_file = g_key_file_new ();
+      g_autoptr(GError) load_error = NULL;
+      g_autoptr(GError) expected_load_error = NULL;
+      gboolean loaded = FALSE;
+      gboolean expected_loaded = FALSE;
+      guint key = 0;
+
+      g_test_message ("Provider file %" G_GSIZE_FORMAT ":\n%s",
+                      i,
+                      provider_key_file_test_cases[i]);
+
+      g_file_set_contents (path, provider_key_file_test_cases[i], -1, &error);
+      g_assert_no_error (error);
+
+      loaded = provider_key_file_load (&provider_key_file, path, &load_error);
+      expected_loaded = g_key_file_load_from_file (key_file,
+                                                   path,
+                                                   G_KEY_FILE_NONE,
+                                                   &expected_load_error);
+
+      assert_errors_match (load_error, expected_load_error);
+      g_assert_cmpint (loaded, ==, expected_loaded);
+
+      if (!loaded)
+        continue;
+
+      for (key = 0; key < N_PROVIDER_KEYS; ++key)
+        assert_key_matches_key_file (&provider_key_file, key_file, key);
+    }
+
+  g_unlink (path);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/provider-key-file/load/matches-key-file",
+                   test_provider_key_file_matches_key_file);
+
+  return g_test_run ();
+}
@@ -0,0 +1,273 @@
+/* Copyright 2018 Endless Mobile, Inc.
+ *
+ * libcontentfeed is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * libcontentfeed is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libcontentfeed.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "feed-text-sanitization.h"
+
+typedef struct _SanitizeSynopsisTestCase
+{
+  const gchar *synopsis;
+  const gchar *expected;
+} SanitizeSynopsisTestCase;
+
+/* The expected output for each synopsis is what the GRegex pipeline
+ * that content_feed_sanitize_synopsis() used to be made of returned
+ * for it, so that the single-pass scanner is held to exactly the same
+ * output. The synopses are chosen to cover where the meaning of \d, \s
+ * and . in those expressions is easy to get wrong. */
+static const SanitizeSynopsisTestCase sanitize_synopsis_test_cases[] = {
+  /* Whitespace, citations and parentheses */
+  { "",
+    "" },
+  { "   \t\n  ",
+    "" },
+  { "...",
+    "" },
+  { "A single sentence without a period",
+    "A single sentence without a period." },
+  { "  Leading and trailing whitespace is stripped.  \n",
+    "Leading and trailing whitespace is stripped." },
+  { "Lorem ipsum[1] dolor (sit) amet. Second sentence[23].",
+    "Lorem ipsum dolor amet. Second sentence." },
+  { "Not a citation [a1] or [] or [1 2] or [12",
+    "Not a citation [a1] or [] or [1 2] or [12." },
+  { "Runs \t\xc2\xa0 \xe2\x80\x83 of\r\n\r\nspaces.",
+    "Runs of spaces." },
+  { " \xc2\xa0Non-ASCII space at the start is kept\xc2\xa0 ",
+    " Non-ASCII space at the start is kept ." },
+  /* Unicode digits */
+  { "Arabic-Indic[\xd9\xa1\xd9\xa2] digits[\xdb\xb3] are removed.",
+    "Arabic-Indic digits are removed." },
+  { "Fullwidth[\xef\xbc\x91\xef\xbc\x92] and "
+    "Devanagari[\xe0\xa5\xa7] digits too.",
+    "Fullwidth and Devanagari digits too." },
+  { "Superscript[\xc2\xb2] and circled[\xe2\x91\xa0] are not digits.",
+    "Superscript[\xc2\xb2] and circled[\xe2\x91\xa0] are not digits." },
+  { "Mixed[1\xd9\xa2] digits.",
+    "Mixed digits." },
+  /* Unicode spaces */
+  { "No-break\xc2\xa0space "
+    "and\xe2\x80\x83" "em\xe2\x80\x82" "en\xe3\x80\x80ideographic.",
+    "No-break space and em en ideographic." },
+  { "Thin\xe2\x80\x89space,\xe2\x80\xafnarrow,\xe2\x81\x9fmedium "
+    "and\xe1\x9a\x80ogham.",
+    "Thin space, narrow, medium and ogham." },
+  { "Zero\xe2\x80\x8bwidth is not\xef\xbb\xbfspace.",
+    "Zero\xe2\x80\x8bwidth is not\xef\xbb\xbfspace." },
+  { "Mongolian\xe1\xa0\x8evowel separator.",
+    "Mongolian vowel separator." },
+  /* Line endings, which also stop parenthesized text */
+  { "Line\xe2\x80\xa8separator and paragraph\xe2\x80\xa9separator.",
+    "Line separator and paragraph separator." },
+  { "Next\xc2\x85line.",
+    "Next line." },
+  { "Parens (across a\nnewline) stay.",
+    "Parens (across a newline) stay." },
+  { "Parens (across a\xe2\x80\xa8line separator) stay.",
+    "Parens (across a line separator) stay." },
+  { "Parens (across a\xe2\x80\xa9paragraph separator) stay.",
+    "Parens (across a paragraph separator) stay." },
+  { "Parens (across a\xc2\x85next line) stay.",
+    "Parens (across a next line) stay." },
+  { "Parens (across a\r\ncarriage return) stay.",
+    "Parens (across a carriage return) stay." },
+  { "Parens (across\x0b" "a vertical tab) stay.",
+    "Parens (across a vertical tab) stay." },
+  { "Parens (across\x0c" "a form feed) stay.",
+    "Parens (across a form feed) stay." },
+  { "Parens (after a newline\n(are) removed) here.",
+    "Parens (after a newline removed) here." },
+  /* Unbalanced parentheses */
+  { "Unclosed (parenthesis at the end",
+    "Unclosed (parenthesis at the end." },
+  { "Unclosed (parenthesis. Then (closed) later.",
+    "Unclosed later." },
+  { "Stray ) closing parenthesis.",
+    "Stray ) closing parenthesis." },
+  { "Nested ((parentheses)) leave) the rest.",
+    "Nested ) leave) the rest." },
+  { "Nested (a (b) c) parentheses.",
+    "Nested c) parentheses." },
+  { "((()",
+    "" },
+  { "(Only parens)",
+    "" },
+  { "Open (one (two (three) four",
+    "Open four." },
+  { "Citation inside parens ([1]) and parens inside citation [(1)].",
+    "Citation inside parens and parens inside citation []." },
+  { "Parens (with a. period) inside.",
+    "Parens inside." },
+  { "[1](2)[3]",
+    "" },
+  /* The 160 byte threshold, which a second sentence may only reach */
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb.third.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb." },
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb.third.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa." },
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb.third.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa." },
+  /* Whitespace counts before it is normalized */
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.  "
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb. c.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa. "
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb." },
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.  "
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb. c.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa." },
+  /* Multibyte characters count in bytes */
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9.c.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9." },
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9\xc3\xa9"
+    "\xc3\xa9\xc3\xa9\xc3\xa9.c.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa." },
+  /* Removed text does not count */
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbb (xxxxxxxxxxxxxxxxxxxx)[1].c.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbb ." },
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb (xxxxxxxxxxxxxxxxxxxx)[1].c.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa." },
+  /* The first sentence is always taken, however long */
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaa. Second.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaa." },
+  { "Short. "
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaa. Third.",
+    "Short." },
+  /* Empty sentences are skipped, but their periods still count */
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaa....bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb.c",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbb.c." },
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaa....bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb.c",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb." },
+  /* Parenthesized text straddling the threshold */
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbb (xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx) end.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbb end." },
+  { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa.bbbbbbbbbbbbbbbbbbbbbbbbbbb"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbb (xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx) "
+    "end.",
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa." },
+};
+
+static void
+test_sanitize_synopsis_matches_regex_pipeline (void)
+{
+  gsize i = 0;
+
+  for (; i < G_N_ELEMENTS (sanitize_synopsis_test_cases); ++i)
+    {
+      const SanitizeSynopsisTestCase *test_case = &sanitize_synopsis_test_cases[i];
+      g_autofree gchar *sanitized = content_feed_sanitize_synopsis (test_case->synopsis);
+
+      g_assert_cmpstr (sanitized, ==, test_case->expected);
+    }
+}
+
+/* Enough copies of the test cases that the batch is split up across
+ * several threads */
+#define SANITIZE_SYNOPSES_N_COPIES 16
+
+static void
+test_sanitize_synopses_matches_sanitize_synopsis (void)
+{
+  gsize n_test_cases = G_N_ELEMENTS (sanitize_synopsis_test_cases);
+  gsize n_synopses = n_test_cases * SANITIZE_SYNOPSES_N_COPIES;
+  g_autofree const gchar **synopses = g_new0 (const gchar *, n_synopses + 1);
+  g_autofree gchar **sanitized = NULL;
+  gsize i = 0;
+
+  for (i = 0; i < n_synopses; ++i)
+    synopses[i] = sanitize_synopsis_test_cases[i % n_test_cases].synopsis;
+
+  sanitized = content_feed_sanitize_synopses (synopses);
+
+  g_assert_cmpuint (g_strv_length (sanitized), ==, n_synopses);
+
+  for (i = 0; i < n_synopses; ++i)
+    g_assert_cmpstr (sanitized[i], ==, sanitize_synopsis_test_cases[i % n_test_cases].expected);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/text-sanitization/sanitize-synopsis/matches-regex-pipeline",
+                   test_sanitize_synopsis_matches_regex_pipeline);
+  g_test_add_func ("/text-sanitization/sanitize-synopses/matches-sanitize-synopsis",
+                   test_sanitize_synopses_matches_sanitize_synopsis);
+
+  return g_test_run ();
+}